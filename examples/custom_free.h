@@ -63,7 +63,7 @@ void custom_list_free(List* parent_list)
         _ListNode* old_node = current_node;
         if (current_node->next != NULL)
             current_node = current_node->next;
-        _free_list_node(old_node);
+        _free_list_node(parent_list, old_node);
     }
     free(parent_list->jump_table);
     free(parent_list);
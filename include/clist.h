@@ -33,6 +33,8 @@ static inline int _default_less_than(LIST_DATA_TYPE a, LIST_DATA_TYPE b)
     return a < b;
 }
 #define LIST_COMPARATOR _default_less_than
+//Values are ordered by '<', so integer values can be radix sorted.  
+#define _LIST_DEFAULT_ORDER 1
 #endif
 
 //Convience option to have list items freed with the list.  
@@ -40,12 +42,41 @@ static inline int _default_less_than(LIST_DATA_TYPE a, LIST_DATA_TYPE b)
 #define FREE_LIST_ITEMS 0
 #endif
 
+//Option to compile out the NULL list, index, range and size checks of the API
+//functions, for builds that know their arguments are valid.  Memory
+//allocation failures are still reported.  
+#ifndef CLIST_NO_CHECKS
+#define CLIST_NO_CHECKS 0
+#endif
+
+//Storage layouts, selected by defining LIST_STORAGE before including clist.h.  
+//Doubly linked nodes, one value per node.  
+#define LIST_STORAGE_NODES      0
+//Doubly linked chunks of up to LIST_CHUNK_CAPACITY values (clist_unrolled.h).  
+#define LIST_STORAGE_UNROLLED   1
+//Counted B+tree with values in its leaves (clist_btree.h).  
+#define LIST_STORAGE_BTREE      2
+//Nodes in one arena per list, linked by 32 bit positions (clist_compact.h).  
+#define LIST_STORAGE_COMPACT    3
+
+#ifndef LIST_STORAGE
+#define LIST_STORAGE LIST_STORAGE_NODES
+#endif
+
 
 
 //Linked list structure. Do not modify internal contents.  
 typedef struct list list;
 //list node structure.  
 typedef struct _node _node;
+//Slab of list nodes owned by a _node_pool.  
+typedef struct _slab _slab;
+//Per-list node allocator.  
+typedef struct _node_pool _node_pool;
+//Value and node pair used while sorting.  
+typedef struct _sort_entry _sort_entry;
+//Position in a list, for walking and editing it without index lookups.  
+typedef struct list_cursor list_cursor;
 //list indexing type.  
 typedef unsigned long lindex;
 //Filter function signature.  
@@ -58,12 +89,41 @@ typedef int (*comparator_func) (LIST_DATA_TYPE, LIST_DATA_TYPE);
 //Header only function.  
 #define HOF static inline
 
+//Error reporting functions are kept out of line, off the fast path.  
+#if defined(__GNUC__)
+#define _LIST_COLD __attribute__((cold))
+#define _LIST_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define _LIST_COLD
+#define _LIST_UNLIKELY(x) (x)
+#endif
+
+//list_add_pending() and list_drain_pending() need the GNU atomic builtins.  
+#if defined(__GNUC__)
+#define _LIST_ATOMICS 1
+#else
+#define _LIST_ATOMICS 0
+#endif
+
 
 enum Constants
 {
     JT_INCREMENT = (int)1000,
     INITIAL_JT_SIZE = (unsigned)10,
+    DEFAULT_SLAB_SIZE = (unsigned)1024,
     INDEX_ERR_RETURN_VALUE = (lindex)-1,
+    JT_ALL_VALID = (lindex)-1,
+    SORT_MIN_RUN = (unsigned)32,
+    SORT_MIN_GALLOP = (unsigned)7,
+    SORT_MAX_RUNS = (unsigned)128,
+};
+
+//Return codes of list_try_get().  
+enum list_status
+{
+    LIST_OK = 0,
+    LIST_NULL_ARG = -1,
+    LIST_INDEX_OUT_OF_RANGE = -2,
 };
 
 
@@ -112,6 +172,70 @@ Otherwise, calls list_error_handler and returns ERROR_RETURN_VALUE.
 HOF LIST_DATA_TYPE
 list_get(list* l, lindex index);
 
+/*
+Returns the value at the given index, like list_get(), but without changing
+the list in any way, including the position list_get() remembers to speed up
+nearby accesses.  Any number of threads can call it at once, as long as none
+of them changes the list.  
+*/
+HOF LIST_DATA_TYPE
+list_get_const(const list* l, lindex index);
+
+/*
+Returns a pointer to the value at the given index, for reading or changing
+it in place.  The pointer is valid until the list is next changed, other than
+through list_set() or such pointers.  
+If the index is invalid, calls list_error_handler and returns NULL.  
+*/
+HOF LIST_DATA_TYPE*
+list_get_ref(list* l, lindex index);
+
+/*
+Replaces the value at the given index.  
+Calls list_error_handler if the index is out of range.  
+*/
+HOF void
+list_set(list* l, lindex index, LIST_DATA_TYPE value);
+
+/*
+Adds a zeroed value to the end of the list and returns a pointer to it, to be
+filled in place (see list_get_ref()).  
+Calls list_error_handler and returns NULL if there is a memory allocation
+error.  
+*/
+HOF LIST_DATA_TYPE*
+list_emplace_back(list* l);
+
+/*
+Stores the value at the given index in 'out' and returns LIST_OK.  Returns
+LIST_NULL_ARG if 'l' or 'out' is NULL and LIST_INDEX_OUT_OF_RANGE if the
+index is invalid, without calling list_error_handler.  
+*/
+HOF int
+list_try_get(list* l, lindex index, LIST_DATA_TYPE* out);
+
+/*
+Same as list_get(), without checking the list and the index.  Passing a NULL
+list or an invalid index is undefined behavior.  
+*/
+HOF LIST_DATA_TYPE
+list_get_unchecked(list* l, lindex index);
+
+/*
+Same as list_set(), without checking the list and the index.  Passing a NULL
+list or an invalid index is undefined behavior.  
+*/
+HOF void
+list_set_unchecked(list* l, lindex index, LIST_DATA_TYPE value);
+
+/*
+Same as list_add(), without checking the list.  Passing a NULL list is
+undefined behavior.  Calls list_error_handler if there is a memory allocation
+error.  
+*/
+HOF void
+list_add_unchecked(list* l, LIST_DATA_TYPE value);
+
 /*
 Inserts the given value at the specified index in the list.  
 Calls list_error_handler if the index is out of range.  
@@ -138,6 +262,35 @@ Sorts the given list.
 HOF void
 sort_list(list* l);
 
+/*
+Returns the index of the first value of the sorted list 'l' that is not less
+than 'value', or the list's size if there is none.  
+*/
+HOF lindex
+list_lower_bound(list* l, LIST_DATA_TYPE value);
+
+/*
+Returns the index of the first value of the sorted list 'l' that is greater
+than 'value', or the list's size if there is none.  
+*/
+HOF lindex
+list_upper_bound(list* l, LIST_DATA_TYPE value);
+
+/*
+Returns 1 if the sorted list 'l' contains a value equal to 'value'
+(neither is less than the other), 0 otherwise.  
+*/
+HOF int
+list_contains_sorted(list* l, LIST_DATA_TYPE value);
+
+/*
+Inserts 'value' into the sorted list 'l' after any values equal to it, so the
+list stays sorted, and returns its index.  Calls list_error_handler and
+returns INDEX_ERR_RETURN_VALUE on memory allocation failure.  
+*/
+HOF lindex
+list_insert_sorted(list* l, LIST_DATA_TYPE value);
+
 /*
 Returns a newly created list containing all list elements of 'l' that meet the
 requirements of the filter function.  Returns NULL on memory allocation
@@ -170,37 +323,77 @@ HOF list*
 list_split_where(list* l, filter_func filter);
 
 /*
-Adds all list elements of l1 from 'start' to 'end' to l2.  
+Removes all list elements that don't meet the requirements of the filter
+function, keeping the others in order.  
+*/
+HOF void
+list_retain(list* l, filter_func filter);
+
+/*
+Removes all list elements that meet the requirements of the filter function,
+keeping the others in order.  
+*/
+HOF void
+list_remove_where(list* l, filter_func filter);
+
+/*
+Moves all list elements of l1 from 'start' up to (not including) 'end' to the
+end of l2.  Calls list_error_handler if the range is invalid.  
 */
 HOF void
 list_add_range(list* l1, list* l2, lindex start, lindex end);
 
 /*
-Removes all list elements from 'start' to 'end'.  
+Removes all list elements from 'start' up to (not including) 'end'.  
+Calls list_error_handler if the range is invalid.  
 */
 HOF void
 list_remove_range(list* l, lindex start, lindex end);
 
 /*
-Moves all list elments of l1 from 'start' to 'end' to l2.  
+Copies all list elements of l1 from 'start' up to (not including) 'end' to
+the end of l2.  Calls list_error_handler if the range is invalid or memory
+allocation fails, in which case l2 is left unchanged.  
 */
 HOF void
 list_copy_range(list* l1, list* l2, lindex start, lindex end);
 
 /*
-Returns a copy of the given list.  
+Returns a copy of the given list, or NULL on memory allocation failure.  
 */
 HOF list*
 copy_list(list* l);
 
+#if LIST_STORAGE == LIST_STORAGE_BTREE && !FREE_LIST_ITEMS
+/*
+Returns a copy of the given list to be used as a snapshot in O(1), or NULL on
+memory allocation failure.  The two lists share every node of the tree, and a
+node is only copied once either list changes something below it.  The clone
+may be read and freed by another thread while 'l' keeps changing.  The values
+themselves are not copied.  Only available with LIST_STORAGE_BTREE, and not
+with FREE_LIST_ITEMS, since both lists would free the values they share.  
+*/
+HOF list*
+list_clone_cow(list* l);
+#elif defined(__GNUC__)
+//Other layouts can't share their storage, and lists that free their values
+//can't share those, use copy_list() with them.  
+list*
+list_clone_cow(list* l)
+__attribute__((error("list_clone_cow() needs LIST_STORAGE_BTREE without "
+                     "FREE_LIST_ITEMS, use copy_list() otherwise")));
+#endif
+
 /*
-Returns an array containing all list values.  
+Returns a newly allocated array containing all list values, in order, or NULL
+on memory allocation failure.  The caller must free the array.  
 */
 HOF LIST_DATA_TYPE*
 list_as_array(list* l);
 
 /*
-Returns a list representing the given array.  
+Returns a new list containing the 'arr_size' values of the given array, or
+NULL on memory allocation failure.  
 */
 HOF list*
 array_as_list(LIST_DATA_TYPE* arr, lindex arr_size);
@@ -213,549 +406,1960 @@ HOF err_handler_ft
 list_error_handler(err_handler_ft f);
 
 
+#if LIST_STORAGE == LIST_STORAGE_NODES
 
-/// Internal functions ///
-
-
+/// Node storage API functions ///
 
-/*
-Internal fucntion that frees memory associated with the given _node*.  
-*/
-HOF void
-_free_list_node(_node* n);
 
 /*
-Frees all memory associated with the list strucutre,
-but not the nodes (if any).  
+Returns a newly allocated list whose nodes are allocated from slabs of
+'slab_size' nodes (DEFAULT_SLAB_SIZE if 0) instead of one by one.  Removed
+nodes are recycled by later additions.  Lists created from a pooled list by
+list_split(), list_split_where() or list_where() share its pool.  
+Returns NULL if memory allocation failed.  
 */
-HOF void
-_free_list_structures(list* l);
+HOF list*
+new_pooled_list(lindex slab_size);
 
 /*
-Internal function that returns a pointer to a
-newly allocated _node structure whose value is set to the given value.  
+Releases every slab of the list's node pool that has no nodes in use.  
+Returns the number of slabs released (0 if the list is not pooled).  
 */
-HOF _node*
-_new_list_node(LIST_DATA_TYPE value);
+HOF lindex
+list_trim_pool(list* l);
 
 /*
-Internal function that modifies l's pointers to link the given node into
-l at the specified index.  
+Adds the given value to the front of the list.  Unlike list_insert(l, 0, v)
+no jump_table entries are rewritten, so this is O(1) amortized.  
+Calls list_error_handler if there is a memory allocation error.  
 */
 HOF void
-_link_node(list* l, lindex index, _node* node);
+list_push_front(list* l, LIST_DATA_TYPE value);
 
 /*
-Internal function that links the given node into the specified list as its
-first element (l->head = node, l->tail = node).  
+Removes the first value from 'l' and returns it in O(1).  
+If the list has no items to pop, calls list_error_handler and returns
+ERROR_RETURN_VALUE.  
 */
-HOF void
-_link_first(list* l, _node* node);
+HOF LIST_DATA_TYPE
+list_pop_front(list* l);
 
+#if _LIST_ATOMICS
 /*
-Internal function that links the given node into the specified list as its
-new head node.  
+Stages the given value to be added to the end of 'l' by the next call to
+list_drain_pending().  Lock-free: any number of threads may call it at once,
+also while the owning thread uses the list.  Staged values are not part of the
+list (not counted, found or sorted) until drained.  Only available with
+compilers that have the GNU __atomic builtins (GCC, Clang).  
+Calls list_error_handler if there is a memory allocation error.  
 */
 HOF void
-_link_head(list* l, _node* node);
+list_add_pending(list* l, LIST_DATA_TYPE value);
 
 /*
-Internal function that links the given node into the specified list as its
-new tail node.  
+Adds every value staged by list_add_pending() to the end of 'l', in the order
+each thread staged them, with a single jump_table update.  Only the thread
+that owns the list may call it.  Returns the number of values added.  
+Pooled lists copy the staged values into pool nodes first.  If that fails,
+calls list_error_handler and stages them again, behind any values staged in
+the meantime, and returns 0.  Only available where list_add_pending() is.  
 */
-HOF void            
-_link_tail(list* l, _node* node);
+HOF lindex
+list_drain_pending(list* l);
+#endif
 
 /*
-Internal function that links the given node into the specified list, behind
-current_node and after current_node->prev.  
+Returns a cursor on the value at the given index of 'l', or past its last
+value if 'index' is the size of the list.  Changes made to the list other
+than through the cursor itself invalidate it.  
+Calls list_error_handler if the index is out of range.  
 */
-HOF void            
-_link_middle(list* l, _node* current_node, _node* node);
+HOF list_cursor
+list_cursor_at(list* l, lindex index);
 
 /*
-Internal function that sets the next jump_table node to 'jt_entry'
-if there have been JT_INCREMENT additions since the last jump table node 
-(or this is the first node).  
+Moves the cursor to the next value.  Returns 0 once the cursor is past the
+last value, 1 otherwise.  
 */
-HOF void
-_list_add_jump_table_node(list* l, _node* jt_entry);
+HOF int
+list_cursor_next(list_cursor* c);
 
 /*
-Internal function that expands the jump_table of the given list,
-to the specified size.  
+Moves the cursor to the previous value.  Returns 0, without moving, if the
+cursor is on the first value, 1 otherwise.  
 */
-HOF void
-_list_grow_jump_table(list* l, lindex new_size);
+HOF int
+list_cursor_prev(list_cursor* c);
 
 /*
-Internal function that removes the last node of the given list
-and returns its value.  
+Returns the value under the cursor.  If the cursor is past the last value,
+calls list_error_handler and returns ERROR_RETURN_VALUE.  
 */
 HOF LIST_DATA_TYPE
-_list_pop(list* l);
+list_cursor_get(const list_cursor* c);
 
 /*
-Internal function that updates the list->current if it is equal to the
-given _node.  Updates to le->next if it is not NULL otherwise updates to
-le->prev if it is not NULL, otherwise l->current is changed to NULL.  For
-Use when removing a node.  Also ajusts the numerical position of current_index
-according to the index of the remove operation specified by 'index'.  
+Replaces the value under the cursor.  Calls list_error_handler if the cursor
+is past the last value.  
 */
 HOF void
-_update_list_current(list* l, _node* node, lindex index);
+list_cursor_set(list_cursor* c, LIST_DATA_TYPE value);
 
 /*
-Internal function that alters list structure and _node structure pointers
-to remove links to/from the given node and list.  
+Inserts the given value in front of the cursor, which stays on the same
+value.  Inserts at the end of the list if the cursor is past the last value.  
+Calls list_error_handler if there is a memory allocation error.  
 */
 HOF void
-_unlink_node(list* l, _node* node);
+list_cursor_insert_before(list_cursor* c, LIST_DATA_TYPE value);
 
 /*
-Internal function that advances every jump table node, after the given index,
-to it's ->next.  For use when removing a node.  
+Removes the value under the cursor and returns it.  The cursor moves on to the
+next value.  If the cursor is past the last value, calls list_error_handler
+and returns ERROR_RETURN_VALUE.  
 */
-HOF void
-_list_adjust_jump_table_up(list* l, lindex index);
+HOF LIST_DATA_TYPE
+list_cursor_remove_here(list_cursor* c);
+
+#endif
+
+
+
+/// Error handling ///
+
 
 /*
-Internal function that advances the jump_table node at the specified 
-table_index to its ->next, if it comes after the first index specified.  
-For use with list_remove().  
+Default error handling callback function, if one is not defined.  
+Attempts to print an error message to stderr and returns -1.  
+A user defined handler must have the same signature as the function below.  
 */
-HOF void
-_advance_jt_entry_if_affected(list* l, lindex index, lindex table_index);
+HOF int
+_default_error_handler(const char* func, const char* arg, const char* msg);
 
 /*
-Internal function that removes the last_jump_table index if it is the last node
-in the list.  Or advances that node if it comes after the index specified.  
-Does nothing if neither of the previous conditions are true.  
+Error handling wrapper to check for a NULL list.  
 */
-HOF void
-_remove_or_advance_last_jt_entry(list* l, lindex index, lindex final_jt_index);
+HOF _LIST_COLD int
+_list_null_arg_error(const list* l, const char* func);
 
 /*
-Internal function that returns the _node* at the given index.  
+Error handling wrapper to check for an out of bounds index.  
 */
-HOF _node*
-_list_pointer_at(list* l, lindex index);
+HOF _LIST_COLD int
+_list_index_error(const list* l, lindex, const char* func);
 
 /*
-Internal function that returns the node nearest to the one requested.  
-Either a jump_table node or the previouisly accessed node, l->current.  
-Sets the dist argument to the distance between the nearest node and
-the one requested.
+Error handling wrapper to check for a range that isn't within the list
+(start > end or end > size).  
 */
-HOF _node*
-_get_start_node(list* l, lindex pos, long* dist);
+HOF _LIST_COLD int
+_list_range_error(const list* l, lindex start, lindex end, const char* func);
 
 /*
-Internal function that returns the jump_table node closest to the given 
-position.  Sets the dist argument to the distance between the jump_table
-node and the one at the given index.  
+Error handling wrapper to check for list to small to be popped.  
 */
-HOF _node*
-_get_closest_jt_node(list* l, lindex pos, long* dist);
+HOF _LIST_COLD int
+_list_size_error(const list* l, const char* func);
 
 /*
-Internal function that iterates starting at the given node, 'start', until it
-reaches the node that is 'dist' nodes away.  Advances on node->prev if the
-second parameter, 'backward', is true, otherwise advances on node->next.
+Error handling wrapper to check for failed memory allocation of a new list.  
 */
-HOF _node*
-_advance_to(_node* start, const int backward, lindex dist);
+HOF _LIST_COLD int
+_list_allocation_error(const void* ptr, const char* func);
+
+
+//Error checking macros.  The checks are inlined and the reporting functions,
+//which check again and return -1, are only called once they failed.  
+#if CLIST_NO_CHECKS
+#define NULL_ARG_ERROR(l)           0
+#define INDEX_ERROR(l, index)       0
+#define RANGE_ERROR(l, start, end)  0
+#define SIZE_ERROR(l)               0
+#else
+#define NULL_ARG_ERROR(l)                                                     \
+    (_LIST_UNLIKELY(!(l)) ? (_list_null_arg_error(l, __func__), -1) : 0)
+#define INDEX_ERROR(l, index)                                                 \
+    (_LIST_UNLIKELY((index) >= (l)->size) ?                                   \
+        (_list_index_error(l, index, __func__), -1) : 0)
+#define RANGE_ERROR(l, start, end)                                            \
+    (_LIST_UNLIKELY((start) > (end) || (end) > (l)->size) ?                   \
+        (_list_range_error(l, start, end, __func__), -1) : 0)
+#define SIZE_ERROR(l)                                                         \
+    (_LIST_UNLIKELY((l)->size < 1) ? (_list_size_error(l, __func__), -1) : 0)
+#endif
+#define ALLOC_ERROR(ptr)                                                      \
+    (_LIST_UNLIKELY(!(ptr)) ? _list_allocation_error(ptr, __func__) : 0)
+
+
+
+/// Shared internal functions ///
+
 
 /*
-Internal function that inserts the given node 
-at the specified location in the list.  
+Internal function that performs a stable natural mergesort on 'values'
+using 'tmp' (of the same length) as scratch space.  
 */
 HOF void
-_list_insert(list* l, lindex index, _node* new_node);
+_merge_sort_values(LIST_DATA_TYPE* values, LIST_DATA_TYPE* tmp, lindex n);
 
 /*
-Internal function that deadvances every jump table node, after the given index,
-to it's ->prev.  For use when inserting a node.  
+Internal function that returns the index of the first value of the sorted
+list that 'value' goes before.  Values equal to 'value' come first if 'upper'
+is true.  
 */
-HOF void
-_list_adjust_jump_table_down(list* l, lindex index);
+HOF lindex
+_list_bound(list* l, LIST_DATA_TYPE value, int upper);
 
 /*
-Internal function that advances the jump_table node at the specified 
-table_index to its ->prev if it comes after the first index specified.  
-For use with list_insert().  
+Internal function that removes values from the end of the list until it has
+'size' values, without freeing them.  
 */
 HOF void
-_deadvance_jt_entry_if_affected(list* l, lindex index, lindex table_index);
+_list_truncate(list* l, lindex size);
 
 /*
-Internal function that removes the _node at the given index
-from the list and returns its value.  
+Internal function that returns a pointer to the value at 'index' and
+remembers its position to speed up nearby accesses, as list_get() does.  
 */
-HOF LIST_DATA_TYPE
-_list_remove(list* l, _node* node, lindex index);
+HOF LIST_DATA_TYPE*
+_list_ref_at(list* l, lindex index);
 
 /*
-Internal function that preforms a space optimized mergesort on the given list,
-represented by the provided head node.  
-Returns the new head node of the sorted list.  
+Internal function that returns a pointer through which the value at 'index'
+may be changed, as _list_ref_at() does.  With LIST_STORAGE_BTREE, nodes on
+its path that are shared with clones are copied first, and NULL is returned
+if that fails.  
 */
-HOF _node*
-_merge_sort_list(_node* current_head, lindex sublist_size);
+HOF LIST_DATA_TYPE*
+_list_mut_ref_at(list* l, lindex index);
 
 /*
-Internal function that appends to a chain of other nodes.  
+Internal function that adds the given value to the end of the list.  
+Calls list_error_handler if there is a memory allocation error.  
 */
 HOF void
-_append(_node** head, _node** tail, _node* next);
+_list_add(list* l, LIST_DATA_TYPE value);
 
+#if LIST_STORAGE != LIST_STORAGE_NODES
 /*
-Internal function that reassignes all jump_table nodes after 
-(index / JT_INCREMENT) by iterating starting from the given node 
-(assumed to be at the specified index).  Returns the final node iterated to.  
+Internal function that adds the 'count' values of 'values' to the end of the
+list.  Returns 0, or -1 and calls list_error_handler if there is a memory
+allocation error, leaving the list as it was.  
 */
-HOF _node*
-_reassign_jump_table(list* l, lindex index, _node* node);
+HOF int
+_list_append_values(list* l, LIST_DATA_TYPE* values, lindex count);
 
 /*
-Internal function that adds all values of the original list,
-that pass the filter, to the new list.  
+Internal function that adds the values of 'from' between 'start' and 'end'
+to the end of 'to', which may be 'from' itself.  Returns 0, or -1 and calls
+list_error_handler if there is a memory allocation error, leaving 'to' as it
+was.  
+*/
+HOF int
+_list_copy_values(list* from, list* to, lindex start, lindex end);
+
+/*
+Internal function that removes the values between 'start' and 'end' and
+repairs the jump_table (if any) once, freeing the values if 'free_items' is
+set.  
 */
 HOF void
-_add_filtered_values_to_new_list(list* l, list* nl, filter_func filter);
+_list_erase(list* l, lindex start, lindex end, int free_items);
 
 /*
-Internal function that adds a range of connected nodes, starting at 'start'
-and ending at 'end' and of length 'size'.  
+Internal function that keeps only the values for which 'filter' returns
+'keep' (true or false), in order, freeing the others if FREE_LIST_ITEMS is
+set.  
 */
 HOF void
-_add_range(list* l, _node* start, _node* end, lindex size);
+_list_retain(list* l, filter_func filter, int keep);
 
 /*
-Internal function that appends to the given list, a series of connected nodes, 
-starting with the 'start' and ending with 'end'.  Does not affect jump table.  
+Internal function that copies every value of the list, in order, to
+'values', which must have room for all of them.  
 */
 HOF void
-_link_range(list* l, _node* start, _node* end);
+_list_read_values(list* l, LIST_DATA_TYPE* values);
+#endif
 
 /*
-Internal function that puts all nodes that come after 'index' in 'nl'
-and leaves the remaining nodes in 'l'.  
+Defines 'name'(values, tmp, n), a stable natural mergesort of 'n' values of
+type 'type' ordered by 'less', using 'tmp' (of the same length) as scratch
+space.  Ascending and strictly descending runs already in the values are
+kept and merged TimSort-style, with galloping, so presorted values take
+linear time.  Short runs are extended to SORT_MIN_RUN with insertion sort.  
 */
-HOF list*
-_list_split(list* l, list* nl, lindex index);
+#define _DEFINE_NATURAL_MERGE_SORT(name, type, less)                          \
+                                                                              \
+/* Number of the first 'n' values of 'a' that go before 'key', either         \
+   the values less than it or, if 'upper', those not greater than it. */      \
+static inline lindex                                                          \
+name##_gallop(type const* a, lindex n, type const* key, int upper)            \
+{                                                                             \
+    lindex known = 0, probe = 0, step = 1;                                    \
+    while (probe < n && (upper ? !less(*key, a[probe]) : less(a[probe], *key))) \
+    {                                                                         \
+        known = probe + 1;                                                    \
+        probe += step;                                                        \
+        step *= 2;                                                            \
+    }                                                                         \
+    lindex hi = probe < n ? probe : n;                                        \
+    while (known < hi)                                                        \
+    {                                                                         \
+        lindex mid = known + (hi - known) / 2;                                \
+        if (upper ? !less(*key, a[mid]) : less(a[mid], *key))                 \
+            known = mid + 1;                                                  \
+        else                                                                  \
+            hi = mid;                                                         \
+    }                                                                         \
+    return known;                                                             \
+}                                                                             \
+                                                                              \
+/* Merges the adjacent sorted runs a[0, na) and a[na, na + nb). */            \
+static inline void                                                            \
+name##_merge(type* a, lindex na, lindex nb, type* tmp)                        \
+{                                                                             \
+    type* b = a + na;                                                         \
+    /* Values already in their final place are left alone. */                 \
+    lindex skip = name##_gallop(a, na, &b[0], 1);                             \
+    a += skip;                                                                \
+    na -= skip;                                                               \
+    if (na == 0)                                                              \
+        return;                                                               \
+    nb = name##_gallop(b, nb, &a[na-1], 0);                                   \
+                                                                              \
+    memcpy(tmp, a, na * sizeof(type));                                        \
+    lindex i = 0, j = 0, k = 0;                                               \
+    while (i < na && j < nb)                                                  \
+    {                                                                         \
+        unsigned a_wins = 0, b_wins = 0;                                      \
+        while (i < na && j < nb                                               \
+               && a_wins < SORT_MIN_GALLOP && b_wins < SORT_MIN_GALLOP)       \
+        {                                                                     \
+            if (less(b[j], tmp[i]))                                           \
+            {                                                                 \
+                a[k++] = b[j++];                                              \
+                ++b_wins;                                                     \
+                a_wins = 0;                                                   \
+            }                                                                 \
+            else                                                              \
+            {                                                                 \
+                a[k++] = tmp[i++];                                            \
+                ++a_wins;                                                     \
+                b_wins = 0;                                                   \
+            }                                                                 \
+        }                                                                     \
+        if (i == na || j == nb)                                               \
+            break;                                                            \
+                                                                              \
+        /* One run keeps winning, so move whole blocks of it at once. */      \
+        lindex count = name##_gallop(tmp + i, na - i, &b[j], 1);              \
+        memcpy(a + k, tmp + i, count * sizeof(type));                         \
+        k += count;                                                           \
+        i += count;                                                           \
+        if (i == na)                                                          \
+            break;                                                            \
+        count = name##_gallop(b + j, nb - j, &tmp[i], 0);                     \
+        memmove(a + k, b + j, count * sizeof(type));                          \
+        k += count;                                                           \
+        j += count;                                                           \
+    }                                                                         \
+    /* What is left of the second run is already in place. */                 \
+    memcpy(a + k, tmp + i, (na - i) * sizeof(type));                          \
+}                                                                             \
+                                                                              \
+static inline void                                                            \
+name(type* values, type* tmp, lindex n)                                       \
+{                                                                             \
+    lindex run_start[SORT_MAX_RUNS];                                          \
+    lindex run_len[SORT_MAX_RUNS];                                            \
+    unsigned runs = 0;                                                        \
+    lindex lo = 0;                                                            \
+    while (lo < n)                                                            \
+    {                                                                         \
+        lindex hi = lo + 1;                                                   \
+        if (hi < n && less(values[hi], values[lo]))                           \
+        {                                                                     \
+            /* Reversing a strictly descending run keeps the sort stable. */  \
+            for (++hi; hi < n && less(values[hi], values[hi-1]); ++hi);       \
+            lindex x = lo, y = hi - 1;                                        \
+            for (; x < y; ++x, --y)                                           \
+            {                                                                 \
+                type swap = values[x];                                        \
+                values[x] = values[y];                                        \
+                values[y] = swap;                                             \
+            }                                                                 \
+        }                                                                     \
+        else                                                                  \
+        {                                                                     \
+            for (; hi < n && !less(values[hi], values[hi-1]); ++hi);          \
+        }                                                                     \
+                                                                              \
+        if (hi - lo < SORT_MIN_RUN && hi < n)                                 \
+        {                                                                     \
+            lindex end = lo + SORT_MIN_RUN < n ? lo + SORT_MIN_RUN : n;       \
+            for (; hi < end; ++hi)                                            \
+            {                                                                 \
+                type v = values[hi];                                          \
+                lindex x = hi;                                                \
+                for (; x > lo && less(v, values[x-1]); --x)                   \
+                    values[x] = values[x-1];                                  \
+                values[x] = v;                                                \
+            }                                                                 \
+        }                                                                     \
+        run_start[runs] = lo;                                                 \
+        run_len[runs++] = hi - lo;                                            \
+        lo = hi;                                                              \
+                                                                              \
+        /* Keep run lengths growing down the stack, as TimSort does, so       \
+           merges stay balanced.  All runs are merged once 'n' is reached. */ \
+        while (runs > 1)                                                      \
+        {                                                                     \
+            unsigned r = runs - 2;                                            \
+            if ((r > 0 && run_len[r-1] <= run_len[r] + run_len[r+1])          \
+                || (r > 1 && run_len[r-2] <= run_len[r-1] + run_len[r]))      \
+            {                                                                 \
+                if (run_len[r-1] < run_len[r+1])                              \
+                    --r;                                                      \
+            }                                                                 \
+            else if (lo < n && run_len[r] > run_len[r+1])                     \
+                break;                                                        \
+            else if (lo == n && r > 0 && run_len[r-1] < run_len[r+1])         \
+                --r;                                                          \
+                                                                              \
+            name##_merge(values + run_start[r], run_len[r], run_len[r+1], tmp); \
+            run_len[r] += run_len[r+1];                                       \
+            for (++r; r + 1 < runs; ++r)                                      \
+            {                                                                 \
+                run_start[r] = run_start[r+1];                                \
+                run_len[r] = run_len[r+1];                                    \
+            }                                                                 \
+            --runs;                                                           \
+        }                                                                     \
+    }                                                                         \
+}
+
+
+
+#if LIST_STORAGE == LIST_STORAGE_UNROLLED
+#include "clist_unrolled.h"
+#elif LIST_STORAGE == LIST_STORAGE_BTREE
+#include "clist_btree.h"
+#elif LIST_STORAGE == LIST_STORAGE_COMPACT
+#include "clist_compact.h"
+#else
+
+/// Internal functions ///
+
+
 
 /*
-Internal function that cuts off the list at the given index and node.  
-Invalidates jump table entries after the index.  
+Internal fucntion that frees memory associated with the given _node*,
+or returns it to the list's node pool.  
 */
 HOF void
-_list_chop(list* l, _node* new_tail, lindex new_tail_index);
+_free_list_node(list* l, _node* n);
 
 /*
-Internal function that NULLs out all of the list's jump table entries
+Frees all memory associated with the list strucutre,
+but not the nodes (if any).  
+*/
+HOF void
+_free_list_structures(list* l);
+
+/*
+Internal function that returns a pointer to a
+newly allocated _node structure whose value is set to the given value.  
+Takes the node from the list's pool if it has one.  
+*/
+HOF _node*
+_new_list_node(list* l, LIST_DATA_TYPE value);
+
+/*
+Internal function that returns a newly allocated node pool with slabs of
+'slab_size' nodes, or NULL on allocation failure.  
+*/
+HOF _node_pool*
+_new_node_pool(lindex slab_size);
+
+/*
+Internal function that hands out a node from the pool, reusing a released
+node if possible, otherwise carving one from the newest slab.  
+*/
+HOF _node*
+_pool_alloc(_node_pool* pool);
+
+/*
+Internal function that returns the given node to the pool's free list.  
+*/
+HOF void
+_pool_release(_node_pool* pool, _node* node);
+
+/*
+Internal function that drops the list's reference to its pool, freeing the
+pool and all of its slabs if it was the last one.  
+*/
+HOF void
+_list_release_pool(list* l);
+
+/*
+Internal function that moves all slabs and free nodes of 'from' into 'pool'
+and frees 'from'.  
+*/
+HOF void
+_pool_absorb(_node_pool* pool, _node_pool* from);
+
+/*
+qsort() comparator that orders slab pointers by address.  
+*/
+HOF int
+_slab_address_cmp(const void* a, const void* b);
+
+/*
+Internal function that returns the position, in the address ordered 'slabs'
+array, of the slab containing the given node.  
+*/
+HOF lindex
+_find_slab(_slab** slabs, lindex slab_count, const _node* node);
+
+/*
+Internal function that returns a new empty list that allocates its nodes the
+same way as 'l' (sharing its pool, if any).  
+*/
+HOF list*
+_new_sibling_list(list* l);
+
+/*
+Internal function that makes every node of 'from' owned by the allocator of
+'l' so they can be linked into 'l'.  Lists sharing a pool need no work, an
+unshared pool is absorbed whole, otherwise the nodes are replaced by copies.  
+Returns -1 on allocation failure ('from' is left untouched), 0 otherwise.  
+*/
+HOF int
+_list_take_nodes(list* l, list* from);
+
+/*
+Internal function that modifies l's pointers to link the given node into
+l at the specified index.  
+*/
+HOF void
+_link_node(list* l, lindex index, _node* node);
+
+/*
+Internal function that links the given node into the specified list as its
+first element (l->head = node, l->tail = node).  
+*/
+HOF void
+_link_first(list* l, _node* node);
+
+/*
+Internal function that links the given node into the specified list as its
+new head node.  
+*/
+HOF void
+_link_head(list* l, _node* node);
+
+/*
+Internal function that links the given node into the specified list as its
+new tail node.  
+*/
+HOF void            
+_link_tail(list* l, _node* node);
+
+/*
+Internal function that links the given node into the specified list, behind
+current_node and after current_node->prev.  
+*/
+HOF void            
+_link_middle(list* l, _node* current_node, _node* node);
+
+/*
+Internal function that sets the next jump_table node to 'jt_entry'
+if there have been JT_INCREMENT additions since the last jump table node 
+(or this is the first node).  
+*/
+HOF void
+_list_add_jump_table_node(list* l, _node* jt_entry);
+
+/*
+Internal function that expands the jump_table of the given list,
+to the specified size.  
+*/
+HOF void
+_list_grow_jump_table(list* l, lindex new_size);
+
+/*
+Internal function that doubles the jump_table by adding empty entries in front
+of the existing ones, so list_push_front() can move jt_offset back.  
+Returns -1 on allocation failure, 0 otherwise.  
+*/
+HOF int
+_list_grow_jump_table_front(list* l);
+
+/*
+Internal function that moves the jump_table entries down over the entries
+left empty in front of the list by list_pop_front().  
+*/
+HOF void
+_list_compact_jump_table(list* l);
+
+/*
+Internal function that marks every jump_table entry at or after the given
+index as out of date.  For use by cursors, which edit the list without
+adjusting the table.  
+*/
+HOF void
+_list_invalidate_jump_table(list* l, lindex index);
+
+/*
+Internal function that brings the jump_table entries before 'table_end' up to
+date by walking from the last valid entry.  
+*/
+HOF void
+_list_repair_jump_table(list* l, lindex table_end);
+
+/*
+Internal function that returns the jump_table entry for the given index.  
+Entry i refers to the node at index i * JT_INCREMENT - l->jt_offset.  
+*/
+HOF lindex
+_jt_entry_of(const list* l, lindex index);
+
+/*
+Internal function that returns the index of the node referred to by the given
+jump_table entry.  Negative for entries in front of the list.  
+*/
+HOF long
+_jt_index_of(const list* l, lindex table_index);
+
+/*
+Internal function that removes the last node of the given list
+and returns its value.  
+*/
+HOF LIST_DATA_TYPE
+_list_pop(list* l);
+
+/*
+Internal function that updates the list->current if it is equal to the
+given _node.  Updates to le->next if it is not NULL otherwise updates to
+le->prev if it is not NULL, otherwise l->current is changed to NULL.  For
+Use when removing a node.  Also ajusts the numerical position of current_index
+according to the index of the remove operation specified by 'index'.  
+*/
+HOF void
+_update_list_current(list* l, _node* node, lindex index);
+
+/*
+Internal function that alters list structure and _node structure pointers
+to remove links to/from the given node and list.  
+*/
+HOF void
+_unlink_node(list* l, _node* node);
+
+/*
+Internal function that advances every jump table node, after the given index,
+to it's ->next.  For use when removing a node.  
+*/
+HOF void
+_list_adjust_jump_table_up(list* l, lindex index);
+
+/*
+Internal function that advances the jump_table node at the specified 
+table_index to its ->next, if it comes after the first index specified.  
+For use with list_remove().  
+*/
+HOF void
+_advance_jt_entry_if_affected(list* l, lindex index, lindex table_index);
+
+/*
+Internal function that removes the last_jump_table index if it is the last node
+in the list.  Or advances that node if it comes after the index specified.  
+Does nothing if neither of the previous conditions are true.  
+*/
+HOF void
+_remove_or_advance_last_jt_entry(list* l, lindex index, lindex final_jt_index);
+
+/*
+Internal function that returns the _node* at the given index.  
+*/
+HOF _node*
+_list_pointer_at(list* l, lindex index);
+
+/*
+Internal function that returns the node nearest to the one requested.  
+Either a jump_table node or the previouisly accessed node, l->current.  
+Sets the dist argument to the distance between the nearest node and
+the one requested.
+*/
+HOF _node*
+_get_start_node(list* l, lindex pos, long* dist);
+
+/*
+Internal function that returns the node at the given index without changing
+the list.  Starts from the closest of the up to date jump_table nodes around
+the index, the head and the tail.  
+*/
+HOF _node*
+_list_pointer_at_const(const list* l, lindex index);
+
+/*
+Internal function that returns the jump_table node closest to the given 
+position.  Sets the dist argument to the distance between the jump_table
+node and the one at the given index.  
+*/
+HOF _node*
+_get_closest_jt_node(list* l, lindex pos, long* dist);
+
+/*
+Internal function that iterates starting at the given node, 'start', until it
+reaches the node that is 'dist' nodes away.  Advances on node->prev if the
+second parameter, 'backward', is true, otherwise advances on node->next.
+*/
+HOF _node*
+_advance_to(_node* start, const int backward, lindex dist);
+
+/*
+Internal function that inserts the given node 
+at the specified location in the list.  
+*/
+HOF void
+_list_insert(list* l, lindex index, _node* new_node);
+
+/*
+Internal function that deadvances every jump table node, after the given index,
+to it's ->prev.  For use when inserting a node.  
+*/
+HOF void
+_list_adjust_jump_table_down(list* l, lindex index);
+
+/*
+Internal function that advances the jump_table node at the specified 
+table_index to its ->prev if it comes after the first index specified.  
+For use with list_insert().  
+*/
+HOF void
+_deadvance_jt_entry_if_affected(list* l, lindex index, lindex table_index);
+
+/*
+Internal function that removes the _node at the given index
+from the list and returns its value.  
+*/
+HOF LIST_DATA_TYPE
+_list_remove(list* l, _node* node, lindex index);
+
+/*
+Internal function that preforms a space optimized mergesort on the given list,
+represented by the provided head node.  
+Returns the new head node of the sorted list.  
+*/
+HOF _node*
+_merge_sort_list(_node* current_head, lindex sublist_size);
+
+/*
+Internal function that performs a stable natural mergesort on 'entries'
+by value, using 'tmp' (of the same length) as scratch space.  
+*/
+HOF void
+_merge_sort_entries(_sort_entry* entries, _sort_entry* tmp, lindex n);
+
+/*
+Internal function that relinks the list's nodes in the order of 'entries'
+and rebuilds the jump table and current_index to match.  
+*/
+HOF void
+_relink_sorted(list* l, const _sort_entry* entries);
+
+/*
+Internal function that does the part of _relink_sorted() for the nodes of
+'entries' from index 'from' up to (not including) 'to'.  Ranges that don't
+overlap can be relinked concurrently.  
+*/
+HOF void
+_relink_sorted_range(list* l, const _sort_entry* entries,
+                     lindex from, lindex to);
+
+/*
+Internal function that sets the head and tail of a list relinked by
+_relink_sorted_range() and clears out of date jump table entries.  
+*/
+HOF void
+_finish_relink(list* l, const _sort_entry* entries);
+
+/*
+Internal functions that map a value to an unsigned key of 'bits' bits
+whose unsigned order is the value order.  
+*/
+HOF unsigned long long
+_radix_key_signed(long long value, unsigned bits);
+
+HOF unsigned long long
+_radix_key_unsigned(unsigned long long value, unsigned bits);
+
+HOF unsigned long long
+_radix_key_char(char value, unsigned bits);
+
+HOF unsigned long long
+_radix_key_none(LIST_DATA_TYPE value, unsigned bits);
+
+/*
+Internal function that performs a stable LSD radix sort on 'entries'
+by value, using 'tmp' (of the same length) as scratch space.  
+Byte positions that are the same for every value are skipped.  
+*/
+HOF void
+_radix_sort_entries(_sort_entry* entries, _sort_entry* tmp, lindex n);
+
+//sort_list radix sorts integer values when they are ordered by '<'.  
+#if defined(_LIST_DEFAULT_ORDER) && defined(__STDC_VERSION__) \
+    && __STDC_VERSION__ >= 201112L
+//Radix key of an integer value, selected by its type.  
+#define _RADIX_KEY(v) _Generic((v),                                        \
+    _Bool: _radix_key_unsigned, char: _radix_key_char,                     \
+    signed char: _radix_key_signed, unsigned char: _radix_key_unsigned,    \
+    short: _radix_key_signed, unsigned short: _radix_key_unsigned,         \
+    int: _radix_key_signed, unsigned: _radix_key_unsigned,                 \
+    long: _radix_key_signed, unsigned long: _radix_key_unsigned,           \
+    long long: _radix_key_signed, unsigned long long: _radix_key_unsigned, \
+    default: _radix_key_none)((v), 8 * sizeof(LIST_DATA_TYPE))
+//Whether sort_list can radix sort, known at compile time.  
+#define _RADIX_SORTABLE _Generic(*(LIST_DATA_TYPE*)0,                    \
+    _Bool: 1, char: 1, signed char: 1, unsigned char: 1,                 \
+    short: 1, unsigned short: 1, int: 1, unsigned: 1,                    \
+    long: 1, unsigned long: 1, long long: 1, unsigned long long: 1,      \
+    default: 0)
+#else
+#define _RADIX_KEY(v) _radix_key_none((v), 0)
+#define _RADIX_SORTABLE 0
+#endif
+
+/*
+Internal function that appends to a chain of other nodes.  
+*/
+HOF void
+_append(_node** head, _node** tail, _node* next);
+
+/*
+Internal function that reassignes all jump_table nodes after 
+(index / JT_INCREMENT) by iterating starting from the given node 
+(assumed to be at the specified index).  Returns the final node iterated to.  
+*/
+HOF _node*
+_reassign_jump_table(list* l, lindex index, _node* node);
+
+/*
+Internal function that adds all values of the original list,
+that pass the filter, to the new list.  
+*/
+HOF void
+_add_filtered_values_to_new_list(list* l, list* nl, filter_func filter);
+
+/*
+Internal function that adds a range of connected nodes, starting at 'start'
+and ending at 'end' and of length 'size'.  
+*/
+HOF void
+_add_range(list* l, _node* start, _node* end, lindex size);
+
+/*
+Internal function that appends to the given list, a series of connected nodes, 
+starting with the 'start' and ending with 'end'.  Does not affect jump table.  
+*/
+HOF void
+_link_range(list* l, _node* start, _node* end);
+
+/*
+Internal function that puts all nodes that come after 'index' in 'nl'
+and leaves the remaining nodes in 'l'.  
+*/
+HOF list*
+_list_split(list* l, list* nl, lindex index);
+
+/*
+Internal function that cuts off the list at the given index and node.  
+Invalidates jump table entries after the index.  
+*/
+HOF void
+_list_chop(list* l, _node* new_tail, lindex new_tail_index);
+
+/*
+Internal function that NULLs out all of the list's jump table entries
 after the given index.  
 */
 HOF void
-_remove_invalid_jt_entries(list* l, lindex index);
+_remove_invalid_jt_entries(list* l, lindex index);
+
+/*
+Internal function that sets the structure of a list to the given head,
+tail and size.  
+*/
+HOF void
+_list_set_new(list* l, _node* head, _node* tail, lindex size);
+
+/*
+Internal function that puts all of the first list's values that pass the filter
+into the new list and leaves all others in the first list.  
+*/
+HOF list*
+_list_split_where(list* l, list* nl, filter_func filter);
+
+/*
+Internal function that unlinks every node whose value passes the filter, if
+'matching' is true, or fails it otherwise, in one pass.  The remaining nodes
+are relinked in order and the jump_table is rebuilt.  Returns the unlinked
+nodes as a chain, ending with 'last' and of length 'count', or NULL if there
+are none.  
+*/
+HOF _node*
+_list_partition(list* l, filter_func filter, int matching,
+                _node** last, lindex* count);
+
+/*
+Internal function that removes and frees every node whose value passes the
+filter, if 'matching' is true, or fails it otherwise.  
+*/
+HOF void
+_list_remove_partition(list* l, filter_func filter, int matching);
+
+/*
+Internal functiont hat moves the _node from  the first list 
+to the second.  Avoids the calls to free and alloc of list_add()
+and list_remove().  If the lists allocate from different pools
+the value is moved into a node from the second list's allocator.  
+*/
+HOF void
+_move_node(list* l1, list* l2, _node* node, lindex node_index);
+
+/*
+Internal function that unlinks a range of connected nodes from the given list.  
+The range begins with 'start' and ends with 'end'.  
+*/
+HOF void
+_unlink_range(list* l, _node* start, _node* end);
+
+/*
+Internal function that unlinks the 'count' nodes beginning with 'first', at
+index 'start', from the list and returns 'first' as the head of a separate
+chain whose last node is stored in 'last'.  Marks the jump_table entries from
+'start' on as out of date instead of adjusting them.  
+*/
+HOF _node*
+_list_detach_range(list* l, _node* first, lindex start, lindex count,
+                   _node** last);
+
+/*
+Internal function that copies the values of the 'count' nodes beginning with
+'node' into a chain of new nodes from the allocator of 'l', and returns its
+head with its last node stored in 'last'.  Returns NULL, with nothing
+allocated, on allocation failure.  
+*/
+HOF _node*
+_copy_chain(list* l, const _node* node, lindex count, _node** last);
+
+/*
+Internal function that frees every node of the chain beginning with 'node',
+as nodes of the given list.  
+*/
+HOF void
+_free_chain(list* l, _node* node);
+
+#if _LIST_ATOMICS
+/*
+Internal function that atomically pushes the chain from 'first' to 'last'
+(linked by next) onto the list's pending stack.  
+*/
+HOF void
+_push_pending(list* l, _node* first, _node* last);
+#endif
+
+
+
+struct _node
+{
+    LIST_DATA_TYPE value;
+    struct _node* next;
+    struct _node* prev;
+};
+
+struct _slab
+{
+    _slab*   next;
+    lindex   used;
+    lindex   capacity;
+    _node    nodes[];
+};
+
+struct _node_pool
+{
+    _slab*   slabs;
+    _node*   free_nodes;
+    lindex   slab_size;
+    lindex   slab_count;
+    lindex   refs;
+};
+
+struct list
+{
+    lindex   size;
+    lindex   jt_size;
+    lindex   current_index;
+    //Moves the index of every jump_table entry, for O(1) front operations.  
+    lindex   jt_offset;
+    //First jump_table entry that may be out of date, or JT_ALL_VALID.  
+    lindex   jt_stale_from;
+    _node*   head;
+    _node*   tail;
+    _node**  jump_table;
+    _node*   current;
+    _node_pool* pool;
+    //Values staged by list_add_pending(), newest first.  Always heap nodes.  
+    _node*   pending;
+};
+
+struct list_cursor
+{
+    list*    l;
+    _node*   node;
+    lindex   index;
+};
+
+//A node and a copy of its value, so sorting compares contiguous memory.  
+struct _sort_entry
+{
+    LIST_DATA_TYPE value;
+    _node*   node;
+};
+
+
+
+static inline list*
+new_list(void)
+{
+    //Allocate list struct.  
+    list* l = (list*)calloc(1, sizeof(list));
+    if (!l) return NULL;
+
+    //Allocate jump table.  
+    l->jump_table = (_node**)calloc(INITIAL_JT_SIZE, sizeof(_node*));
+    if (!l->jump_table)
+    {
+        free(l);
+        return NULL;
+    }
+    l->jt_size = INITIAL_JT_SIZE;
+    l->jt_stale_from = JT_ALL_VALID;
+
+    return l;
+}
+
+
+static inline list*
+new_pooled_list(lindex slab_size)
+{
+    list* l = new_list();
+    if (!l) return NULL;
+
+    l->pool = _new_node_pool(slab_size ? slab_size : DEFAULT_SLAB_SIZE);
+    if (!l->pool)
+    {
+        _free_list_structures(l);
+        return NULL;
+    }
+
+    return l;
+}
+
+
+static inline void
+free_list(list* l)
+{
+    if (!l) return;
+
+    //Nodes of an unshared pool are released along with its slabs.  
+    const int free_nodes = !(l->pool && l->pool->refs == 1);
+    if (FREE_LIST_ITEMS || free_nodes)
+    {
+        _node* current = l->head;
+        lindex i;
+        for (i = 0; i < l->size; ++i) 
+        {
+            #if FREE_LIST_ITEMS
+                free(current->value);
+            #endif
+
+            _node* next = current->next;
+            if (free_nodes)
+                _free_list_node(l, current);
+            current = next;
+        }
+    }
+
+    _node* pending = l->pending;
+    while (pending != NULL)
+    {
+        #if FREE_LIST_ITEMS
+            free(pending->value);
+        #endif
+
+        _node* next = pending->next;
+        free(pending);
+        pending = next;
+    }
+
+    _free_list_structures(l);
+}
+
+
+static inline void
+list_add(list* l, LIST_DATA_TYPE value)
+{
+    if (NULL_ARG_ERROR(l)) return;
+
+    _list_add(l, value);
+}
+
+
+static inline LIST_DATA_TYPE
+list_pop(list* l)
+{
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (SIZE_ERROR(l)) return ERROR_RETURN_VALUE;
+
+    return _list_pop(l);
+}
+
+
+#define set_list_current(l, n, i) l->current = n; l->current_index = i
+static inline LIST_DATA_TYPE
+list_get(list* l, lindex index)
+{ 
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (INDEX_ERROR(l, index)) return ERROR_RETURN_VALUE;
+
+    return *_list_ref_at(l, index);
+}
+
+
+static inline LIST_DATA_TYPE
+list_get_const(const list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (INDEX_ERROR(l, index)) return ERROR_RETURN_VALUE;
+
+    return _list_pointer_at_const(l, index)->value;
+}
+
+
+static inline LIST_DATA_TYPE*
+list_get_ref(list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    if (INDEX_ERROR(l, index)) return NULL;
+
+    return _list_ref_at(l, index);
+}
+
+
+static inline void
+list_insert(list* l, lindex index, LIST_DATA_TYPE value)
+{
+    if (NULL_ARG_ERROR(l)) return;
+    if (l->size != 0)
+        if (INDEX_ERROR(l, index)) return;
+
+    _node* new_node = _new_list_node(l, value);
+    if (ALLOC_ERROR(new_node)) return;
+    _list_insert(l, index, new_node);
+}
+
+
+static inline LIST_DATA_TYPE
+list_remove(list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (INDEX_ERROR(l, index)) return ERROR_RETURN_VALUE;
+
+    return _list_remove(l, _list_pointer_at(l, index), index);
+}
+
+
+static inline lindex
+list_size(const list* l)
+{
+    if (NULL_ARG_ERROR(l)) return INDEX_ERR_RETURN_VALUE;
+
+    return l->size;
+}
+
+
+static inline void
+sort_list(list* l)
+{
+    if (NULL_ARG_ERROR(l)) return;
+
+    if (l->size == 0) return;
+
+    _sort_entry* entries = (_sort_entry*)malloc(2 * l->size * sizeof(_sort_entry));
+    if (!entries)
+    {
+        //Fall back to sorting the nodes in place.  
+        l->head = _merge_sort_list(l->head, 1);
+        l->tail = _reassign_jump_table(l, 0, l->head);
+        return;
+    }
+
+    lindex i = 0;
+    int sorted = 1;
+    _node* current = l->head;
+    for (; current != NULL; current = current->next, ++i)
+    {
+        entries[i].value = current->value;
+        entries[i].node = current;
+        if (i > 0 && LIST_COMPARATOR(current->value, entries[i-1].value))
+            sorted = 0;
+    }
+    if (sorted)
+    {
+        free(entries);
+        return;
+    }
+
+    if (_RADIX_SORTABLE)
+        _radix_sort_entries(entries, entries + l->size, l->size);
+    else
+        _merge_sort_entries(entries, entries + l->size, l->size);
+    _relink_sorted(l, entries);
+    free(entries);
+}
+
+
+static inline list*
+list_where(list* l, filter_func filter)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    list* new_collection = _new_sibling_list(l);
+    if (ALLOC_ERROR(new_collection)) return NULL;
+
+    _add_filtered_values_to_new_list(l, new_collection, filter);
+    return new_collection;
+}
+
+
+static inline void
+list_merge(list* first, list* second)
+{
+    if (NULL_ARG_ERROR(first)) return;
+    if (second == NULL) return;
+#if _LIST_ATOMICS
+    list_drain_pending(second);
+#endif
+    if (second->size == 0) return;
+    if (_list_take_nodes(first, second))
+    {
+        ALLOC_ERROR(NULL);
+        return;
+    }
+
+    _add_range(first, second->head, second->tail, second->size);
+    _free_list_structures(second);
+}
+
+
+static inline list*
+list_split(list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    if (INDEX_ERROR(l, index)) return NULL;
+    if (index == 0)
+        return _new_sibling_list(l);
+
+    list* new_l = _new_sibling_list(l);
+    if (ALLOC_ERROR(new_l)) return NULL;
+
+    return _list_split(l, new_l, index);
+}
+
+
+static inline list*
+list_split_where(list* l, filter_func filter)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    list* nl = _new_sibling_list(l);
+    if (ALLOC_ERROR(nl)) return NULL;
 
-/*
-Internal function that sets the structure of a list to the given head,
-tail and size.  
-*/
-HOF void
-_list_set_new(list* l, _node* head, _node* tail, lindex size);
+    return _list_split_where(l, nl, filter);
+}
 
-/*
-Internal function that puts all of the first list's values that pass the filter
-into the new list and leaves all others in the first list.  
-*/
-HOF list*
-_list_split_where(list* l, list* nl, filter_func filter);
 
-/*
-Internal functiont hat moves the _node from  the first list 
-to the second.  Avoids the calls to free and alloc of list_add()
-and list_remove().  
-*/
-HOF void
-_move_node(list* l1, list* l2, _node* node, lindex node_index);
+static inline void
+list_retain(list* l, filter_func filter)
+{
+    if (NULL_ARG_ERROR(l)) return;
+    _list_remove_partition(l, filter, 0);
+}
 
-/*
-Internal function that unlinks a range of connected nodes from the given list.  
-The range begins with 'start' and ends with 'end'.  
-*/
-HOF void
-_unlink_range(list* l, _node* start, _node* end);
 
-/*
-Default error handling callback function, if one is not defined.  
-Attempts to print an error message to stderr and returns -1.  
-A user defined handler must have the same signature as the function below.  
-*/
-HOF int
-_default_error_handler(const char* func, const char* arg, const char* msg);
+static inline void
+list_remove_where(list* l, filter_func filter)
+{
+    if (NULL_ARG_ERROR(l)) return;
+    _list_remove_partition(l, filter, 1);
+}
 
-/*
-Error handling wrapper to check for a NULL list.  
-*/
-HOF int
-_list_null_arg_error(const list* l, const char* func);
 
-/*
-Error handling wrapper to check for an out of bounds index.  
-*/
-HOF int
-_list_index_error(const list* l, lindex, const char* func);
+static inline void
+list_add_range(list* l1, list* l2, lindex start, lindex end)
+{
+    if (NULL_ARG_ERROR(l1) || NULL_ARG_ERROR(l2)) return;
+    if (RANGE_ERROR(l1, start, end)) return;
+    if (start == end) return;
+
+    lindex count = end - start;
+    _node* first = _list_pointer_at(l1, start);
+    _node* last;
+    if (l1->pool == l2->pool)
+    {
+        first = _list_detach_range(l1, first, start, count, &last);
+        _add_range(l2, first, last, count);
+        return;
+    }
 
-/*
-Error handling wrapper to check for list to small to be popped.  
-*/
-HOF int
-_list_size_error(const list* l, const char* func);
+    //Nodes can only be linked into lists sharing their allocator.  
+    _node* copy = _copy_chain(l2, first, count, &last);
+    if (ALLOC_ERROR(copy)) return;
+    _node* copy_last = last;
+    _free_chain(l1, _list_detach_range(l1, first, start, count, &last));
+    _add_range(l2, copy, copy_last, count);
+}
 
-/*
-Error handling wrapper to check for failed memory allocation of a new list.  
-*/
-HOF int
-_list_allocation_error(const void* ptr, const char* func);
 
+static inline void
+list_remove_range(list* l, lindex start, lindex end)
+{
+    if (NULL_ARG_ERROR(l)) return;
+    if (RANGE_ERROR(l, start, end)) return;
+    if (start == end) return;
+
+    _node* last;
+    _node* node = _list_pointer_at(l, start);
+    node = _list_detach_range(l, node, start, end - start, &last);
 
-//Error checking macros.  
-#define NULL_ARG_ERROR(l)           _list_null_arg_error(l, __func__)
-#define INDEX_ERROR(l, index)       _list_index_error(l, index, __func__)
-#define SIZE_ERROR(l)               _list_size_error(l, __func__)
-#define ALLOC_ERROR(ptr)            _list_allocation_error(ptr, __func__)
+    #if FREE_LIST_ITEMS
+        _node* current;
+        for (current = node; current != NULL; current = current->next)
+            free(current->value);
+    #endif
+    _free_chain(l, node);
+}
 
 
-struct _node
+static inline void
+list_copy_range(list* l1, list* l2, lindex start, lindex end)
 {
-    LIST_DATA_TYPE value;
-    struct _node* next;
-    struct _node* prev;
-};
+    if (NULL_ARG_ERROR(l1) || NULL_ARG_ERROR(l2)) return;
+    if (RANGE_ERROR(l1, start, end)) return;
+    if (start == end) return;
+
+    _node* last;
+    _node* copy = _copy_chain(l2, _list_pointer_at(l1, start), end - start, &last);
+    if (ALLOC_ERROR(copy)) return;
+    _add_range(l2, copy, last, end - start);
+}
 
-struct list
+
+static inline list*
+copy_list(list* l)
 {
-    lindex   size;
-    lindex   jt_size;
-    lindex   current_index;
-    _node*   head;
-    _node*   tail;
-    _node**  jump_table;
-    _node*   current;
-};
+    if (NULL_ARG_ERROR(l)) return NULL;
+    list* nl = _new_sibling_list(l);
+    if (ALLOC_ERROR(nl)) return NULL;
+    if (l->size == 0) return nl;
+
+    _node* last;
+    _node* copy = _copy_chain(nl, l->head, l->size, &last);
+    if (ALLOC_ERROR(copy))
+    {
+        free_list(nl);
+        return NULL;
+    }
+    _list_set_new(nl, copy, last, l->size);
+    return nl;
+}
+
+
+static inline LIST_DATA_TYPE*
+list_as_array(list* l)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+
+    //At least one element, so an empty list isn't mistaken for a failure.  
+    LIST_DATA_TYPE* arr =
+        (LIST_DATA_TYPE*)malloc((l->size ? l->size : 1) * sizeof(LIST_DATA_TYPE));
+    if (ALLOC_ERROR(arr)) return NULL;
 
+    lindex i = 0;
+    _node* current = l->head;
+    for (; current != NULL; current = current->next)
+        arr[i++] = current->value;
+    return arr;
+}
 
 
 static inline list*
-new_list(void)
+array_as_list(LIST_DATA_TYPE* arr, lindex arr_size)
 {
-    //Allocate list struct.  
-    list* l = (list*)calloc(1, sizeof(list));
-    if (!l) return NULL;
-
-    //Allocate jump table.  
-    l->jump_table = (_node**)calloc(INITIAL_JT_SIZE, sizeof(_node*));
-    if (!l->jump_table)
+    list* l = new_list();
+    if (ALLOC_ERROR(l)) return NULL;
+    if (arr_size == 0) return l;
+    if (ALLOC_ERROR(arr))
     {
-        free(l);
+        free_list(l);
         return NULL;
     }
-    l->jt_size = INITIAL_JT_SIZE;
 
+    //Allocate every node first so a failure leaves nothing behind.  
+    _node* head = NULL;
+    _node* tail = NULL;
+    lindex i = 0;
+    for (; i < arr_size; ++i)
+    {
+        _node* node = _new_list_node(l, arr[i]);
+        if (ALLOC_ERROR(node))
+        {
+            if (tail)
+                tail->next = NULL;
+            _free_chain(l, head);
+            free_list(l);
+            return NULL;
+        }
+        _append(&head, &tail, node);
+    }
+    _list_set_new(l, head, tail, arr_size);
     return l;
 }
 
 
-static inline void
-free_list(list* l)
+static inline lindex
+list_trim_pool(list* l)
 {
-    if (!l) return;
+    if (NULL_ARG_ERROR(l)) return 0;
+    if (!l->pool || !l->pool->slabs) return 0;
+    _node_pool* pool = l->pool;
+
+    //Sort slabs by address so each free node's slab can be found by bsearch.  
+    _slab** slabs = (_slab**)malloc(pool->slab_count * sizeof(_slab*));
+    lindex* n_free = (lindex*)calloc(pool->slab_count, sizeof(lindex));
+    if (ALLOC_ERROR(slabs) || ALLOC_ERROR(n_free))
+    {
+        free(slabs);
+        free(n_free);
+        return 0;
+    }
 
-    _node* current = l->head;
-    lindex i;
-    for (i = 0; i < l->size; ++i) 
+    lindex i = 0;
+    _slab* s;
+    for (s = pool->slabs; s != NULL; s = s->next)
+        slabs[i++] = s;
+    qsort(slabs, pool->slab_count, sizeof(_slab*), _slab_address_cmp);
+
+    //Count the free nodes of each slab.  
+    _node* n;
+    for (n = pool->free_nodes; n != NULL; n = n->next)
+        ++n_free[_find_slab(slabs, pool->slab_count, n)];
+
+    //Idle slabs are marked by setting their capacity to 0.  
+    lindex released = 0;
+    for (i = 0; i < pool->slab_count; ++i)
     {
-        #if FREE_LIST_ITEMS
-            free(current->value);
-        #endif
+        if (n_free[i] == slabs[i]->used)
+        {
+            slabs[i]->capacity = 0;
+            ++released;
+        }
+    }
+
+    if (released > 0)
+    {
+        //Drop free nodes that belong to idle slabs.  
+        _node** link = &pool->free_nodes;
+        while (*link != NULL)
+        {
+            if (slabs[_find_slab(slabs, pool->slab_count, *link)]->capacity == 0)
+                *link = (*link)->next;
+            else
+                link = &(*link)->next;
+        }
 
-        _node* next = current->next;
-        _free_list_node(current);
-        current = next;
+        _slab** slab_link = &pool->slabs;
+        while (*slab_link != NULL)
+        {
+            _slab* current = *slab_link;
+            if (current->capacity == 0)
+            {
+                *slab_link = current->next;
+                free(current);
+            }
+            else
+                slab_link = &current->next;
+        }
+        pool->slab_count -= released;
     }
 
-    _free_list_structures(l);
+    free(slabs);
+    free(n_free);
+    return released;
 }
 
 
 static inline void
-list_add(list* l, LIST_DATA_TYPE value)
+list_push_front(list* l, LIST_DATA_TYPE value)
 {
     if (NULL_ARG_ERROR(l)) return;
-    _node* le = _new_list_node(value);
+    if (l->jt_offset == 0 && _list_grow_jump_table_front(l))
+    {
+        ALLOC_ERROR(NULL);
+        return;
+    }
+    _node* le = _new_list_node(l, value);
     if (ALLOC_ERROR(le)) return;
 
-    _link_node(l, l->size, le);
-    _list_add_jump_table_node(l, l->tail);
+    if (l->size == 0)
+        _link_first(l, le);
+    else
+        _link_head(l, le);
+
+    //Every index moves up by one, which moving the offset back accounts for
+    //without touching the entries themselves.  
+    --(l->jt_offset);
+    if (l->jt_offset % JT_INCREMENT == 0)
+        l->jump_table[l->jt_offset / JT_INCREMENT] = le;
+
+    if (l->current)
+        ++(l->current_index);
     ++(l->size);
 }
 
 
 static inline LIST_DATA_TYPE
-list_pop(list* l)
+list_pop_front(list* l)
 {
     if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
     if (SIZE_ERROR(l)) return ERROR_RETURN_VALUE;
 
-    return _list_pop(l);
+    _node* former_head = l->head;
+    LIST_DATA_TYPE value = former_head->value;
+
+    _update_list_current(l, former_head, 0);
+    if (l->jt_offset % JT_INCREMENT == 0)
+        l->jump_table[l->jt_offset / JT_INCREMENT] = NULL;
+    _unlink_node(l, former_head);
+
+    ++(l->jt_offset);
+    --(l->size);
+
+    _free_list_node(l, former_head);
+    return value;
+}
+
+
+#if _LIST_ATOMICS
+static inline void
+list_add_pending(list* l, LIST_DATA_TYPE value)
+{
+    if (NULL_ARG_ERROR(l)) return;
+    //Never from the pool, which is not thread safe.  
+    _node* le = (_node*)calloc(1, sizeof(_node));
+    if (ALLOC_ERROR(le)) return;
+
+    le->value = value;
+    _push_pending(l, le, le);
+}
+
+
+static inline lindex
+list_drain_pending(list* l)
+{
+    if (NULL_ARG_ERROR(l)) return INDEX_ERR_RETURN_VALUE;
+    //The whole stack is taken at once, so pushes never race a pop (no ABA).  
+    _node* stack = __atomic_exchange_n(&l->pending, NULL, __ATOMIC_ACQUIRE);
+    if (stack == NULL) return 0;
+
+    lindex count = 1;
+    _node* bottom = stack;
+    while (bottom->next != NULL)
+    {
+        bottom = bottom->next;
+        ++count;
+    }
+
+    if (l->pool)
+    {
+        _node* last;
+        _node* copy = _copy_chain(l, stack, count, &last);
+        if (!copy)
+        {
+            _push_pending(l, stack, bottom);
+            ALLOC_ERROR(NULL);
+            return 0;
+        }
+        while (stack != NULL)
+        {
+            _node* next = stack->next;
+            free(stack);
+            stack = next;
+        }
+        stack = copy;
+    }
+
+    //Reverse the stack into the order the values were staged in.  
+    _node* head = NULL;
+    _node* tail = stack;
+    while (stack != NULL)
+    {
+        _node* next = stack->next;
+        stack->next = head;
+        if (head)
+            head->prev = stack;
+        head = stack;
+        stack = next;
+    }
+    head->prev = NULL;
+
+    _add_range(l, head, tail, count);
+    return count;
+}
+#endif
+
+
+static inline list_cursor
+list_cursor_at(list* l, lindex index)
+{
+    list_cursor c = {NULL, NULL, 0};
+    if (NULL_ARG_ERROR(l)) return c;
+    if (index != l->size && INDEX_ERROR(l, index)) return c;
+
+    c.l = l;
+    c.index = index;
+    if (index < l->size)
+        c.node = _list_pointer_at(l, index);
+    return c;
+}
+
+
+static inline int
+list_cursor_next(list_cursor* c)
+{
+    if (NULL_ARG_ERROR(c ? c->l : NULL)) return 0;
+    if (!c->node) return 0;
+
+    c->node = c->node->next;
+    ++(c->index);
+    return c->node != NULL;
+}
+
+
+static inline int
+list_cursor_prev(list_cursor* c)
+{
+    if (NULL_ARG_ERROR(c ? c->l : NULL)) return 0;
+    if (c->index == 0) return 0;
+
+    c->node = c->node ? c->node->prev : c->l->tail;
+    --(c->index);
+    return 1;
 }
 
 
-#define set_list_current(l, n, i) l->current = n; l->current_index = i
 static inline LIST_DATA_TYPE
-list_get(list* l, lindex index)
-{ 
-    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
-    if (INDEX_ERROR(l, index)) return ERROR_RETURN_VALUE;
+list_cursor_get(const list_cursor* c)
+{
+    if (NULL_ARG_ERROR(c ? c->l : NULL)) return ERROR_RETURN_VALUE;
+    if (INDEX_ERROR(c->l, c->index)) return ERROR_RETURN_VALUE;
+
+    return c->node->value;
+}
+
+
+static inline void
+list_cursor_set(list_cursor* c, LIST_DATA_TYPE value)
+{
+    if (NULL_ARG_ERROR(c ? c->l : NULL)) return;
+    if (INDEX_ERROR(c->l, c->index)) return;
+
+    c->node->value = value;
+}
+
 
+static inline void
+list_cursor_insert_before(list_cursor* c, LIST_DATA_TYPE value)
+{
+    if (NULL_ARG_ERROR(c ? c->l : NULL)) return;
+    list* l = c->l;
+    _node* le = _new_list_node(l, value);
+    if (ALLOC_ERROR(le)) return;
+
+    if (l->size == 0)
+        _link_first(l, le);
+    else if (!c->node)
+        _link_tail(l, le);
+    else if (c->node == l->head)
+        _link_head(l, le);
+    else
+        _link_middle(l, c->node, le);
+
+    //Entries after the cursor are fixed up by the next lookup that needs
+    //them, so streaming inserts don't walk the table each time.  
+    if (c->index < l->size)
+        _list_invalidate_jump_table(l, c->index);
+    _list_add_jump_table_node(l, l->tail);
+
+    if (l->current && l->current_index >= c->index)
+        ++(l->current_index);
+    ++(l->size);
+    ++(c->index);
+}
+
+
+static inline LIST_DATA_TYPE
+list_cursor_remove_here(list_cursor* c)
+{
+    if (NULL_ARG_ERROR(c ? c->l : NULL)) return ERROR_RETURN_VALUE;
+    if (INDEX_ERROR(c->l, c->index)) return ERROR_RETURN_VALUE;
+    list* l = c->l;
+    _node* node = c->node;
+    LIST_DATA_TYPE value = node->value;
+
+    _update_list_current(l, node, c->index);
+    _unlink_node(l, node);
+    _list_invalidate_jump_table(l, c->index);
+    --(l->size);
+
+    c->node = node->next;
+    _free_list_node(l, node);
+    return value;
+}
+
+
+static inline LIST_DATA_TYPE*
+_list_ref_at(list* l, lindex index)
+{
     _node* node = _list_pointer_at(l, index);
     set_list_current(l, node, index);
-    return node->value;
+    return &node->value;
+}
+
+
+static inline void
+_list_add(list* l, LIST_DATA_TYPE value)
+{
+    _node* le = _new_list_node(l, value);
+    if (ALLOC_ERROR(le)) return;
+
+    _link_node(l, l->size, le);
+    _list_add_jump_table_node(l, l->tail);
+    ++(l->size);
 }
 
 
 static inline void
-list_insert(list* l, lindex index, LIST_DATA_TYPE value)
+_free_list_node(list* l, _node* le)
 {
-    if (NULL_ARG_ERROR(l)) return;
-    if (l->size != 0)
-        if (INDEX_ERROR(l, index)) return;
-
-    _node* new_node = _new_list_node(value);
-    _list_insert(l, index, new_node);
+    le->next = NULL;
+    le->prev = NULL;
+    if (l->pool)
+        _pool_release(l->pool, le);
+    else
+        free(le);
 }
 
 
-static inline LIST_DATA_TYPE
-list_remove(list* l, lindex index)
+static inline void
+_free_list_structures(list* l)
 {
-    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
-    if (INDEX_ERROR(l, index)) return ERROR_RETURN_VALUE;
-
-    return _list_remove(l, _list_pointer_at(l, index), index);
+    _list_release_pool(l);
+    free(l->jump_table);
+    l->jump_table = NULL;
+    l->head = NULL;
+    l->tail = NULL;
+    free(l);
 }
 
 
-static inline lindex
-list_size(const list* l)
+static inline _node*
+_new_list_node(list* l, LIST_DATA_TYPE value)
 {
-    if (NULL_ARG_ERROR(l)) return INDEX_ERR_RETURN_VALUE;
+    _node* new_le = l->pool ? _pool_alloc(l->pool) :
+                              (_node*)calloc(1, sizeof(_node));
+    if (!new_le) return NULL;
 
-    return l->size;
+    new_le->value = value;
+    new_le->next = NULL;
+    new_le->prev = NULL;
+    return new_le;
 }
 
 
-static inline void
-sort_list(list* l)
+static inline _node_pool*
+_new_node_pool(lindex slab_size)
 {
-    if (NULL_ARG_ERROR(l)) return;
+    _node_pool* pool = (_node_pool*)calloc(1, sizeof(_node_pool));
+    if (!pool) return NULL;
 
-    if (l->size == 0) return;
-    l->head = _merge_sort_list(l->head, 1);
-    l->tail = _reassign_jump_table(l, 0, l->head);
+    pool->slab_size = slab_size;
+    pool->refs = 1;
+    return pool;
 }
 
 
-static inline list*
-list_where(list* l, filter_func filter)
+static inline _node*
+_pool_alloc(_node_pool* pool)
 {
-    if (NULL_ARG_ERROR(l)) return NULL;
-    list* new_collection = new_list();
-    if (ALLOC_ERROR(l)) return NULL;
+    if (pool->free_nodes)
+    {
+        _node* recycled = pool->free_nodes;
+        pool->free_nodes = recycled->next;
+        return recycled;
+    }
 
-    _add_filtered_values_to_new_list(l, new_collection, filter);
-    return new_collection;
+    //Newest slab is always at the front of the slab list.  
+    if (!pool->slabs || pool->slabs->used == pool->slabs->capacity)
+    {
+        _slab* s = (_slab*)malloc(sizeof(_slab) +
+                                  pool->slab_size * sizeof(_node));
+        if (!s) return NULL;
+
+        s->used = 0;
+        s->capacity = pool->slab_size;
+        s->next = pool->slabs;
+        pool->slabs = s;
+        ++(pool->slab_count);
+    }
+
+    return &pool->slabs->nodes[pool->slabs->used++];
 }
 
 
 static inline void
-list_merge(list* first, list* second)
+_pool_release(_node_pool* pool, _node* node)
 {
-    if (NULL_ARG_ERROR(first)) return;
-    if (second == NULL || second->size == 0) return;
-
-    _add_range(first, second->head, second->tail, second->size);
-    _free_list_structures(second);
+    node->next = pool->free_nodes;
+    pool->free_nodes = node;
 }
 
 
-static inline list*
-list_split(list* l, lindex index)
+static inline void
+_list_release_pool(list* l)
 {
-    if (NULL_ARG_ERROR(l)) return NULL;
-    if (INDEX_ERROR(l, index)) return NULL;
-    if (index == 0)
-        return new_list();
-
-    list* new_l = new_list();
-    if (ALLOC_ERROR(new_l)) return NULL;
+    _node_pool* pool = l->pool;
+    l->pool = NULL;
+    if (!pool || --(pool->refs) > 0) return;
 
-    return _list_split(l, new_l, index);
+    while (pool->slabs)
+    {
+        _slab* next = pool->slabs->next;
+        free(pool->slabs);
+        pool->slabs = next;
+    }
+    free(pool);
 }
 
 
-static inline list*
-list_split_where(list* l, filter_func filter)
+static inline void
+_pool_absorb(_node_pool* pool, _node_pool* from)
 {
-    if (NULL_ARG_ERROR(l)) return NULL;
-    list* nl = new_list();
-    if (ALLOC_ERROR(nl)) return NULL;
+    //Absorbed slabs go behind the newest slab so it stays the one carved from.  
+    if (from->slabs)
+    {
+        _slab* last = from->slabs;
+        while (last->next)
+            last = last->next;
 
-    return _list_split_where(l, nl, filter);
+        if (pool->slabs)
+        {
+            last->next = pool->slabs->next;
+            pool->slabs->next = from->slabs;
+        }
+        else
+        {
+            last->next = NULL;
+            pool->slabs = from->slabs;
+        }
+    }
+
+    if (from->free_nodes)
+    {
+        _node* last = from->free_nodes;
+        while (last->next)
+            last = last->next;
+        last->next = pool->free_nodes;
+        pool->free_nodes = from->free_nodes;
+    }
+
+    pool->slab_count += from->slab_count;
+    free(from);
 }
 
 
-static inline err_handler_ft
-list_error_handler(err_handler_ft f)
+static inline int
+_slab_address_cmp(const void* a, const void* b)
 {
-    static err_handler_ft handler = _default_error_handler;
-    if (f != NULL)
-        handler = f;
-    return handler;
+    const _slab* sa = *(const _slab* const*)a;
+    const _slab* sb = *(const _slab* const*)b;
+    return (sa > sb) - (sa < sb);
 }
 
 
-
-static inline void
-_free_list_node(_node* le)
+static inline lindex
+_find_slab(_slab** slabs, lindex slab_count, const _node* node)
 {
-    le->next = NULL;
-    le->prev = NULL;
-    free(le);
+    lindex lo = 0, hi = slab_count;
+    while (hi - lo > 1)
+    {
+        lindex mid = lo + (hi - lo) / 2;
+        if ((const char*)slabs[mid] <= (const char*)node)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
 }
 
 
-static inline void
-_free_list_structures(list* l)
+static inline list*
+_new_sibling_list(list* l)
 {
-    free(l->jump_table);
-    l->jump_table = NULL;
-    l->head = NULL;
-    l->tail = NULL;
-    free(l);
+    list* nl = new_list();
+    if (!nl) return NULL;
+
+    nl->pool = l->pool;
+    if (nl->pool)
+        ++(nl->pool->refs);
+    return nl;
 }
 
 
-static inline _node*
-_new_list_node(LIST_DATA_TYPE value)
+static inline int
+_list_take_nodes(list* l, list* from)
 {
-    _node* new_le = (_node*)calloc(1, sizeof(_node));
-    if (!new_le) return NULL;
+    if (l->pool == from->pool) return 0;
 
-    new_le->value = value;
-    return new_le;
+    if (l->pool && from->pool && from->pool->refs == 1)
+    {
+        _pool_absorb(l->pool, from->pool);
+        from->pool = NULL;
+        from->current = NULL;
+        return 0;
+    }
+
+    //Allocate every copy first so a failure leaves 'from' as it was.  
+    _node* tail;
+    _node* head = _copy_chain(l, from->head, from->size, &tail);
+    if (!head) return -1;
+    _free_chain(from, from->head);
+
+    from->head = head;
+    from->tail = tail;
+    from->current = NULL;
+    return 0;
 }
 
 
@@ -816,13 +2420,20 @@ _link_middle(list* l, _node* current_node, _node* node)
 static inline void
 _list_add_jump_table_node(list* l, _node* jt_entry)
 {
-    //Check if more space is needed in the jump_table.  
-    lindex largest_required_jt_entry_index = l->size / JT_INCREMENT;
+    //Check if more space is needed in the jump_table.  Entries emptied by
+    //list_pop_front() are reused before the table is grown.  
+    lindex largest_required_jt_entry_index = _jt_entry_of(l, l->size);
     if (largest_required_jt_entry_index > l->jt_size-1)
-        _list_grow_jump_table(l, l->jt_size * 2);
+    {
+        if (l->jt_offset / JT_INCREMENT >= l->jt_size / 2)
+            _list_compact_jump_table(l);
+        else
+            _list_grow_jump_table(l, l->jt_size * 2);
+        largest_required_jt_entry_index = _jt_entry_of(l, l->size);
+    }
 
     //Check if new node is needed.  
-    if (l->size % JT_INCREMENT == 0)
+    if ((l->size + l->jt_offset) % JT_INCREMENT == 0)
         l->jump_table[largest_required_jt_entry_index] = jt_entry;
 }
 
@@ -842,6 +2453,95 @@ _list_grow_jump_table(list* l, lindex new_size)
 }
 
 
+static inline int
+_list_grow_jump_table_front(list* l)
+{
+    _node** new_table = (_node**)calloc(sizeof(_node*), l->jt_size * 2);
+    if (!new_table) return -1;
+
+    memcpy(&new_table[l->jt_size], l->jump_table, l->jt_size * sizeof(_node*));
+    free(l->jump_table);
+    l->jump_table = new_table;
+    l->jt_offset += l->jt_size * JT_INCREMENT;
+    if (l->jt_stale_from != JT_ALL_VALID)
+        l->jt_stale_from += l->jt_size;
+    l->jt_size *= 2;
+    return 0;
+}
+
+
+static inline void
+_list_compact_jump_table(list* l)
+{
+    lindex empty = l->jt_offset / JT_INCREMENT;
+    memmove(l->jump_table, &l->jump_table[empty],
+            (l->jt_size - empty) * sizeof(_node*));
+    memset(&l->jump_table[l->jt_size - empty], 0, empty * sizeof(_node*));
+    l->jt_offset -= empty * JT_INCREMENT;
+    if (l->jt_stale_from != JT_ALL_VALID)
+        l->jt_stale_from = l->jt_stale_from > empty ? l->jt_stale_from - empty : 0;
+}
+
+
+static inline void
+_list_invalidate_jump_table(list* l, lindex index)
+{
+    lindex first_affected = (index + l->jt_offset + JT_INCREMENT - 1) / JT_INCREMENT;
+    if (first_affected < l->jt_stale_from)
+        l->jt_stale_from = first_affected;
+}
+
+
+static inline void
+_list_repair_jump_table(list* l, lindex table_end)
+{
+    if (table_end > l->jt_size)
+        table_end = l->jt_size;
+    if (l->jt_stale_from >= table_end) return;
+
+    //Out of date entries are never read, the walk starts from the last valid
+    //entry or the head.  
+    lindex i = l->jt_stale_from;
+    _node* current = l->head;
+    long index = 0;
+    if (i > 0 && l->jump_table[i-1] != NULL)
+    {
+        current = l->jump_table[i-1];
+        index = _jt_index_of(l, i-1);
+    }
+
+    for (; i < table_end; ++i)
+    {
+        long jt_index = _jt_index_of(l, i);
+        if (jt_index < 0 || jt_index >= (long)l->size)
+        {
+            l->jump_table[i] = NULL;
+            continue;
+        }
+
+        for (; index < jt_index; ++index)
+            current = current->next;
+        l->jump_table[i] = current;
+    }
+
+    l->jt_stale_from = table_end == l->jt_size ? JT_ALL_VALID : table_end;
+}
+
+
+static inline lindex
+_jt_entry_of(const list* l, lindex index)
+{
+    return (index + l->jt_offset) / JT_INCREMENT;
+}
+
+
+static inline long
+_jt_index_of(const list* l, lindex table_index)
+{
+    return (long)(table_index * JT_INCREMENT) - (long)l->jt_offset;
+}
+
+
 static inline LIST_DATA_TYPE
 _list_pop(list* l)
 {
@@ -856,7 +2556,7 @@ _list_pop(list* l)
 
     --(l->size);
 
-    _free_list_node(former_tail);
+    _free_list_node(l, former_tail);
     return value;
 }
 
@@ -914,12 +2614,13 @@ _unlink_node(list* l, _node* node)
 static inline void
 _list_adjust_jump_table_up(list* l, lindex index)
 {
-    lindex affected_jt_indicies_start = index / JT_INCREMENT;
-    lindex final_jt_index = (l->size - 1) / JT_INCREMENT;
+    lindex affected_jt_indicies_start = _jt_entry_of(l, index);
+    lindex final_jt_index = _jt_entry_of(l, l->size - 1);
  
     lindex i = affected_jt_indicies_start;
-    //Don't change last jump_table node yet. 
-    for (; i < final_jt_index; ++i)
+    //Don't change last jump_table node yet.  Out of date entries are left
+    //for _list_repair_jump_table().  
+    for (; i < final_jt_index && i < l->jt_stale_from; ++i)
         _advance_jt_entry_if_affected(l, index, i);
 
     _remove_or_advance_last_jt_entry(l, index, final_jt_index);
@@ -931,7 +2632,7 @@ _advance_jt_entry_if_affected(list* l, lindex index, lindex table_index)
 {
     //Only advance ptr if index really does come before the jt node.  
     //Exapmle: index == 9001, dont advance l->jump_table[9].  
-    if (index <= (table_index * JT_INCREMENT))
+    if ((long)index <= _jt_index_of(l, table_index))
         l->jump_table[table_index] = l->jump_table[table_index]->next;
 }
 
@@ -939,12 +2640,13 @@ _advance_jt_entry_if_affected(list* l, lindex index, lindex table_index)
 static inline void
 _remove_or_advance_last_jt_entry(list* l, lindex index, lindex final_jt_index)
 {
-    if ((l->size - 1) % JT_INCREMENT == 0)
+    if ((l->size - 1 + l->jt_offset) % JT_INCREMENT == 0)
         //If the last element in the list ends on a jump_table location,
         //repace it with NULL because an element is being removed.  
         l->jump_table[final_jt_index] = NULL;
 
-    else if (index <= final_jt_index * 1000)
+    else if ((long)index <= _jt_index_of(l, final_jt_index) &&
+             final_jt_index < l->jt_stale_from)
         l->jump_table[final_jt_index] = l->jump_table[final_jt_index]->next;
 }
 
@@ -982,21 +2684,65 @@ _get_start_node(list* l, lindex pos, long* dist)
 }
 
 
+static inline _node*
+_list_pointer_at_const(const list* l, lindex index)
+{
+    _node* start = l->head;
+    long dist = (long)index;
+
+    //Entries from jt_stale_from on may be out of date, and can't be repaired
+    //without changing the list, so the last up to date entry is used instead.  
+    lindex valid = l->jt_stale_from < l->jt_size ? l->jt_stale_from : l->jt_size;
+    lindex entry = _jt_entry_of(l, index);
+    lindex candidates[2] = {entry < valid ? entry : valid - 1, entry + 1};
+    int i = 0;
+    for (; i < 2; ++i)
+    {
+        lindex e = candidates[i];
+        if (e >= valid || l->jump_table[e] == NULL) continue;
+
+        long jt_dist = (long)index - _jt_index_of(l, e);
+        if (labs(jt_dist) < labs(dist))
+        {
+            start = l->jump_table[e];
+            dist = jt_dist;
+        }
+    }
+
+    long tail_dist = (long)index - (long)(l->size - 1);
+    if (labs(tail_dist) < labs(dist))
+    {
+        start = l->tail;
+        dist = tail_dist;
+    }
+
+    return _advance_to(start, dist < 0, labs(dist));
+}
+
+
 static inline _node*
 _get_closest_jt_node(list* l, lindex pos, long* jump_loc_dist)
 {
-    long lower_jump_loc = (long)pos / JT_INCREMENT;
+    long lower_jump_loc = (long)_jt_entry_of(l, pos);
     long upper_jump_loc = lower_jump_loc + 1;
+    _list_repair_jump_table(l, upper_jump_loc + 1);
 
-    long upper_dist = labs(pos - (upper_jump_loc * JT_INCREMENT));
-    long lower_dist = labs(pos - (lower_jump_loc * JT_INCREMENT));
+    long upper_dist = labs((long)pos - _jt_index_of(l, upper_jump_loc));
+    long lower_dist = labs((long)pos - _jt_index_of(l, lower_jump_loc));
 
-    int use_upper = l->jt_size > upper_jump_loc && 
+    int use_upper = (long)l->jt_size > upper_jump_loc && 
                     l->jump_table[upper_jump_loc] != NULL &&
                     upper_dist < lower_dist;
 
+    //After list_pop_front() the first entry may come after the head.  
+    if (!use_upper && _jt_index_of(l, lower_jump_loc) < 0)
+    {
+        *jump_loc_dist = pos;
+        return l->head;
+    }
+
     long jump_location = (use_upper ? upper_jump_loc : lower_jump_loc);
-    *jump_loc_dist = pos - (jump_location * JT_INCREMENT);
+    *jump_loc_dist = (long)pos - _jt_index_of(l, jump_location);
     return l->jump_table[jump_location];
 }
 
@@ -1032,15 +2778,15 @@ _list_adjust_jump_table_down(list* l, lindex index)
     //l->size incr/decr is always last operation so size is +1 current.  
     if (l->size > 0) //list_insert() will catch the size == 0 case.  
     {
-        lindex affected_jt_indicies_start_index = index / JT_INCREMENT;
-        lindex final_jt_index = (l->size - 1) / JT_INCREMENT;
+        lindex affected_jt_indicies_start_index = _jt_entry_of(l, index);
+        lindex final_jt_index = _jt_entry_of(l, l->size - 1);
     
         lindex i = affected_jt_indicies_start_index;
-        for (; i <= final_jt_index; ++i)
+        for (; i <= final_jt_index && i < l->jt_stale_from; ++i)
             _deadvance_jt_entry_if_affected(l, index, i);
     }
 
-    if (l->size % JT_INCREMENT == 0)
+    if ((l->size + l->jt_offset) % JT_INCREMENT == 0)
         //In the case of an insert:
         //The last element is being pushed into a _jump_table node position.       
         _list_add_jump_table_node(l, l->tail);
@@ -1052,7 +2798,7 @@ _deadvance_jt_entry_if_affected(list* l, lindex index, lindex table_index)
 {
     //Only advance ptr if index really does come before the jt node.  
     //Exapmle: index == 9001, dont deadvance l->jump_table[9].  
-    if (index <= (table_index * JT_INCREMENT))
+    if ((long)index <= _jt_index_of(l, table_index))
             l->jump_table[table_index] = l->jump_table[table_index]->prev;
 }
 
@@ -1073,7 +2819,7 @@ _list_remove(list* l, _node* node, lindex index)
 
     --(l->size);
 
-    _free_list_node(node);
+    _free_list_node(l, node);
     return value;
 }
 
@@ -1140,6 +2886,191 @@ _merge_sort_list(_node* current_head, lindex sublist_size)
 }
 
 
+//Entries are ordered by their values.  
+#define _ENTRY_LESS(a, b) LIST_COMPARATOR((a).value, (b).value)
+_DEFINE_NATURAL_MERGE_SORT(_merge_sort_entries, _sort_entry, _ENTRY_LESS)
+
+
+static inline void
+_relink_sorted(list* l, const _sort_entry* entries)
+{
+    _relink_sorted_range(l, entries, 0, l->size);
+    _finish_relink(l, entries);
+}
+
+
+static inline void
+_relink_sorted_range(list* l, const _sort_entry* entries,
+                     lindex from, lindex to)
+{
+    lindex i = from;
+    for (; i < to; ++i)
+    {
+        _node* node = entries[i].node;
+        node->prev = i > 0 ? entries[i-1].node : NULL;
+        node->next = i + 1 < l->size ? entries[i+1].node : NULL;
+        if (node == l->current)
+            l->current_index = i;
+    }
+
+    //Only the positions the table refers to need to be visited.  
+    lindex index = from + (JT_INCREMENT - (from + l->jt_offset) % JT_INCREMENT)
+                          % JT_INCREMENT;
+    for (; index < to; index += JT_INCREMENT)
+        l->jump_table[_jt_entry_of(l, index)] = entries[index].node;
+}
+
+
+static inline void
+_finish_relink(list* l, const _sort_entry* entries)
+{
+    l->head = entries[0].node;
+    l->tail = entries[l->size - 1].node;
+
+    //Entries past the end may be left over from cursor removes.  
+    if (l->jt_stale_from != JT_ALL_VALID)
+    {
+        lindex i = _jt_entry_of(l, l->size - 1) + 1;
+        for (; i < l->jt_size; ++i)
+            l->jump_table[i] = NULL;
+        l->jt_stale_from = JT_ALL_VALID;
+    }
+}
+
+
+static inline lindex
+_list_bound(list* l, LIST_DATA_TYPE value, int upper)
+{
+    if (l->size == 0) return 0;
+    _list_repair_jump_table(l, l->jt_size);
+
+    //Binary search the jump_table for the last node that goes before 'value',
+    //then scan at most one segment from it.  
+    _node* node = l->head;
+    lindex index = 0;
+    lindex first = (JT_INCREMENT - l->jt_offset % JT_INCREMENT) % JT_INCREMENT;
+    if (first < l->size)
+    {
+        lindex lo = _jt_entry_of(l, first);
+        lindex hi = _jt_entry_of(l, l->size - 1) + 1;
+        lindex start = lo;
+        while (lo < hi)
+        {
+            lindex mid = lo + (hi - lo) / 2;
+            LIST_DATA_TYPE x = l->jump_table[mid]->value;
+            if (upper ? !LIST_COMPARATOR(value, x) : LIST_COMPARATOR(x, value))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        if (lo > start)
+        {
+            node = l->jump_table[lo-1];
+            index = _jt_index_of(l, lo-1);
+        }
+    }
+
+    for (; node != NULL; node = node->next, ++index)
+    {
+        LIST_DATA_TYPE x = node->value;
+        if (upper ? LIST_COMPARATOR(value, x) : !LIST_COMPARATOR(x, value))
+            break;
+    }
+
+    //Makes a following list_get() or list_insert() at the index O(1).  
+    if (node != NULL)
+    {
+        set_list_current(l, node, index);
+    }
+    return index;
+}
+
+
+static inline unsigned long long
+_radix_key_signed(long long value, unsigned bits)
+{
+    //Flipping the sign bit puts negative values first.  
+    unsigned long long key = (unsigned long long)value ^ (1ULL << (bits - 1));
+    return key & (~0ULL >> (64 - bits));
+}
+
+
+static inline unsigned long long
+_radix_key_unsigned(unsigned long long value, unsigned bits)
+{
+    (void)bits;
+    return value;
+}
+
+
+static inline unsigned long long
+_radix_key_char(char value, unsigned bits)
+{
+    if ((char)-1 < 0)
+        return _radix_key_signed(value, bits);
+    return _radix_key_unsigned((unsigned char)value, bits);
+}
+
+
+static inline unsigned long long
+_radix_key_none(LIST_DATA_TYPE value, unsigned bits)
+{
+    (void)value;
+    (void)bits;
+    return 0;
+}
+
+
+static inline void
+_radix_sort_entries(_sort_entry* entries, _sort_entry* tmp, lindex n)
+{
+    enum { MAX_DIGITS = 8 };
+    const unsigned digits = sizeof(LIST_DATA_TYPE) < MAX_DIGITS ?
+                            sizeof(LIST_DATA_TYPE) : MAX_DIGITS;
+
+    //Count every digit in one pass.  
+    lindex counts[MAX_DIGITS][256];
+    memset(counts, 0, sizeof(counts));
+    lindex i;
+    unsigned d;
+    for (i = 0; i < n; ++i)
+    {
+        unsigned long long key = _RADIX_KEY(entries[i].value);
+        for (d = 0; d < digits; ++d)
+            ++counts[d][(key >> (8 * d)) & 0xFF];
+    }
+
+    _sort_entry* src = entries;
+    _sort_entry* dst = tmp;
+    for (d = 0; d < digits; ++d)
+    {
+        unsigned shift = 8 * d;
+        lindex* count = counts[d];
+        if (count[(_RADIX_KEY(src[0].value) >> shift) & 0xFF] == n)
+            continue;
+
+        lindex offset = 0;
+        unsigned b;
+        for (b = 0; b < 256; ++b)
+        {
+            lindex c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+
+        for (i = 0; i < n; ++i)
+            dst[count[(_RADIX_KEY(src[i].value) >> shift) & 0xFF]++] = src[i];
+
+        _sort_entry* swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != entries)
+        memcpy(entries, src, n * sizeof(_sort_entry));
+}
+
+
 static inline void
 _append(_node** head, _node** tail, _node* next)
 {
@@ -1167,15 +3098,24 @@ _reassign_jump_table(list* l, lindex index, _node* node)
         if (current == l->current) //Update current_position.  
             l->current_index = index;
 
-        if (index % JT_INCREMENT == 0)
-            l->jump_table[index / JT_INCREMENT] = current;
+        if ((index + l->jt_offset) % JT_INCREMENT == 0)
+            l->jump_table[_jt_entry_of(l, index)] = current;
         current = current->next;
         ++index;
     }
 
     //Handle last jump_table node if necessary.  
-    if (index % JT_INCREMENT == 0)
-            l->jump_table[index / JT_INCREMENT] = current;
+    if ((index + l->jt_offset) % JT_INCREMENT == 0)
+            l->jump_table[_jt_entry_of(l, index)] = current;
+
+    //Entries past the end may be left over from cursor removes.  
+    if (l->jt_stale_from != JT_ALL_VALID)
+    {
+        lindex i = _jt_entry_of(l, index) + 1;
+        for (; i < l->jt_size; ++i)
+            l->jump_table[i] = NULL;
+        l->jt_stale_from = JT_ALL_VALID;
+    }
 
     return current;
 }
@@ -1197,17 +3137,28 @@ _add_filtered_values_to_new_list(list* l, list* nl, filter_func filter)
 static inline void
 _add_range(list* l, _node* start, _node* end, lindex size)
 {
-    lindex last_jt_index  = (l->size-1) / JT_INCREMENT;
+    if (l->size == 0)
+    {
+        _list_set_new(l, start, end, size);
+        return;
+    }
+
+    lindex last_jt_index  = _jt_entry_of(l, l->size-1);
+    _list_repair_jump_table(l, last_jt_index + 1);
 
     _link_range(l, start, end);
     l->size += size;
     
-    lindex new_table_size = l->size / JT_INCREMENT;
+    lindex new_table_size = _jt_entry_of(l, l->size - 1) + 1;
     if (l->jt_size < new_table_size)
         _list_grow_jump_table(l, new_table_size * 2);
 
-    _node* start_node = l->jump_table[last_jt_index];
-    _reassign_jump_table(l, last_jt_index * JT_INCREMENT, start_node);
+    //Without an entry at or before the old tail, reassign from the head.  
+    long start_index = _jt_index_of(l, last_jt_index);
+    if (start_index < 0)
+        _reassign_jump_table(l, 0, l->head);
+    else
+        _reassign_jump_table(l, start_index, l->jump_table[last_jt_index]);
 }
 
 
@@ -1248,10 +3199,10 @@ _list_chop(list* l, _node* new_tail, lindex new_tail_index)
 static inline void
 _remove_invalid_jt_entries(list* l, lindex index)
 {
-    lindex invalid_jt_index = index / JT_INCREMENT;
+    lindex invalid_jt_index = _jt_entry_of(l, index);
     for (; invalid_jt_index < l->jt_size; ++invalid_jt_index)
     {
-        if (index <= invalid_jt_index * JT_INCREMENT)
+        if ((long)index <= _jt_index_of(l, invalid_jt_index))
             l->jump_table[invalid_jt_index] = NULL;
     }
 }
@@ -1263,7 +3214,12 @@ _list_set_new(list* nl, _node* head, _node* tail, lindex size)
     nl->head = head;
     nl->head->prev = NULL;
     nl->tail = tail;
+    nl->tail->next = NULL;
     nl->size = size;
+
+    lindex table_size = _jt_entry_of(nl, size - 1) + 1;
+    if (nl->jt_size < table_size)
+        _list_grow_jump_table(nl, table_size * 2);
     _reassign_jump_table(nl, 0, nl->head);
 }
 
@@ -1271,33 +3227,106 @@ _list_set_new(list* nl, _node* head, _node* tail, lindex size)
 static inline list*
 _list_split_where(list* l, list* nl, filter_func filter)
 {
-    int i = 0;
-    _node* current = l->head;
-    while (current != NULL)
+    _node* last;
+    lindex count;
+    _node* moved = _list_partition(l, filter, 1, &last, &count);
+    if (moved)
+        _list_set_new(nl, moved, last, count);
+
+    return nl;
+}
+
+
+static inline _node*
+_list_partition(list* l, filter_func filter, int matching,
+                _node** last, lindex* count)
+{
+    _node* kept_head = NULL;
+    _node* kept_tail = NULL;
+    _node* out_head = NULL;
+    _node* out_tail = NULL;
+    lindex kept = 0;
+    *count = 0;
+
+    _node* current = l->current;
+    l->current = NULL;
+    l->current_index = 0;
+
+    _node* node = l->head;
+    while (node != NULL)
     {
-        _node* next = current->next;
-        if (filter(current->value))
+        _node* next = node->next;
+        if ((filter(node->value) != 0) == matching)
+        {
+            _append(&out_head, &out_tail, node);
+            ++(*count);
+        }
+        else
         {
-            _move_node(l, nl, current, i);
-            --i;
+            if (node == current)
+            {
+                l->current = node;
+                l->current_index = kept;
+            }
+            _append(&kept_head, &kept_tail, node);
+            ++kept;
         }
+        node = next;
+    }
 
-        current = next;
-        ++i;
+    l->head = kept_head;
+    l->tail = kept_tail;
+    l->size = kept;
+    if (kept_tail)
+    {
+        kept_tail->next = NULL;
+        _reassign_jump_table(l, 0, kept_head);
     }
+    _remove_invalid_jt_entries(l, kept);
+    l->jt_stale_from = JT_ALL_VALID;
 
-    return nl;
+    if (out_tail)
+        out_tail->next = NULL;
+    *last = out_tail;
+    return out_head;
+}
+
+
+static inline void
+_list_remove_partition(list* l, filter_func filter, int matching)
+{
+    _node* last;
+    lindex count;
+    _node* node = _list_partition(l, filter, matching, &last, &count);
+
+    #if FREE_LIST_ITEMS
+        _node* current;
+        for (current = node; current != NULL; current = current->next)
+            free(current->value);
+    #endif
+    _free_chain(l, node);
 }
 
 
 static inline void
 _move_node(list* l1, list* l2, _node* ln, lindex node_index)
 {
+    //Nodes can only be linked into lists sharing their allocator.  
+    _node* moved = ln;
+    if (l1->pool != l2->pool)
+    {
+        moved = _new_list_node(l2, ln->value);
+        if (ALLOC_ERROR(moved)) return;
+    }
+
     //Remove from l1.  
     _update_list_current(l1, ln, node_index);
     _unlink_node(l1, ln);
     _list_adjust_jump_table_up(l1, node_index);
     --(l1->size);
+    if (moved != ln)
+        _free_list_node(l1, ln);
+    ln = moved;
 
     //Add to l2.  
     _link_node(l2, l2->size, ln);
@@ -1315,12 +3344,356 @@ _unlink_range(list* l, _node* start, _node* end)
         start->prev->next = end->next;
     
     if (end == l->tail)
-        l->tail = NULL;
+        l->tail = start->prev;
     else
         end->next->prev = start->prev;
 }
 
 
+static inline _node*
+_list_detach_range(list* l, _node* first, lindex start, lindex count,
+                   _node** last)
+{
+    _node* end = first;
+    lindex i = 1;
+    for (; i < count; ++i)
+        end = end->next;
+
+    _unlink_range(l, first, end);
+    first->prev = NULL;
+    end->next = NULL;
+    l->size -= count;
+
+    if (l->current && l->current_index >= start)
+    {
+        if (l->current_index >= start + count)
+            l->current_index -= count;
+        else
+        {
+            l->current = NULL;
+            l->current_index = 0;
+        }
+    }
+
+    _list_invalidate_jump_table(l, start);
+    *last = end;
+    return first;
+}
+
+
+static inline _node*
+_copy_chain(list* l, const _node* node, lindex count, _node** last)
+{
+    _node* head = NULL;
+    _node* tail = NULL;
+    lindex i = 0;
+    for (; i < count; ++i, node = node->next)
+    {
+        _node* copy = _new_list_node(l, node->value);
+        if (!copy)
+        {
+            if (tail)
+                tail->next = NULL;
+            _free_chain(l, head);
+            return NULL;
+        }
+        _append(&head, &tail, copy);
+    }
+
+    tail->next = NULL;
+    *last = tail;
+    return head;
+}
+
+
+static inline void
+_free_chain(list* l, _node* node)
+{
+    while (node != NULL)
+    {
+        _node* next = node->next;
+        _free_list_node(l, node);
+        node = next;
+    }
+}
+
+
+#if _LIST_ATOMICS
+static inline void
+_push_pending(list* l, _node* first, _node* last)
+{
+    _node* top = __atomic_load_n(&l->pending, __ATOMIC_RELAXED);
+    do
+        last->next = top;
+    while (!__atomic_compare_exchange_n(&l->pending, &top, first, 1,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+#endif
+
+
+#endif //LIST_STORAGE
+
+
+
+_DEFINE_NATURAL_MERGE_SORT(_merge_sort_values, LIST_DATA_TYPE, LIST_COMPARATOR)
+
+
+static inline void
+list_set(list* l, lindex index, LIST_DATA_TYPE value)
+{
+    if (NULL_ARG_ERROR(l)) return;
+    if (INDEX_ERROR(l, index)) return;
+
+    LIST_DATA_TYPE* ref = list_get_ref(l, index);
+    if (ref)
+        *ref = value;
+}
+
+
+static inline LIST_DATA_TYPE*
+list_emplace_back(list* l)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+
+    LIST_DATA_TYPE value;
+    memset(&value, 0, sizeof(value));
+    lindex size = l->size;
+    list_add(l, value);
+    if (l->size == size) return NULL;
+    return list_get_ref(l, size);
+}
+
+
+static inline int
+list_try_get(list* l, lindex index, LIST_DATA_TYPE* out)
+{
+    if (!l || !out) return LIST_NULL_ARG;
+    if (index >= l->size) return LIST_INDEX_OUT_OF_RANGE;
+
+    *out = *_list_ref_at(l, index);
+    return LIST_OK;
+}
+
+
+static inline LIST_DATA_TYPE
+list_get_unchecked(list* l, lindex index)
+{
+    return *_list_ref_at(l, index);
+}
+
+
+static inline void
+list_set_unchecked(list* l, lindex index, LIST_DATA_TYPE value)
+{
+    LIST_DATA_TYPE* ref = _list_mut_ref_at(l, index);
+    if (ref)
+        *ref = value;
+}
+
+
+static inline void
+list_add_unchecked(list* l, LIST_DATA_TYPE value)
+{
+    _list_add(l, value);
+}
+
+
+#if LIST_STORAGE != LIST_STORAGE_BTREE
+static inline LIST_DATA_TYPE*
+_list_mut_ref_at(list* l, lindex index)
+{
+    return _list_ref_at(l, index);
+}
+#endif
+
+
+static inline lindex
+list_lower_bound(list* l, LIST_DATA_TYPE value)
+{
+    if (NULL_ARG_ERROR(l)) return INDEX_ERR_RETURN_VALUE;
+
+    return _list_bound(l, value, 0);
+}
+
+
+static inline lindex
+list_upper_bound(list* l, LIST_DATA_TYPE value)
+{
+    if (NULL_ARG_ERROR(l)) return INDEX_ERR_RETURN_VALUE;
+
+    return _list_bound(l, value, 1);
+}
+
+
+static inline int
+list_contains_sorted(list* l, LIST_DATA_TYPE value)
+{
+    if (NULL_ARG_ERROR(l)) return 0;
+
+    lindex index = _list_bound(l, value, 0);
+    return index < l->size && !LIST_COMPARATOR(value, list_get(l, index));
+}
+
+
+static inline lindex
+list_insert_sorted(list* l, LIST_DATA_TYPE value)
+{
+    if (NULL_ARG_ERROR(l)) return INDEX_ERR_RETURN_VALUE;
+
+    lindex size = l->size;
+    lindex index = _list_bound(l, value, 1);
+    if (index == size)
+        list_add(l, value);
+    else
+        list_insert(l, index, value);
+    return l->size > size ? index : INDEX_ERR_RETURN_VALUE;
+}
+
+
+static inline void
+_list_truncate(list* l, lindex size)
+{
+    while (l->size > size)
+        list_pop(l);
+}
+
+
+#if LIST_STORAGE != LIST_STORAGE_NODES
+//Range and filter functions for storage layouts without node chains to
+//splice.  
+
+
+static inline void
+list_retain(list* l, filter_func filter)
+{
+    if (NULL_ARG_ERROR(l)) return;
+
+    _list_retain(l, filter, 1);
+}
+
+
+static inline void
+list_remove_where(list* l, filter_func filter)
+{
+    if (NULL_ARG_ERROR(l)) return;
+
+    _list_retain(l, filter, 0);
+}
+
+
+static inline void
+list_add_range(list* l1, list* l2, lindex start, lindex end)
+{
+    if (NULL_ARG_ERROR(l1) || NULL_ARG_ERROR(l2)) return;
+    if (RANGE_ERROR(l1, start, end)) return;
+
+    //The values move to l2, so they are not freed with l1's range.  
+    if (_list_copy_values(l1, l2, start, end)) return;
+    _list_erase(l1, start, end, 0);
+}
+
+
+static inline void
+list_remove_range(list* l, lindex start, lindex end)
+{
+    if (NULL_ARG_ERROR(l)) return;
+    if (RANGE_ERROR(l, start, end)) return;
+
+    _list_erase(l, start, end, FREE_LIST_ITEMS);
+}
+
+
+static inline void
+list_copy_range(list* l1, list* l2, lindex start, lindex end)
+{
+    if (NULL_ARG_ERROR(l1) || NULL_ARG_ERROR(l2)) return;
+    if (RANGE_ERROR(l1, start, end)) return;
+
+    _list_copy_values(l1, l2, start, end);
+}
+
+
+static inline list*
+copy_list(list* l)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    list* nl = new_list();
+    if (ALLOC_ERROR(nl)) return NULL;
+
+    if (_list_copy_values(l, nl, 0, l->size))
+    {
+        free_list(nl);
+        return NULL;
+    }
+    return nl;
+}
+
+
+static inline LIST_DATA_TYPE*
+list_as_array(list* l)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+
+    //At least one element, so an empty list isn't mistaken for a failure.  
+    LIST_DATA_TYPE* arr =
+        (LIST_DATA_TYPE*)malloc((l->size ? l->size : 1) * sizeof(LIST_DATA_TYPE));
+    if (ALLOC_ERROR(arr)) return NULL;
+
+    _list_read_values(l, arr);
+    return arr;
+}
+
+
+static inline list*
+array_as_list(LIST_DATA_TYPE* arr, lindex arr_size)
+{
+    list* l = new_list();
+    if (ALLOC_ERROR(l)) return NULL;
+    if (arr_size == 0) return l;
+    if (ALLOC_ERROR(arr))
+    {
+        free_list(l);
+        return NULL;
+    }
+
+    if (_list_append_values(l, arr, arr_size))
+    {
+        free_list(l);
+        return NULL;
+    }
+    return l;
+}
+
+
+static inline lindex
+_list_bound(list* l, LIST_DATA_TYPE value, int upper)
+{
+    lindex lo = 0;
+    lindex hi = l->size;
+    while (lo < hi)
+    {
+        lindex mid = lo + (hi - lo) / 2;
+        LIST_DATA_TYPE x = list_get(l, mid);
+        if (upper ? !LIST_COMPARATOR(value, x) : LIST_COMPARATOR(x, value))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+#endif
+
+
+static inline err_handler_ft
+list_error_handler(err_handler_ft f)
+{
+    static err_handler_ft handler = _default_error_handler;
+    if (f != NULL)
+        handler = f;
+    return handler;
+}
+
+
 static inline int
 _default_error_handler(const char* func, const char* arg, const char* msg)
 {
@@ -1349,7 +3722,7 @@ _list_index_error(const list* l, lindex index, const char* func)
 {
     if (index >= l->size)
     {
-        char arg_as_string[20];
+        char arg_as_string[24];
         sprintf(arg_as_string, "(%ld)", index);
         list_error_handler(NULL)\
         (func, arg_as_string, "Index out of range!\n");
@@ -1359,6 +3732,21 @@ _list_index_error(const list* l, lindex index, const char* func)
 }
 
 
+static inline int
+_list_range_error(const list* l, lindex start, lindex end, const char* func)
+{
+    if (start > end || end > l->size)
+    {
+        char arg_as_string[48];
+        sprintf(arg_as_string, "(%ld, %ld)", start, end);
+        list_error_handler(NULL)\
+        (func, arg_as_string, "Range out of bounds!\n");
+        return -1;
+    }
+    return 0;
+}
+
+
 static inline int
 _list_size_error(const list* l, const char* func)
 {
@@ -0,0 +1,905 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist.hpp
+// C++17 version of the clist.h list: clist<T, Compare, Alloc> stores T values
+// in doubly linked nodes allocated through 'Alloc', with a jump_table entry
+// every jt_increment values and a cached current node for near constant
+// index lookups.  Values are constructed in place, so move-only types work,
+// and 'Compare' is called directly by sort().  Iterators are bidirectional
+// and can be used with <algorithm>.  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CLIST_HPP
+#define CLIST_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+template <class T, class Compare = std::less<T>, class Alloc = std::allocator<T>>
+class clist
+{
+    struct node;
+    template <bool Const> class basic_iterator;
+
+    using node_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<node>;
+    using node_traits = std::allocator_traits<node_alloc>;
+    using table_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<node*>;
+
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+    using value_compare = Compare;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    //Number of values between jump_table entries, as JT_INCREMENT in clist.h.  
+    static constexpr size_type jt_increment = 1000;
+
+
+    /// Construction ///
+
+
+    clist() : clist(Compare()) {}
+
+    explicit
+    clist(const Compare& comp, const Alloc& alloc = Alloc());
+
+    clist(std::initializer_list<T> values, const Compare& comp = Compare(),
+          const Alloc& alloc = Alloc());
+
+    /*
+    Copies every value of 'other'.  Requires a copy constructible T.  
+    */
+    clist(const clist& other);
+
+    /*
+    Takes the nodes of 'other', which is left empty.  
+    */
+    clist(clist&& other) noexcept;
+
+    clist&
+    operator=(const clist& other);
+
+    /*
+    Takes the nodes of 'other' if the allocators allow it, otherwise moves
+    its values one by one.  'other' is left empty.  
+    */
+    clist&
+    operator=(clist&& other)
+    noexcept(node_traits::propagate_on_container_move_assignment::value
+             || node_traits::is_always_equal::value);
+
+    /*
+    Destroys every value and frees the nodes.  
+    */
+    ~clist();
+
+
+    /// Access ///
+
+
+    size_type
+    size() const noexcept { return size_; }
+
+    bool
+    empty() const noexcept { return size_ == 0; }
+
+    /*
+    Returns the value at 'index', which must be below size().  Lookups start
+    from the closest of the head, the tail, the last value looked up and the
+    closest up to date jump_table entry, which they bring up to date.  
+    */
+    reference
+    operator[](size_type index);
+
+    /*
+    Returns the value at 'index' without changing the list (see
+    list_get_const() in clist.h), so any number of threads may call it at once.  
+    */
+    const_reference
+    operator[](size_type index) const;
+
+    /*
+    Same as operator[], but throws std::out_of_range if 'index' is not below
+    size().  
+    */
+    reference
+    at(size_type index);
+
+    const_reference
+    at(size_type index) const;
+
+    reference front() { return head_->value; }
+    const_reference front() const { return head_->value; }
+    reference back() { return tail_->value; }
+    const_reference back() const { return tail_->value; }
+
+    /*
+    Returns an iterator on the value at 'index', or end() if 'index' is
+    size(), found the same way as operator[].  
+    */
+    iterator
+    iterator_at(size_type index);
+
+    const_iterator
+    iterator_at(size_type index) const;
+
+    iterator begin() noexcept { return iterator(head_, this); }
+    iterator end() noexcept { return iterator(nullptr, this); }
+    const_iterator begin() const noexcept { return const_iterator(head_, this); }
+    const_iterator end() const noexcept { return const_iterator(nullptr, this); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+    allocator_type get_allocator() const { return allocator_type(alloc_); }
+    value_compare value_comp() const { return comp_; }
+
+
+    /// Modifiers ///
+
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+    void push_front(const T& value) { emplace_front(value); }
+    void push_front(T&& value) { emplace_front(std::move(value)); }
+
+    /*
+    Constructs a value from 'args' at the end of the list and returns it.  
+    */
+    template <class... Args>
+    reference
+    emplace_back(Args&&... args);
+
+    /*
+    Constructs a value from 'args' at the front of the list and returns it.  
+    Marks every jump_table entry out of date.  
+    */
+    template <class... Args>
+    reference
+    emplace_front(Args&&... args);
+
+    /*
+    Constructs a value from 'args' in front of 'pos' and returns an iterator
+    on it.  Since the index of 'pos' is not known, every jump_table entry is
+    marked out of date unless 'pos' is end(); the next index lookup brings
+    the table up to date in one walk.  
+    */
+    template <class... Args>
+    iterator
+    emplace(const_iterator pos, Args&&... args);
+
+    /*
+    Constructs a value from 'args' at 'index', which may be size(), and
+    returns it.  Only the jump_table entries after 'index' are marked out of
+    date.  Throws std::out_of_range if 'index' is greater than size().  
+    */
+    template <class... Args>
+    reference
+    emplace_at(size_type index, Args&&... args);
+
+    iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+    iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+
+    /*
+    Destroys the value at 'pos' and returns an iterator on the next one.  
+    Marks the jump_table out of date as emplace() does.  
+    */
+    iterator
+    erase(const_iterator pos);
+
+    /*
+    Destroys the value at 'index'.  Only the jump_table entries after 'index'
+    are marked out of date.  Throws std::out_of_range if 'index' is not below
+    size().  
+    */
+    void
+    erase_at(size_type index);
+
+    /*
+    Destroys the last value.  The list must not be empty.  
+    */
+    void
+    pop_back();
+
+    /*
+    Destroys the first value.  The list must not be empty.  Marks every
+    jump_table entry out of date.  
+    */
+    void
+    pop_front();
+
+    /*
+    Destroys every value.  
+    */
+    void
+    clear() noexcept;
+
+    /*
+    Stable sort of the list by 'Compare'.  Nodes are relinked in order, so
+    values are never copied or moved and iterators stay valid.  Throws
+    std::bad_alloc, leaving the list unchanged, if the O(n) scratch space
+    can't be allocated.  
+    */
+    void
+    sort();
+
+    void
+    swap(clist& other) noexcept;
+
+
+private:
+    /*
+    Internal function that allocates a node and constructs its value from
+    'args'.  
+    */
+    template <class... Args>
+    node*
+    _new_node(Args&&... args);
+
+    /*
+    Internal function that destroys the node's value and frees it.  
+    */
+    void
+    _free_node(node* n) noexcept;
+
+    /*
+    Internal function that grows the jump_table to have room for an entry
+    for every value of a list of 'size' values.  
+    */
+    void
+    _reserve_table(size_type size);
+
+    /*
+    Internal function that links 'n' in front of 'next', or at the end if
+    'next' is NULL.  
+    */
+    void
+    _link_before(node* next, node* n) noexcept;
+
+    /*
+    Internal function that unlinks 'n' and frees it.  
+    */
+    void
+    _unlink(node* n) noexcept;
+
+    /*
+    Internal function that marks the jump_table entries from 'index' on as
+    out of date.  
+    */
+    void
+    _invalidate_from(size_type index) noexcept;
+
+    /*
+    Internal function that returns the node at 'index' and makes it the
+    current node, bringing stale jump_table entries it walks past up to date.  
+    */
+    node*
+    _node_at(size_type index) noexcept;
+
+    /*
+    Internal function that returns the node at 'index' without changing the
+    list.  
+    */
+    node*
+    _node_at_const(size_type index) const noexcept;
+
+    /*
+    Internal function that takes the nodes of 'other', leaving it empty.  
+    */
+    void
+    _steal(clist& other) noexcept;
+
+
+    struct node
+    {
+        node* next;
+        node* prev;
+        //Constructed separately, through the allocator.  
+        union { T value; };
+
+        node() noexcept {}
+        ~node() {}
+    };
+
+    template <bool Const>
+    class basic_iterator
+    {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+
+        basic_iterator() noexcept : n_(nullptr), l_(nullptr) {}
+
+        //Iterators convert to const_iterators.  
+        template <bool C = Const, class = std::enable_if_t<C>>
+        basic_iterator(const basic_iterator<false>& other) noexcept
+            : n_(other.n_), l_(other.l_) {}
+
+        reference operator*() const { return n_->value; }
+        pointer operator->() const { return std::addressof(n_->value); }
+
+        basic_iterator&
+        operator++() { n_ = n_->next; return *this; }
+
+        basic_iterator
+        operator++(int) { basic_iterator old = *this; ++*this; return old; }
+
+        //Moving back from end() reaches the last value.  
+        basic_iterator&
+        operator--() { n_ = n_ ? n_->prev : l_->tail_; return *this; }
+
+        basic_iterator
+        operator--(int) { basic_iterator old = *this; --*this; return old; }
+
+        friend bool
+        operator==(const basic_iterator& a, const basic_iterator& b) { return a.n_ == b.n_; }
+
+        friend bool
+        operator!=(const basic_iterator& a, const basic_iterator& b) { return a.n_ != b.n_; }
+
+    private:
+        friend class clist;
+        template <bool> friend class basic_iterator;
+
+        basic_iterator(node* n, const clist* l) noexcept : n_(n), l_(l) {}
+
+        node*        n_;
+        const clist* l_;
+    };
+
+
+    node*       head_;
+    node*       tail_;
+    node*       current_;
+    size_type   size_;
+    size_type   current_index_;
+    //Leading jump_table entries known to be up to date.  
+    size_type   jt_valid_;
+    std::vector<node*, table_alloc> jump_table_;
+    node_alloc  alloc_;
+    Compare     comp_;
+};
+
+
+template <class T, class C, class A>
+void
+swap(clist<T, C, A>& a, clist<T, C, A>& b) noexcept
+{
+    a.swap(b);
+}
+
+
+
+
+template <class T, class C, class A>
+clist<T, C, A>::clist(const C& comp, const A& alloc)
+    : head_(nullptr), tail_(nullptr), current_(nullptr), size_(0),
+      current_index_(0), jt_valid_(0), jump_table_(table_alloc(alloc)),
+      alloc_(alloc), comp_(comp)
+{
+}
+
+
+template <class T, class C, class A>
+clist<T, C, A>::clist(std::initializer_list<T> values, const C& comp, const A& alloc)
+    : clist(comp, alloc)
+{
+    for (const T& value : values)
+        emplace_back(value);
+}
+
+
+template <class T, class C, class A>
+clist<T, C, A>::clist(const clist& other)
+    : clist(other.comp_,
+            std::allocator_traits<A>::select_on_container_copy_construction(
+                A(other.alloc_)))
+{
+    for (const T& value : other)
+        emplace_back(value);
+}
+
+
+template <class T, class C, class A>
+clist<T, C, A>::clist(clist&& other) noexcept
+    : clist(other.comp_, A(other.alloc_))
+{
+    _steal(other);
+}
+
+
+template <class T, class C, class A>
+clist<T, C, A>&
+clist<T, C, A>::operator=(const clist& other)
+{
+    if (this == &other) return *this;
+
+    clear();
+    comp_ = other.comp_;
+    for (const T& value : other)
+        emplace_back(value);
+    return *this;
+}
+
+
+template <class T, class C, class A>
+clist<T, C, A>&
+clist<T, C, A>::operator=(clist&& other)
+noexcept(node_traits::propagate_on_container_move_assignment::value
+         || node_traits::is_always_equal::value)
+{
+    if (this == &other) return *this;
+
+    clear();
+    comp_ = other.comp_;
+    if constexpr (node_traits::propagate_on_container_move_assignment::value)
+    {
+        alloc_ = std::move(other.alloc_);
+        _steal(other);
+    }
+    else if (alloc_ == other.alloc_)
+        _steal(other);
+    else
+    {
+        //Nodes can't be freed by a different allocator.  
+        for (T& value : other)
+            emplace_back(std::move(value));
+        other.clear();
+    }
+    return *this;
+}
+
+
+template <class T, class C, class A>
+clist<T, C, A>::~clist()
+{
+    clear();
+}
+
+
+template <class T, class C, class A>
+typename clist<T, C, A>::reference
+clist<T, C, A>::operator[](size_type index)
+{
+    return _node_at(index)->value;
+}
+
+
+template <class T, class C, class A>
+typename clist<T, C, A>::const_reference
+clist<T, C, A>::operator[](size_type index) const
+{
+    return _node_at_const(index)->value;
+}
+
+
+template <class T, class C, class A>
+typename clist<T, C, A>::reference
+clist<T, C, A>::at(size_type index)
+{
+    if (index >= size_)
+        throw std::out_of_range("clist::at: Index out of range!");
+    return _node_at(index)->value;
+}
+
+
+template <class T, class C, class A>
+typename clist<T, C, A>::const_reference
+clist<T, C, A>::at(size_type index) const
+{
+    if (index >= size_)
+        throw std::out_of_range("clist::at: Index out of range!");
+    return _node_at_const(index)->value;
+}
+
+
+template <class T, class C, class A>
+typename clist<T, C, A>::iterator
+clist<T, C, A>::iterator_at(size_type index)
+{
+    return iterator(index == size_ ? nullptr : _node_at(index), this);
+}
+
+
+template <class T, class C, class A>
+typename clist<T, C, A>::const_iterator
+clist<T, C, A>::iterator_at(size_type index) const
+{
+    return const_iterator(index == size_ ? nullptr : _node_at_const(index), this);
+}
+
+
+template <class T, class C, class A>
+template <class... Args>
+typename clist<T, C, A>::reference
+clist<T, C, A>::emplace_back(Args&&... args)
+{
+    _reserve_table(size_ + 1);
+    node* n = _new_node(std::forward<Args>(args)...);
+    _link_before(nullptr, n);
+    if (size_ - 1 == jt_valid_ * jt_increment)
+        jump_table_[jt_valid_++] = n;
+    return n->value;
+}
+
+
+template <class T, class C, class A>
+template <class... Args>
+typename clist<T, C, A>::reference
+clist<T, C, A>::emplace_front(Args&&... args)
+{
+    return emplace_at(0, std::forward<Args>(args)...);
+}
+
+
+template <class T, class C, class A>
+template <class... Args>
+typename clist<T, C, A>::iterator
+clist<T, C, A>::emplace(const_iterator pos, Args&&... args)
+{
+    if (pos.n_ == nullptr)
+    {
+        emplace_back(std::forward<Args>(args)...);
+        return iterator(tail_, this);
+    }
+
+    _reserve_table(size_ + 1);
+    node* n = _new_node(std::forward<Args>(args)...);
+    _link_before(pos.n_, n);
+    _invalidate_from(0);
+    current_ = nullptr;
+    return iterator(n, this);
+}
+
+
+template <class T, class C, class A>
+template <class... Args>
+typename clist<T, C, A>::reference
+clist<T, C, A>::emplace_at(size_type index, Args&&... args)
+{
+    if (index > size_)
+        throw std::out_of_range("clist::emplace_at: Index out of range!");
+    if (index == size_)
+        return emplace_back(std::forward<Args>(args)...);
+
+    _reserve_table(size_ + 1);
+    node* n = _new_node(std::forward<Args>(args)...);
+    node* next = _node_at(index);
+    _link_before(next, n);
+    _invalidate_from(index);
+    //The current node moved up by one.  
+    ++current_index_;
+    return n->value;
+}
+
+
+template <class T, class C, class A>
+typename clist<T, C, A>::iterator
+clist<T, C, A>::erase(const_iterator pos)
+{
+    node* next = pos.n_->next;
+    _unlink(pos.n_);
+    _invalidate_from(0);
+    current_ = nullptr;
+    return iterator(next, this);
+}
+
+
+template <class T, class C, class A>
+void
+clist<T, C, A>::erase_at(size_type index)
+{
+    if (index >= size_)
+        throw std::out_of_range("clist::erase_at: Index out of range!");
+
+    _unlink(_node_at(index));
+    _invalidate_from(index);
+    current_ = nullptr;
+}
+
+
+template <class T, class C, class A>
+void
+clist<T, C, A>::pop_back()
+{
+    if (current_ == tail_)
+        current_ = nullptr;
+    _unlink(tail_);
+    _invalidate_from(size_);
+}
+
+
+template <class T, class C, class A>
+void
+clist<T, C, A>::pop_front()
+{
+    if (current_ == head_)
+        current_ = nullptr;
+    else if (current_)
+        --current_index_;
+    _unlink(head_);
+    _invalidate_from(0);
+}
+
+
+template <class T, class C, class A>
+void
+clist<T, C, A>::clear() noexcept
+{
+    node* n = head_;
+    while (n != nullptr)
+    {
+        node* next = n->next;
+        _free_node(n);
+        n = next;
+    }
+    head_ = tail_ = current_ = nullptr;
+    size_ = current_index_ = jt_valid_ = 0;
+}
+
+
+template <class T, class C, class A>
+void
+clist<T, C, A>::sort()
+{
+    if (size_ < 2) return;
+
+    std::vector<node*, table_alloc> nodes{table_alloc(alloc_)};
+    nodes.reserve(size_);
+    for (node* n = head_; n != nullptr; n = n->next)
+        nodes.push_back(n);
+    std::stable_sort(nodes.begin(), nodes.end(),
+                     [this](const node* a, const node* b)
+                     { return comp_(a->value, b->value); });
+
+    //Relink in order, rebuilding the whole jump_table along the way.  
+    node* prev = nullptr;
+    for (size_type i = 0; i < size_; ++i)
+    {
+        node* n = nodes[i];
+        n->prev = prev;
+        if (prev)
+            prev->next = n;
+        if (i % jt_increment == 0)
+            jump_table_[i / jt_increment] = n;
+        prev = n;
+    }
+    prev->next = nullptr;
+    head_ = nodes[0];
+    tail_ = prev;
+    jt_valid_ = (size_ - 1) / jt_increment + 1;
+    current_ = nullptr;
+}
+
+
+template <class T, class C, class A>
+void
+clist<T, C, A>::swap(clist& other) noexcept
+{
+    using std::swap;
+    if constexpr (node_traits::propagate_on_container_swap::value)
+        swap(alloc_, other.alloc_);
+    swap(head_, other.head_);
+    swap(tail_, other.tail_);
+    swap(current_, other.current_);
+    swap(size_, other.size_);
+    swap(current_index_, other.current_index_);
+    swap(jt_valid_, other.jt_valid_);
+    swap(jump_table_, other.jump_table_);
+    swap(comp_, other.comp_);
+}
+
+
+/// Internal functions ///
+
+
+template <class T, class C, class A>
+template <class... Args>
+typename clist<T, C, A>::node*
+clist<T, C, A>::_new_node(Args&&... args)
+{
+    node* n = node_traits::allocate(alloc_, 1);
+    ::new (static_cast<void*>(n)) node;
+    try
+    {
+        node_traits::construct(alloc_, std::addressof(n->value),
+                               std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        n->~node();
+        node_traits::deallocate(alloc_, n, 1);
+        throw;
+    }
+    return n;
+}
+
+
+template <class T, class C, class A>
+void
+clist<T, C, A>::_free_node(node* n) noexcept
+{
+    node_traits::destroy(alloc_, std::addressof(n->value));
+    n->~node();
+    node_traits::deallocate(alloc_, n, 1);
+}
+
+
+template <class T, class C, class A>
+void
+clist<T, C, A>::_reserve_table(size_type size)
+{
+    size_type needed = (size - 1) / jt_increment + 1;
+    if (jump_table_.size() < needed)
+        jump_table_.resize(needed * 2);
+}
+
+
+template <class T, class C, class A>
+void
+clist<T, C, A>::_link_before(node* next, node* n) noexcept
+{
+    n->next = next;
+    n->prev = next ? next->prev : tail_;
+    if (n->prev)
+        n->prev->next = n;
+    else
+        head_ = n;
+    if (next)
+        next->prev = n;
+    else
+        tail_ = n;
+    ++size_;
+}
+
+
+template <class T, class C, class A>
+void
+clist<T, C, A>::_unlink(node* n) noexcept
+{
+    if (n->prev)
+        n->prev->next = n->next;
+    else
+        head_ = n->next;
+    if (n->next)
+        n->next->prev = n->prev;
+    else
+        tail_ = n->prev;
+    --size_;
+    _free_node(n);
+}
+
+
+template <class T, class C, class A>
+void
+clist<T, C, A>::_invalidate_from(size_type index) noexcept
+{
+    size_type valid = (index + jt_increment - 1) / jt_increment;
+    if (jt_valid_ > valid)
+        jt_valid_ = valid;
+}
+
+
+template <class T, class C, class A>
+typename clist<T, C, A>::node*
+clist<T, C, A>::_node_at(size_type index) noexcept
+{
+    if (jt_valid_ == 0)
+    {
+        jump_table_[0] = head_;
+        jt_valid_ = 1;
+    }
+    size_type entry = std::min(index / jt_increment, jt_valid_ - 1);
+    node* n = jump_table_[entry];
+    size_type at = entry * jt_increment;
+
+    if (current_)
+    {
+        size_type c = current_index_;
+        if ((c > index ? c - index : index - c) < index - at)
+        {
+            n = current_;
+            at = c;
+        }
+    }
+    if (size_ - 1 - index < (at > index ? at - index : index - at))
+    {
+        n = tail_;
+        at = size_ - 1;
+    }
+
+    for (; at < index; ++at)
+    {
+        n = n->next;
+        if (at + 1 == jt_valid_ * jt_increment)
+            jump_table_[jt_valid_++] = n;
+    }
+    for (; at > index; --at)
+        n = n->prev;
+
+    current_ = n;
+    current_index_ = index;
+    return n;
+}
+
+
+template <class T, class C, class A>
+typename clist<T, C, A>::node*
+clist<T, C, A>::_node_at_const(size_type index) const noexcept
+{
+    node* n = head_;
+    size_type at = 0;
+    if (jt_valid_ > 0)
+    {
+        size_type entry = std::min(index / jt_increment, jt_valid_ - 1);
+        n = jump_table_[entry];
+        at = entry * jt_increment;
+    }
+    if (current_)
+    {
+        size_type c = current_index_;
+        if ((c > index ? c - index : index - c) < index - at)
+        {
+            n = current_;
+            at = c;
+        }
+    }
+    if (size_ - 1 - index < (at > index ? at - index : index - at))
+    {
+        n = tail_;
+        at = size_ - 1;
+    }
+
+    for (; at < index; ++at)
+        n = n->next;
+    for (; at > index; --at)
+        n = n->prev;
+    return n;
+}
+
+
+template <class T, class C, class A>
+void
+clist<T, C, A>::_steal(clist& other) noexcept
+{
+    head_ = other.head_;
+    tail_ = other.tail_;
+    current_ = other.current_;
+    size_ = other.size_;
+    current_index_ = other.current_index_;
+    jt_valid_ = other.jt_valid_;
+    jump_table_ = std::move(other.jump_table_);
+    other.jump_table_.clear();
+
+    other.head_ = other.tail_ = other.current_ = nullptr;
+    other.size_ = other.current_index_ = other.jt_valid_ = 0;
+}
+
+
+#endif //CLIST_HPP
@@ -0,0 +1,1327 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_btree.h
+// Counted B+tree storage for clist.h.  Leaves hold arrays of values and inner
+// nodes hold the number of values below each child, so get, insert and
+// remove descend the tree in O(log n) without any jump_table to maintain.  
+// Nodes are reference counted so that list_clone_cow() can share the whole
+// tree, and are copied, root first, only once a list changes them.  
+// Selected by putting
+//     #define LIST_STORAGE LIST_STORAGE_BTREE
+// before including clist.h.  Not intended to be included directly.  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CLIST_BTREE_H
+#define CLIST_BTREE_H
+
+
+//Maximum number of values stored in a single leaf.  
+#ifndef LIST_BTREE_LEAF_CAPACITY
+#define LIST_BTREE_LEAF_CAPACITY 64
+#endif
+
+//Maximum number of children of a single inner node.  
+#ifndef LIST_BTREE_FANOUT
+#define LIST_BTREE_FANOUT 32
+#endif
+
+
+//Common header of leaves and inner nodes.  
+typedef struct _bnode _bnode;
+//Leaf, an array of values.  
+typedef struct _bleaf _bleaf;
+//Inner node, children and the number of values below each of them.  
+typedef struct _binner _binner;
+
+
+enum BtreeConstants
+{
+    //Deeper than any tree that fits in memory.  
+    BTREE_MAX_HEIGHT = 24
+};
+
+
+
+/// Internal functions ///
+
+
+
+/*
+Frees all memory associated with the list strucutre,
+but not the tree (if any).  
+*/
+HOF void
+_free_list_structures(list* l);
+
+/*
+Internal function that drops a reference to the subtree rooted at 'n', of
+height 'h'.  If it was the last one, frees it, with FREE_LIST_ITEMS its values
+if 'free_items' is set, and drops its references to its children.  Leaves
+have height 0.  
+*/
+HOF void
+_free_subtree(_bnode* n, unsigned h, int free_items);
+
+/*
+Internal function that returns the number of values below 'n'.  
+*/
+HOF lindex
+_bnode_size(const _bnode* n, unsigned h);
+
+/*
+Internal function that adds a reference to 'n'.  
+*/
+HOF void
+_bnode_retain(_bnode* n);
+
+/*
+Internal function that makes sure the node in '*slot', of height 'h', is only
+referenced by the list, replacing it by a copy if it is shared.  The parent
+holding 'slot' must already be the list's own.  Returns the node or NULL on
+allocation failure.  
+*/
+HOF _bnode*
+_btree_own(_bnode** slot, unsigned h);
+
+/*
+Internal function that makes every node on the path to 'index', which may be
+the size of the list, the list's own.  Returns the leaf containing 'index' and
+sets 'start' to the index of its first value, or returns NULL on allocation
+failure, in which case the list is unchanged apart from some of the path
+being copied.  
+*/
+HOF _bleaf*
+_btree_own_path(list* l, lindex index, lindex* start);
+
+/*
+Internal function that makes the 'depth' nodes along the last (or first, if
+'at_end' is 0) children from the root of the list's own.  Returns -1 on
+allocation failure, 0 otherwise.  
+*/
+HOF int
+_btree_own_spine(list* l, unsigned depth, int at_end);
+
+/*
+Internal function that makes sure the list holds a spare leaf and at least
+'inners' spare inner nodes, so that a following insert, split or merge can
+not fail half way through.  Returns -1 on allocation failure, 0 otherwise.  
+*/
+HOF int
+_list_reserve_nodes(list* l, unsigned inners);
+
+/*
+Internal functions that take a node from the list's spares.  
+*/
+HOF _bleaf*
+_take_leaf(list* l);
+
+HOF _binner*
+_take_inner(list* l);
+
+/*
+Internal function that inserts 'value' at 'index', which may be the size of
+the list.  
+*/
+HOF void
+_list_insert(list* l, lindex index, LIST_DATA_TYPE value);
+
+/*
+Internal function that returns the leaf containing 'index' and sets 'start'
+to the index of its first value.  
+*/
+HOF _bleaf*
+_btree_leaf_at(const list* l, lindex index, lindex* start);
+
+/*
+Internal function that returns the child of 'n' containing 'index', or the
+last child if 'index' is the size of 'n'.  Subtracts the sizes of the
+children before it from 'index'.  
+*/
+HOF unsigned
+_btree_child_at(const _binner* n, lindex* index);
+
+/*
+Internal function that inserts 'value' at 'index' below 'n'.  Returns the new
+right sibling of 'n' if it had to be split, otherwise NULL.  
+*/
+HOF _bnode*
+_btree_insert(list* l, _bnode* n, unsigned h, lindex index,
+              LIST_DATA_TYPE value);
+
+/*
+Internal function that inserts 'child', holding 'size' values, at position
+'pos' of 'n'.  Returns the new right sibling of 'n' if it had to be split,
+otherwise NULL.  
+*/
+HOF _bnode*
+_binner_insert_child(list* l, _binner* n, unsigned pos,
+                     _bnode* child, lindex size);
+
+/*
+Internal function that removes and returns the value at 'index' below 'n'.  
+*/
+HOF LIST_DATA_TYPE
+_btree_remove(_bnode* n, unsigned h, lindex index);
+
+/*
+Internal function that merges child 'ci' of 'n', of height 'ch', with a
+neighbour, or moves values over from it, if the child is under a quarter
+full.  Both children are made the list's own first, if that fails they are
+left as they are.  
+*/
+HOF void
+_btree_fix_underflow(_binner* n, unsigned ci, unsigned ch);
+
+/*
+Internal function that adds the subtree 'sub', of height 'sh' and holding
+'size' values, as the last (or first, if 'at_end' is 0) values below 'n',
+which is higher than 'sub'.  Returns the new right sibling of 'n' if it had
+to be split, otherwise NULL.  
+*/
+HOF _bnode*
+_btree_add_subtree(list* l, _bnode* n, unsigned h, _bnode* sub,
+                   unsigned sh, lindex size, int at_end);
+
+/*
+Internal function that moves the values below 'n' from 'index' onward into
+a new subtree of the same height, which is returned.  'index' must be
+greater than 0 and less than the size of 'n'.  
+*/
+HOF _bnode*
+_btree_split(list* l, _bnode* n, unsigned h, lindex index);
+
+/*
+Internal function that replaces a root with a single child by that child,
+and an empty root leaf by nothing.  
+*/
+HOF void
+_list_trim_root(list* l);
+
+
+struct _bnode
+{
+    unsigned count;
+    //Number of parents and lists referring to the node.  
+    unsigned refs;
+};
+
+struct _bleaf
+{
+    _bnode         base;
+    LIST_DATA_TYPE values[LIST_BTREE_LEAF_CAPACITY];
+};
+
+struct _binner
+{
+    _bnode  base;
+    lindex  sizes[LIST_BTREE_FANOUT];
+    _bnode* children[LIST_BTREE_FANOUT];
+};
+
+struct list
+{
+    lindex    size;
+    unsigned  height;
+    _bnode*   root;
+    //Leaf of the last lookup, so walking the list doesn't descend each time.  
+    _bleaf*   current;
+    lindex    current_index;
+    //Whether every node on the path to current is the list's own.  
+    int       current_owned;
+    //Whether any node may be shared with a clone, see list_clone_cow().  
+    int       shared;
+    //Nodes allocated ahead of a structural change.  
+    _bleaf*   spare_leaf;
+    unsigned  spare_count;
+    _binner*  spare_inners[BTREE_MAX_HEIGHT];
+};
+
+
+#define _LEAF(n)  ((_bleaf*)(n))
+#define _INNER(n) ((_binner*)(n))
+
+
+
+static inline list*
+new_list(void)
+{
+    return (list*)calloc(1, sizeof(list));
+}
+
+
+static inline void
+free_list(list* l)
+{
+    if (!l) return;
+
+    if (l->root)
+        _free_subtree(l->root, l->height, 1);
+    _free_list_structures(l);
+}
+
+
+static inline void
+list_add(list* l, LIST_DATA_TYPE value)
+{
+    if (NULL_ARG_ERROR(l)) return;
+
+    _list_add(l, value);
+}
+
+
+static inline LIST_DATA_TYPE
+list_pop(list* l)
+{
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (SIZE_ERROR(l)) return ERROR_RETURN_VALUE;
+
+    return list_remove(l, l->size - 1);
+}
+
+
+static inline LIST_DATA_TYPE
+list_get(list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (INDEX_ERROR(l, index)) return ERROR_RETURN_VALUE;
+
+    return *_list_ref_at(l, index);
+}
+
+
+static inline LIST_DATA_TYPE
+list_get_const(const list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (INDEX_ERROR(l, index)) return ERROR_RETURN_VALUE;
+
+    lindex start;
+    _bleaf* leaf = _btree_leaf_at(l, index, &start);
+    return leaf->values[index - start];
+}
+
+
+static inline LIST_DATA_TYPE*
+list_get_ref(list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    if (INDEX_ERROR(l, index)) return NULL;
+
+    return _list_mut_ref_at(l, index);
+}
+
+
+static inline void
+list_insert(list* l, lindex index, LIST_DATA_TYPE value)
+{
+    if (NULL_ARG_ERROR(l)) return;
+    if (l->size > 0 && INDEX_ERROR(l, index)) return;
+
+    _list_insert(l, l->size > 0 ? index : 0, value);
+}
+
+
+static inline LIST_DATA_TYPE
+list_remove(list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (INDEX_ERROR(l, index)) return ERROR_RETURN_VALUE;
+
+    lindex start;
+    if (l->shared && !_btree_own_path(l, index, &start))
+    {
+        ALLOC_ERROR(NULL);
+        return ERROR_RETURN_VALUE;
+    }
+
+    LIST_DATA_TYPE value = _btree_remove(l->root, l->height, index);
+    --(l->size);
+    l->current = NULL;
+    _list_trim_root(l);
+    return value;
+}
+
+
+static inline lindex
+list_size(const list* l)
+{
+    if (NULL_ARG_ERROR(l)) return INDEX_ERR_RETURN_VALUE;
+
+    return l->size;
+}
+
+
+static inline void
+sort_list(list* l)
+{
+    if (NULL_ARG_ERROR(l)) return;
+    if (l->size < 2) return;
+
+    //Leaf fill counts don't depend on the values, so sort a copy and write it
+    //back into the same leaves.  
+    LIST_DATA_TYPE* values = (LIST_DATA_TYPE*)malloc(l->size * sizeof(LIST_DATA_TYPE));
+    LIST_DATA_TYPE* tmp = (LIST_DATA_TYPE*)malloc(l->size * sizeof(LIST_DATA_TYPE));
+    if (!values || !tmp)
+    {
+        free(values);
+        free(tmp);
+        ALLOC_ERROR(NULL);
+        return;
+    }
+
+    //Leaves shared with clones are copied before anything is written.  
+    lindex i, start;
+    _bleaf* leaf;
+    for (i = 0; i < l->size; i += leaf->base.count)
+    {
+        leaf = _btree_own_path(l, i, &start);
+        if (!leaf)
+        {
+            free(values);
+            free(tmp);
+            ALLOC_ERROR(NULL);
+            return;
+        }
+        memcpy(&values[i], leaf->values, leaf->base.count * sizeof(LIST_DATA_TYPE));
+    }
+
+    _merge_sort_values(values, tmp, l->size);
+
+    for (i = 0; i < l->size; i += leaf->base.count)
+    {
+        leaf = _btree_leaf_at(l, i, &start);
+        memcpy(leaf->values, &values[i], leaf->base.count * sizeof(LIST_DATA_TYPE));
+    }
+
+    free(values);
+    free(tmp);
+}
+
+
+static inline list*
+list_where(list* l, filter_func filter)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    list* new_collection = new_list();
+    if (ALLOC_ERROR(new_collection)) return NULL;
+
+    lindex i, start;
+    _bleaf* leaf;
+    for (i = 0; i < l->size; i += leaf->base.count)
+    {
+        leaf = _btree_leaf_at(l, i, &start);
+        unsigned j;
+        for (j = 0; j < leaf->base.count; ++j)
+        {
+            if (filter(leaf->values[j]))
+                list_add(new_collection, leaf->values[j]);
+        }
+    }
+
+    return new_collection;
+}
+
+
+static inline void
+list_merge(list* first, list* second)
+{
+    if (NULL_ARG_ERROR(first)) return;
+    if (second == NULL || second->size == 0) return;
+
+    unsigned height = first->height > second->height ? first->height
+                                                     : second->height;
+    if (_list_reserve_nodes(first, height + 1))
+    {
+        ALLOC_ERROR(NULL);
+        return;
+    }
+
+    //The taller tree takes the other one in along its spine, down to the
+    //level above the other root and the node next to it.  
+    int failed = 0;
+    if (first->root && (first->shared || second->shared))
+    {
+        if (first->height > second->height)
+            failed = _btree_own_spine(first, first->height - second->height + 1, 1);
+        else if (first->height < second->height)
+            failed = _btree_own_spine(second, second->height - first->height + 1, 0);
+    }
+    if (failed)
+    {
+        ALLOC_ERROR(NULL);
+        return;
+    }
+
+    _bnode* root = second->root;
+    unsigned h = second->height;
+    lindex size = second->size;
+    first->shared |= second->shared;
+    second->root = NULL;
+    second->size = 0;
+    _free_list_structures(second);
+
+    first->current = NULL;
+    if (!first->root)
+    {
+        first->root = root;
+        first->height = h;
+        first->size = size;
+        return;
+    }
+
+    //Join the shorter tree into the spine of the taller one.  The sibling of
+    //a split keeps the right half, so the new root's children are in order
+    //either way.  
+    _bnode* left = first->root;
+    _bnode* right = root;
+    _bnode* sibling = right;
+    if (first->height > h)
+        sibling = _btree_add_subtree(first, left, first->height, right, h, size, 1);
+    else if (first->height < h)
+    {
+        sibling = _btree_add_subtree(first, right, h, left, first->height,
+                                     first->size, 0);
+        left = right;
+        first->height = h;
+    }
+
+    first->size += size;
+    first->root = left;
+    if (sibling)
+    {
+        _binner* new_root = _take_inner(first);
+        lindex right_size = _bnode_size(sibling, first->height);
+        new_root->base.count = 2;
+        new_root->children[0] = left;
+        new_root->sizes[0] = first->size - right_size;
+        new_root->children[1] = sibling;
+        new_root->sizes[1] = right_size;
+        first->root = &new_root->base;
+        ++(first->height);
+    }
+}
+
+
+static inline list*
+list_split(list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    if (INDEX_ERROR(l, index)) return NULL;
+
+    list* nl = new_list();
+    if (ALLOC_ERROR(nl)) return NULL;
+    if (index == 0)
+        return nl;
+
+    lindex start;
+    if (_list_reserve_nodes(l, l->height) ||
+        (l->shared && !_btree_own_path(l, index, &start)))
+    {
+        ALLOC_ERROR(NULL);
+        free_list(nl);
+        return NULL;
+    }
+
+    nl->root = _btree_split(l, l->root, l->height, index);
+    nl->height = l->height;
+    nl->size = l->size - index;
+    nl->shared = l->shared;
+    l->size = index;
+    l->current = NULL;
+
+    _list_trim_root(l);
+    _list_trim_root(nl);
+    return nl;
+}
+
+
+static inline list*
+list_split_where(list* l, filter_func filter)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    list* nl = new_list();
+    list* kept = new_list();
+    if (ALLOC_ERROR(nl) || ALLOC_ERROR(kept))
+    {
+        free_list(nl);
+        free_list(kept);
+        return NULL;
+    }
+
+    lindex i, start;
+    _bleaf* leaf;
+    for (i = 0; i < l->size; i += leaf->base.count)
+    {
+        leaf = _btree_leaf_at(l, i, &start);
+        unsigned j;
+        for (j = 0; j < leaf->base.count; ++j)
+        {
+            if (filter(leaf->values[j]))
+                list_add(nl, leaf->values[j]);
+            else
+                list_add(kept, leaf->values[j]);
+        }
+    }
+
+    //Swap the rebuilt tree of kept values into l, the values themselves
+    //now belong to the new trees.  
+    if (l->root)
+        _free_subtree(l->root, l->height, 0);
+    l->root = kept->root;
+    l->height = kept->height;
+    l->size = kept->size;
+    l->current = NULL;
+    l->shared = 0;
+    _free_list_structures(kept);
+
+    return nl;
+}
+
+
+
+static inline LIST_DATA_TYPE*
+_list_ref_at(list* l, lindex index)
+{
+    _bleaf* leaf = l->current;
+    if (!leaf || index < l->current_index ||
+        index - l->current_index >= leaf->base.count)
+    {
+        leaf = _btree_leaf_at(l, index, &l->current_index);
+        l->current = leaf;
+        l->current_owned = !l->shared;
+    }
+    return &leaf->values[index - l->current_index];
+}
+
+
+static inline LIST_DATA_TYPE*
+_list_mut_ref_at(list* l, lindex index)
+{
+    _bleaf* leaf = l->current;
+    if (!leaf || !l->current_owned || index < l->current_index ||
+        index - l->current_index >= leaf->base.count)
+    {
+        lindex start;
+        leaf = _btree_own_path(l, index, &start);
+        if (ALLOC_ERROR(leaf)) return NULL;
+        l->current = leaf;
+        l->current_index = start;
+        l->current_owned = 1;
+    }
+    return &leaf->values[index - l->current_index];
+}
+
+
+#if !FREE_LIST_ITEMS
+static inline list*
+list_clone_cow(list* l)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    list* nl = new_list();
+    if (ALLOC_ERROR(nl)) return NULL;
+
+    //Both lists now refer to every node, so neither may write to the tree
+    //before copying the path it writes to.  
+    if (l->root)
+        _bnode_retain(l->root);
+    nl->root = l->root;
+    nl->height = l->height;
+    nl->size = l->size;
+    nl->shared = 1;
+    l->shared = 1;
+    l->current_owned = 0;
+    return nl;
+}
+#endif
+
+
+static inline void
+_list_add(list* l, LIST_DATA_TYPE value)
+{
+    _list_insert(l, l->size, value);
+}
+
+
+static inline int
+_list_append_values(list* l, LIST_DATA_TYPE* values, lindex count)
+{
+    //Every value is placed in O(log n), so they are added one at a time.  
+    lindex size = l->size;
+    lindex i = 0;
+    for (; i < count; ++i)
+    {
+        _list_insert(l, l->size, values[i]);
+        if (l->size != size + i + 1)
+        {
+            _list_truncate(l, size);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+static inline int
+_list_copy_values(list* from, list* to, lindex start, lindex end)
+{
+    lindex size = to->size;
+    lindex i = start;
+    for (; i < end; ++i)
+    {
+        //Read before adding, as 'to' may be 'from'.  
+        LIST_DATA_TYPE value = *_list_ref_at(from, i);
+        _list_insert(to, to->size, value);
+        if (to->size != size + (i - start) + 1)
+        {
+            _list_truncate(to, size);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+static inline void
+_list_erase(list* l, lindex start, lindex end, int free_items)
+{
+    if (start == end) return;
+
+    //The range is split off both ends of the tree and the tail is merged
+    //back, each in O(log n).  
+    list* tail = NULL;
+    if (end < l->size)
+    {
+        tail = list_split(l, end);
+        if (!tail) return;
+    }
+
+    if (start > 0)
+    {
+        list* range = list_split(l, start);
+        if (range)
+        {
+            _free_subtree(range->root, range->height, free_items);
+            _free_list_structures(range);
+        }
+    }
+    else
+    {
+        _free_subtree(l->root, l->height, free_items);
+        l->root = NULL;
+        l->height = 0;
+        l->size = 0;
+        l->shared = 0;
+        l->current = NULL;
+    }
+
+    if (tail)
+    {
+        lindex size = l->size + tail->size;
+        list_merge(l, tail);
+        //The merge already reported the failure, the tail can't be kept.  
+        if (l->size != size)
+            free_list(tail);
+    }
+}
+
+
+static inline void
+_list_retain(list* l, filter_func filter, int keep)
+{
+    if (l->size == 0) return;
+
+    //Kept values are gathered at the front of the buffer and the others at
+    //the back, so nothing is freed before the new tree is built.  
+    LIST_DATA_TYPE* values =
+        (LIST_DATA_TYPE*)malloc(l->size * sizeof(LIST_DATA_TYPE));
+    list* kept = new_list();
+    if (ALLOC_ERROR(values) || ALLOC_ERROR(kept))
+    {
+        free(values);
+        free_list(kept);
+        return;
+    }
+
+    lindex count = 0, removed = l->size;
+    lindex i, start;
+    _bleaf* leaf;
+    for (i = 0; i < l->size; i += leaf->base.count)
+    {
+        leaf = _btree_leaf_at(l, i, &start);
+        unsigned j;
+        for (j = 0; j < leaf->base.count; ++j)
+        {
+            if (!filter(leaf->values[j]) == !keep)
+                values[count++] = leaf->values[j];
+            else
+                values[--removed] = leaf->values[j];
+        }
+    }
+
+    if (_list_append_values(kept, values, count))
+    {
+        free(values);
+        free_list(kept);
+        return;
+    }
+    #if FREE_LIST_ITEMS
+        for (i = removed; i < l->size; ++i)
+            free(values[i]);
+    #endif
+    free(values);
+
+    //Swap the rebuilt tree into l as list_split_where does.  
+    if (l->root)
+        _free_subtree(l->root, l->height, 0);
+    l->root = kept->root;
+    l->height = kept->height;
+    l->size = kept->size;
+    l->current = NULL;
+    l->shared = 0;
+    _free_list_structures(kept);
+}
+
+
+static inline void
+_list_read_values(list* l, LIST_DATA_TYPE* values)
+{
+    lindex i, start;
+    _bleaf* leaf;
+    for (i = 0; i < l->size; i += leaf->base.count)
+    {
+        leaf = _btree_leaf_at(l, i, &start);
+        memcpy(&values[i], leaf->values, leaf->base.count * sizeof(LIST_DATA_TYPE));
+    }
+}
+
+
+static inline void
+_free_list_structures(list* l)
+{
+    free(l->spare_leaf);
+    unsigned i;
+    for (i = 0; i < l->spare_count; ++i)
+        free(l->spare_inners[i]);
+    free(l);
+}
+
+
+static inline void
+_free_subtree(_bnode* n, unsigned h, int free_items)
+{
+    if (__atomic_sub_fetch(&n->refs, 1, __ATOMIC_ACQ_REL) != 0) return;
+
+    unsigned i;
+    if (h == 0)
+    {
+        #if FREE_LIST_ITEMS
+            for (i = 0; free_items && i < n->count; ++i)
+                free(_LEAF(n)->values[i]);
+        #endif
+        (void)free_items;
+    }
+    else
+    {
+        for (i = 0; i < n->count; ++i)
+            _free_subtree(_INNER(n)->children[i], h - 1, free_items);
+    }
+    free(n);
+}
+
+
+static inline lindex
+_bnode_size(const _bnode* n, unsigned h)
+{
+    if (h == 0) return n->count;
+
+    lindex size = 0;
+    unsigned i;
+    for (i = 0; i < n->count; ++i)
+        size += _INNER(n)->sizes[i];
+    return size;
+}
+
+
+static inline void
+_bnode_retain(_bnode* n)
+{
+    __atomic_add_fetch(&n->refs, 1, __ATOMIC_RELAXED);
+}
+
+
+static inline _bnode*
+_btree_own(_bnode** slot, unsigned h)
+{
+    _bnode* n = *slot;
+    if (__atomic_load_n(&n->refs, __ATOMIC_ACQUIRE) == 1) return n;
+
+    size_t bytes = h == 0 ? sizeof(_bleaf) : sizeof(_binner);
+    _bnode* copy = (_bnode*)malloc(bytes);
+    if (!copy) return NULL;
+
+    memcpy(copy, n, bytes);
+    copy->refs = 1;
+    unsigned i;
+    for (i = 0; h > 0 && i < n->count; ++i)
+        _bnode_retain(_INNER(n)->children[i]);
+    //Still referenced by whoever shares it, so only the node itself goes.  
+    _free_subtree(n, h, 0);
+    *slot = copy;
+    return copy;
+}
+
+
+static inline _bleaf*
+_btree_own_path(list* l, lindex index, lindex* start)
+{
+    if (!l->shared) return _btree_leaf_at(l, index, start);
+
+    *start = index;
+    _bnode** slot = &l->root;
+    unsigned h;
+    for (h = l->height; ; --h)
+    {
+        _bnode* n = _btree_own(slot, h);
+        if (!n)
+        {
+            l->current = NULL;
+            return NULL;
+        }
+        if (h == 0) break;
+        slot = &_INNER(n)->children[_btree_child_at(_INNER(n), &index)];
+    }
+
+    //l->current may have been one of the nodes copied.  
+    l->current = NULL;
+    *start -= index;
+    return _LEAF(*slot);
+}
+
+
+static inline int
+_btree_own_spine(list* l, unsigned depth, int at_end)
+{
+    _bnode** slot = &l->root;
+    unsigned h = l->height;
+    for (; depth > 0; --depth, --h)
+    {
+        _bnode* n = _btree_own(slot, h);
+        if (!n) return -1;
+        if (h == 0) break;
+        slot = &_INNER(n)->children[at_end ? n->count - 1 : 0];
+    }
+    l->current = NULL;
+    return 0;
+}
+
+
+static inline int
+_list_reserve_nodes(list* l, unsigned inners)
+{
+    if (!l->spare_leaf)
+    {
+        l->spare_leaf = (_bleaf*)malloc(sizeof(_bleaf));
+        if (!l->spare_leaf) return -1;
+    }
+
+    while (l->spare_count < inners)
+    {
+        _binner* n = (_binner*)malloc(sizeof(_binner));
+        if (!n) return -1;
+        l->spare_inners[l->spare_count++] = n;
+    }
+    return 0;
+}
+
+
+static inline _bleaf*
+_take_leaf(list* l)
+{
+    _bleaf* leaf = l->spare_leaf;
+    l->spare_leaf = NULL;
+    leaf->base.count = 0;
+    leaf->base.refs = 1;
+    return leaf;
+}
+
+
+static inline _binner*
+_take_inner(list* l)
+{
+    _binner* n = l->spare_inners[--(l->spare_count)];
+    n->base.count = 0;
+    n->base.refs = 1;
+    return n;
+}
+
+
+static inline void
+_list_insert(list* l, lindex index, LIST_DATA_TYPE value)
+{
+    //Every node on the path may split, and the root gains a parent.  
+    lindex start;
+    if (_list_reserve_nodes(l, l->height + 1) ||
+        (l->shared && l->root && !_btree_own_path(l, index, &start)))
+    {
+        ALLOC_ERROR(NULL);
+        return;
+    }
+
+    if (!l->root)
+    {
+        l->root = &_take_leaf(l)->base;
+        l->height = 0;
+    }
+
+    _bnode* sibling = _btree_insert(l, l->root, l->height, index, value);
+    if (sibling)
+    {
+        //The root was split, the tree grows by a level.  
+        _binner* root = _take_inner(l);
+        lindex right = _bnode_size(sibling, l->height);
+        root->base.count = 2;
+        root->children[0] = l->root;
+        root->sizes[0] = l->size + 1 - right;
+        root->children[1] = sibling;
+        root->sizes[1] = right;
+        l->root = &root->base;
+        ++(l->height);
+    }
+
+    ++(l->size);
+    l->current = NULL;
+}
+
+
+static inline _bleaf*
+_btree_leaf_at(const list* l, lindex index, lindex* start)
+{
+    *start = index;
+    _bnode* n = l->root;
+    unsigned h;
+    for (h = l->height; h > 0; --h)
+        n = _INNER(n)->children[_btree_child_at(_INNER(n), &index)];
+
+    *start -= index;
+    return _LEAF(n);
+}
+
+
+static inline unsigned
+_btree_child_at(const _binner* n, lindex* index)
+{
+    unsigned i = 0;
+    while (i + 1 < n->base.count && *index >= n->sizes[i])
+    {
+        *index -= n->sizes[i];
+        ++i;
+    }
+    return i;
+}
+
+
+static inline _bnode*
+_btree_insert(list* l, _bnode* n, unsigned h, lindex index,
+              LIST_DATA_TYPE value)
+{
+    if (h > 0)
+    {
+        //Appends go into the last child, everything else into the child
+        //holding the value currently at 'index'.  
+        _binner* in = _INNER(n);
+        unsigned ci = _btree_child_at(in, &index);
+        ++(in->sizes[ci]);
+
+        _bnode* sibling = _btree_insert(l, in->children[ci], h - 1, index, value);
+        if (!sibling) return NULL;
+
+        lindex size = _bnode_size(sibling, h - 1);
+        in->sizes[ci] -= size;
+        return _binner_insert_child(l, in, ci + 1, sibling, size);
+    }
+
+    _bleaf* leaf = _LEAF(n);
+    _bleaf* sibling = NULL;
+    if (n->count == LIST_BTREE_LEAF_CAPACITY)
+    {
+        //Appending leaves full leaves behind, anything else splits in half.  
+        unsigned keep = index == n->count ? n->count : n->count / 2;
+        sibling = _take_leaf(l);
+        sibling->base.count = n->count - keep;
+        memcpy(sibling->values, &leaf->values[keep],
+               sibling->base.count * sizeof(LIST_DATA_TYPE));
+        n->count = keep;
+
+        if (index >= keep)
+        {
+            index -= keep;
+            leaf = sibling;
+        }
+    }
+
+    memmove(&leaf->values[index+1], &leaf->values[index],
+            (leaf->base.count - index) * sizeof(LIST_DATA_TYPE));
+    leaf->values[index] = value;
+    ++(leaf->base.count);
+    return sibling ? &sibling->base : NULL;
+}
+
+
+static inline _bnode*
+_binner_insert_child(list* l, _binner* n, unsigned pos,
+                     _bnode* child, lindex size)
+{
+    _binner* sibling = NULL;
+    if (n->base.count == LIST_BTREE_FANOUT)
+    {
+        unsigned keep = pos == n->base.count ? n->base.count
+                                             : n->base.count / 2;
+        sibling = _take_inner(l);
+        sibling->base.count = n->base.count - keep;
+        memcpy(sibling->children, &n->children[keep],
+               sibling->base.count * sizeof(_bnode*));
+        memcpy(sibling->sizes, &n->sizes[keep],
+               sibling->base.count * sizeof(lindex));
+        n->base.count = keep;
+
+        if (pos >= keep)
+        {
+            pos -= keep;
+            n = sibling;
+        }
+    }
+
+    memmove(&n->children[pos+1], &n->children[pos],
+            (n->base.count - pos) * sizeof(_bnode*));
+    memmove(&n->sizes[pos+1], &n->sizes[pos],
+            (n->base.count - pos) * sizeof(lindex));
+    n->children[pos] = child;
+    n->sizes[pos] = size;
+    ++(n->base.count);
+    return sibling ? &sibling->base : NULL;
+}
+
+
+static inline LIST_DATA_TYPE
+_btree_remove(_bnode* n, unsigned h, lindex index)
+{
+    if (h == 0)
+    {
+        _bleaf* leaf = _LEAF(n);
+        LIST_DATA_TYPE value = leaf->values[index];
+        --(n->count);
+        memmove(&leaf->values[index], &leaf->values[index+1],
+                (n->count - index) * sizeof(LIST_DATA_TYPE));
+        return value;
+    }
+
+    _binner* in = _INNER(n);
+    unsigned ci = _btree_child_at(in, &index);
+    --(in->sizes[ci]);
+    LIST_DATA_TYPE value = _btree_remove(in->children[ci], h - 1, index);
+    _btree_fix_underflow(in, ci, h - 1);
+    return value;
+}
+
+
+static inline void
+_btree_fix_underflow(_binner* n, unsigned ci, unsigned ch)
+{
+    unsigned capacity = ch == 0 ? LIST_BTREE_LEAF_CAPACITY : LIST_BTREE_FANOUT;
+    if (n->children[ci]->count >= capacity / 4 || n->base.count < 2) return;
+
+    unsigned li = ci + 1 < n->base.count ? ci : ci - 1;
+    _bnode* left = _btree_own(&n->children[li], ch);
+    _bnode* right = left ? _btree_own(&n->children[li+1], ch) : NULL;
+    if (!right) return;
+    unsigned total = left->count + right->count;
+
+    //Number of entries moving from the right node to the left one, negative
+    //if they move the other way.  
+    int moved = total <= capacity ? (int)right->count
+                                  : (int)(total / 2) - (int)left->count;
+    if (moved == 0) return;
+
+    if (ch == 0)
+    {
+        _bleaf* ll = _LEAF(left);
+        _bleaf* rl = _LEAF(right);
+        if (moved > 0)
+        {
+            memcpy(&ll->values[left->count], rl->values,
+                   moved * sizeof(LIST_DATA_TYPE));
+            memmove(rl->values, &rl->values[moved],
+                    (right->count - moved) * sizeof(LIST_DATA_TYPE));
+        }
+        else
+        {
+            memmove(&rl->values[-moved], rl->values,
+                    right->count * sizeof(LIST_DATA_TYPE));
+            memcpy(rl->values, &ll->values[(int)left->count + moved],
+                   -moved * sizeof(LIST_DATA_TYPE));
+        }
+        n->sizes[li] += moved;
+        n->sizes[li+1] -= moved;
+    }
+    else
+    {
+        _binner* lin = _INNER(left);
+        _binner* rin = _INNER(right);
+        lindex moved_size = 0;
+        int i;
+        if (moved > 0)
+        {
+            for (i = 0; i < moved; ++i)
+                moved_size += rin->sizes[i];
+            memcpy(&lin->children[left->count], rin->children,
+                   moved * sizeof(_bnode*));
+            memcpy(&lin->sizes[left->count], rin->sizes,
+                   moved * sizeof(lindex));
+            memmove(rin->children, &rin->children[moved],
+                    (right->count - moved) * sizeof(_bnode*));
+            memmove(rin->sizes, &rin->sizes[moved],
+                    (right->count - moved) * sizeof(lindex));
+            n->sizes[li] += moved_size;
+            n->sizes[li+1] -= moved_size;
+        }
+        else
+        {
+            unsigned from = (unsigned)((int)left->count + moved);
+            for (i = 0; i < -moved; ++i)
+                moved_size += lin->sizes[from + i];
+            memmove(&rin->children[-moved], rin->children,
+                    right->count * sizeof(_bnode*));
+            memmove(&rin->sizes[-moved], rin->sizes,
+                    right->count * sizeof(lindex));
+            memcpy(rin->children, &lin->children[from],
+                   -moved * sizeof(_bnode*));
+            memcpy(rin->sizes, &lin->sizes[from],
+                   -moved * sizeof(lindex));
+            n->sizes[li] -= moved_size;
+            n->sizes[li+1] += moved_size;
+        }
+    }
+    left->count += moved;
+    right->count -= moved;
+
+    //Everything fit in the left node, drop the right one.  
+    if (right->count == 0)
+    {
+        free(right);
+        memmove(&n->children[li+1], &n->children[li+2],
+                (n->base.count - li - 2) * sizeof(_bnode*));
+        memmove(&n->sizes[li+1], &n->sizes[li+2],
+                (n->base.count - li - 2) * sizeof(lindex));
+        --(n->base.count);
+    }
+}
+
+
+static inline _bnode*
+_btree_add_subtree(list* l, _bnode* n, unsigned h, _bnode* sub,
+                   unsigned sh, lindex size, int at_end)
+{
+    _binner* in = _INNER(n);
+    unsigned ci = at_end ? n->count - 1 : 0;
+
+    if (h == sh + 1)
+    {
+        //A small leaf is folded into its neighbour instead of being added.  
+        _bleaf* neighbour = _LEAF(in->children[ci]);
+        if (sh == 0 && neighbour->base.count + sub->count <= LIST_BTREE_LEAF_CAPACITY)
+        {
+            if (at_end)
+                memcpy(&neighbour->values[neighbour->base.count], _LEAF(sub)->values,
+                       sub->count * sizeof(LIST_DATA_TYPE));
+            else
+            {
+                memmove(&neighbour->values[sub->count], neighbour->values,
+                        neighbour->base.count * sizeof(LIST_DATA_TYPE));
+                memcpy(neighbour->values, _LEAF(sub)->values,
+                       sub->count * sizeof(LIST_DATA_TYPE));
+            }
+            neighbour->base.count += sub->count;
+            in->sizes[ci] += size;
+            //The values are copied, a clone may still refer to the leaf.  
+            _free_subtree(sub, 0, 0);
+            return NULL;
+        }
+
+        return _binner_insert_child(l, in, at_end ? n->count : 0, sub, size);
+    }
+
+    in->sizes[ci] += size;
+    _bnode* sibling = _btree_add_subtree(l, in->children[ci], h - 1, sub,
+                                         sh, size, at_end);
+    if (!sibling) return NULL;
+
+    lindex sibling_size = _bnode_size(sibling, h - 1);
+    in->sizes[ci] -= sibling_size;
+    return _binner_insert_child(l, in, ci + 1, sibling, sibling_size);
+}
+
+
+static inline _bnode*
+_btree_split(list* l, _bnode* n, unsigned h, lindex index)
+{
+    if (h == 0)
+    {
+        _bleaf* right = _take_leaf(l);
+        right->base.count = n->count - (unsigned)index;
+        memcpy(right->values, &_LEAF(n)->values[index],
+               right->base.count * sizeof(LIST_DATA_TYPE));
+        n->count = (unsigned)index;
+        return &right->base;
+    }
+
+    //The child holding 'index' is split in two unless 'index' is its first
+    //value, in which case it moves to the right side whole.  
+    _binner* in = _INNER(n);
+    unsigned ci = _btree_child_at(in, &index);
+    _bnode* child_right = in->children[ci];
+    if (index > 0)
+        child_right = _btree_split(l, in->children[ci], h - 1, index);
+
+    _binner* right = _take_inner(l);
+    right->base.count = in->base.count - ci;
+    right->children[0] = child_right;
+    right->sizes[0] = in->sizes[ci] - index;
+    memcpy(&right->children[1], &in->children[ci+1],
+           (right->base.count - 1) * sizeof(_bnode*));
+    memcpy(&right->sizes[1], &in->sizes[ci+1],
+           (right->base.count - 1) * sizeof(lindex));
+
+    in->base.count = index > 0 ? ci + 1 : ci;
+    in->sizes[ci] = index;
+
+    //Only the nodes along the split path can have been left underfull.  
+    _btree_fix_underflow(in, in->base.count - 1, h - 1);
+    _btree_fix_underflow(right, 0, h - 1);
+    return &right->base;
+}
+
+
+static inline void
+_list_trim_root(list* l)
+{
+    while (l->height > 0 && l->root->count == 1)
+    {
+        _bnode* child = _INNER(l->root)->children[0];
+        _bnode_retain(child);
+        _free_subtree(l->root, l->height, 0);
+        l->root = child;
+        --(l->height);
+    }
+
+    if (l->root && l->root->count == 0)
+    {
+        _free_subtree(l->root, 0, 0);
+        l->root = NULL;
+        l->height = 0;
+    }
+}
+
+
+#endif
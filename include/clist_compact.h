@@ -0,0 +1,1125 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_compact.h
+// Compact node storage for clist.h.  Nodes live in one contiguous arena per
+// list and link to each other by 32 bit positions in that arena instead of
+// pointers, as do the jump_table and l->current.  This halves the node size
+// for small value types and, since the arena holds no pointers, lets the
+// whole list be moved with a single realloc/memcpy.  Lists are limited to
+// UINT32_MAX - 1 nodes.  Selected by putting
+//     #define LIST_STORAGE LIST_STORAGE_COMPACT
+// before including clist.h.  Not intended to be included directly.  
+// With LIST_COMPACT_MMAP set the arena, jump_table and list struct of a list
+// can also live in a memory-mapped file, see list_map_file().  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CLIST_COMPACT_H
+#define CLIST_COMPACT_H
+
+
+#include <stdint.h>
+
+//Option to add list_map_file(), for lists stored in memory-mapped files.  
+//Needs POSIX mmap, ftruncate and flock.  
+#ifndef LIST_COMPACT_MMAP
+#define LIST_COMPACT_MMAP 0
+#endif
+
+#if LIST_COMPACT_MMAP
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if FREE_LIST_ITEMS
+#error "LIST_COMPACT_MMAP can not store values that are freed with the list"
+#endif
+#endif
+
+
+//Position of a node in its list's arena.  
+typedef uint32_t _cindex;
+//Compact list node structure.  
+typedef struct _cnode _cnode;
+
+//Position marking the absence of a node, the equivalent of NULL.  
+#define CLIST_NIL ((_cindex)UINT32_MAX)
+
+//Number of nodes allocated for the arena of a list's first node.  
+#ifndef LIST_COMPACT_INITIAL_CAPACITY
+#define LIST_COMPACT_INITIAL_CAPACITY 16
+#endif
+
+#if LIST_COMPACT_MMAP
+//Header of a list file.  
+typedef struct _list_file _list_file;
+
+//Bytes in front of the arena of a list file, holding its _list_file.  
+#define LIST_FILE_HEADER_SIZE 4096
+#define LIST_FILE_VERSION 1
+
+//Address space reserved for each mapped list, the most its file can grow to.  
+#ifndef LIST_MMAP_RESERVE
+#define LIST_MMAP_RESERVE ((size_t)1 << (sizeof(void*) > 4 ? 36 : 30))
+#endif
+
+
+
+/// API functions ///
+
+
+
+/*
+Opens the list stored in the file at 'path', creating an empty one if the
+file is new or empty, and returns it.  The list struct, jump_table and arena
+live in the file, mapped into memory, so the list is usable at once and is
+kept in the file as it changes.  The file is locked, other processes can't
+map it until the list is freed.  Freeing the list with free_list() unmaps
+and closes the file but keeps its contents.  Returns NULL and calls
+list_error_handler if the file can't be opened, mapped or locked, or holds
+something other than a list of this build.  
+*/
+HOF list*
+list_map_file(const char* path);
+
+/*
+Writes the changed pages of a list returned by list_map_file() to disk, so
+that they survive a system crash.  Does nothing for other lists.  
+Returns 0 on success or -1 and calls list_error_handler on failure.  
+*/
+HOF int
+list_sync(list* l);
+#endif
+
+
+
+/// Internal functions ///
+
+
+
+/*
+Frees all memory associated with the list strucutre,
+but not the arena.  
+*/
+HOF void
+_free_list_structures(list* l);
+
+/*
+Internal function that returns the position of a node, taken from the
+list's free nodes or the end of its arena, whose value is set to the given
+value.  Returns CLIST_NIL if the arena could not be grown.  
+*/
+HOF _cindex
+_new_list_node(list* l, LIST_DATA_TYPE value);
+
+/*
+Internal function that returns the node at position 'n' to the list's
+free nodes.  
+*/
+HOF void
+_free_list_node(list* l, _cindex n);
+
+/*
+Internal function that grows the arena so that at least 'extra' more nodes
+can be allocated without reallocating.  Returns -1 on failure, 0 otherwise.  
+*/
+HOF int
+_list_reserve(list* l, lindex extra);
+
+/*
+Internal function that expands the jump_table of the given list,
+to the specified size.  Returns -1 on allocation failure, 0 otherwise.  
+*/
+HOF int
+_list_grow_jump_table(list* l, lindex new_size);
+
+/*
+Internal function that links node 'n' into the list in front of node
+'next', or as the new tail if 'next' is CLIST_NIL.  
+*/
+HOF void
+_link_before(list* l, _cindex next, _cindex n);
+
+/*
+Internal function that removes the links to/from node 'n'.  
+*/
+HOF void
+_unlink_node(list* l, _cindex n);
+
+/*
+Internal function that returns the position of the node at the given index.  
+*/
+HOF _cindex
+_list_node_at(const list* l, lindex index);
+
+/*
+Internal function that returns the node nearest to the one requested, either
+a jump_table node, the tail or l->current.  Sets 'dist' to the distance
+between the returned node and the one at the given index.  
+*/
+HOF _cindex
+_get_start_node(const list* l, lindex index, long* dist);
+
+/*
+Internal function that inserts node 'n' at the specified index, updating the
+jump_table and l->current.  
+*/
+HOF void
+_list_insert(list* l, lindex index, _cindex n);
+
+/*
+Internal function that removes node 'n', at the specified index, updating the
+jump_table and l->current, and returns its value.  
+*/
+HOF LIST_DATA_TYPE
+_list_remove(list* l, _cindex n, lindex index);
+
+/*
+Internal function that makes every jump_table entry refer to the node
+JT_INCREMENT * entry, and recalculates current_index, in one pass.  
+*/
+HOF void
+_list_rebuild_jump_table(list* l);
+
+/*
+Internal function that appends the values of the 'count' nodes of 'from'
+starting at node 'n' to 'l'.  Returns -1 on allocation failure, 0 otherwise.  
+*/
+HOF int
+_list_append_nodes(list* l, const list* from, _cindex n, lindex count);
+
+/*
+Internal function that frees the arena and list struct, or unmaps and closes
+the file of a mapped list.  
+*/
+HOF void
+_free_list_arena(list* l);
+
+#if LIST_COMPACT_MMAP
+/*
+Internal function that sizes the file of a mapped list for an arena of
+'capacity' nodes and a jump_table of 'jt_size' entries, moving the
+jump_table behind the arena.  Returns -1 on failure, 0 otherwise.  
+*/
+HOF int
+_list_file_resize(list* l, lindex capacity, lindex jt_size);
+
+/*
+Internal function that returns the number of bytes of a list file for an
+arena of 'capacity' nodes and a jump_table of 'jt_size' entries.  
+*/
+HOF size_t
+_list_file_bytes(lindex capacity, lindex jt_size);
+
+/*
+Internal function that calls list_error_handler with the given message.  
+*/
+HOF _LIST_COLD void
+_list_file_error(const char* func, const char* msg);
+#endif
+
+
+struct _cnode
+{
+    LIST_DATA_TYPE value;
+    _cindex        next;
+    _cindex        prev;
+};
+
+struct list
+{
+    lindex    size;
+    lindex    jt_size;
+    lindex    current_index;
+    _cindex   head;
+    _cindex   tail;
+    _cindex   current;
+    //Head of the released nodes, linked through their next fields.  
+    _cindex   free_nodes;
+    //Number of nodes ever handed out from the arena, and its capacity.  
+    _cindex   used;
+    _cindex   capacity;
+    _cindex*  jump_table;
+    _cnode*   nodes;
+#if LIST_COMPACT_MMAP
+    //Header of the file the list lives in, NULL for lists on the heap.  
+    _list_file* file;
+    int       fd;
+#endif
+};
+
+#if LIST_COMPACT_MMAP
+struct _list_file
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t value_size;
+    uint32_t jt_increment;
+    //The list itself.  Its pointers are set again each time it is mapped.  
+    list     l;
+};
+
+//The header must fit in front of the arena.  
+typedef char _list_file_fits[sizeof(_list_file) <= LIST_FILE_HEADER_SIZE ? 1 : -1];
+#endif
+
+
+#define _CN(l, n) ((l)->nodes[n])
+
+
+
+static inline list*
+new_list(void)
+{
+    //Allocate list struct.  
+    list* l = (list*)calloc(1, sizeof(list));
+    if (!l) return NULL;
+
+    //Allocate jump table.  
+    l->jump_table = (_cindex*)malloc(INITIAL_JT_SIZE * sizeof(_cindex));
+    if (!l->jump_table)
+    {
+        free(l);
+        return NULL;
+    }
+    memset(l->jump_table, 0xFF, INITIAL_JT_SIZE * sizeof(_cindex));
+    l->jt_size = INITIAL_JT_SIZE;
+
+    l->head = CLIST_NIL;
+    l->tail = CLIST_NIL;
+    l->current = CLIST_NIL;
+    l->free_nodes = CLIST_NIL;
+    return l;
+}
+
+
+static inline void
+free_list(list* l)
+{
+    if (!l) return;
+
+    #if FREE_LIST_ITEMS
+        _cindex n;
+        for (n = l->head; n != CLIST_NIL; n = _CN(l, n).next)
+            free(_CN(l, n).value);
+    #endif
+
+    _free_list_arena(l);
+}
+
+
+static inline void
+list_add(list* l, LIST_DATA_TYPE value)
+{
+    if (NULL_ARG_ERROR(l)) return;
+
+    _list_add(l, value);
+}
+
+
+static inline LIST_DATA_TYPE
+list_pop(list* l)
+{
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (SIZE_ERROR(l)) return ERROR_RETURN_VALUE;
+
+    return _list_remove(l, l->tail, l->size - 1);
+}
+
+
+static inline LIST_DATA_TYPE
+list_get(list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (INDEX_ERROR(l, index)) return ERROR_RETURN_VALUE;
+
+    return *_list_ref_at(l, index);
+}
+
+
+static inline LIST_DATA_TYPE
+list_get_const(const list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (INDEX_ERROR(l, index)) return ERROR_RETURN_VALUE;
+
+    //l->current may be a starting point, but it isn't moved.  
+    return _CN(l, _list_node_at(l, index)).value;
+}
+
+
+static inline LIST_DATA_TYPE*
+list_get_ref(list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    if (INDEX_ERROR(l, index)) return NULL;
+
+    return _list_ref_at(l, index);
+}
+
+
+static inline void
+list_insert(list* l, lindex index, LIST_DATA_TYPE value)
+{
+    if (NULL_ARG_ERROR(l)) return;
+    if (l->size != 0)
+        if (INDEX_ERROR(l, index)) return;
+
+    _cindex n = _new_list_node(l, value);
+    if (n == CLIST_NIL)
+    {
+        ALLOC_ERROR(NULL);
+        return;
+    }
+    _list_insert(l, l->size != 0 ? index : 0, n);
+}
+
+
+static inline LIST_DATA_TYPE
+list_remove(list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (INDEX_ERROR(l, index)) return ERROR_RETURN_VALUE;
+
+    return _list_remove(l, _list_node_at(l, index), index);
+}
+
+
+static inline lindex
+list_size(const list* l)
+{
+    if (NULL_ARG_ERROR(l)) return INDEX_ERR_RETURN_VALUE;
+
+    return l->size;
+}
+
+
+static inline void
+sort_list(list* l)
+{
+    if (NULL_ARG_ERROR(l)) return;
+    if (l->size < 2) return;
+
+    //Sort a copy of the values and write it back in list order, so no links,
+    //jump_table entries or l->current need to change.  
+    LIST_DATA_TYPE* values = (LIST_DATA_TYPE*)malloc(l->size * sizeof(LIST_DATA_TYPE));
+    LIST_DATA_TYPE* tmp = (LIST_DATA_TYPE*)malloc(l->size * sizeof(LIST_DATA_TYPE));
+    if (!values || !tmp)
+    {
+        free(values);
+        free(tmp);
+        ALLOC_ERROR(NULL);
+        return;
+    }
+
+    lindex i = 0;
+    _cindex n;
+    for (n = l->head; n != CLIST_NIL; n = _CN(l, n).next)
+        values[i++] = _CN(l, n).value;
+
+    _merge_sort_values(values, tmp, l->size);
+
+    i = 0;
+    for (n = l->head; n != CLIST_NIL; n = _CN(l, n).next)
+        _CN(l, n).value = values[i++];
+
+    free(values);
+    free(tmp);
+}
+
+
+static inline list*
+list_where(list* l, filter_func filter)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    list* new_collection = new_list();
+    if (ALLOC_ERROR(new_collection)) return NULL;
+
+    _cindex n;
+    for (n = l->head; n != CLIST_NIL; n = _CN(l, n).next)
+    {
+        if (filter(_CN(l, n).value))
+            list_add(new_collection, _CN(l, n).value);
+    }
+
+    return new_collection;
+}
+
+
+static inline void
+list_merge(list* first, list* second)
+{
+    if (NULL_ARG_ERROR(first)) return;
+    if (second == NULL || second->size == 0) return;
+
+    //Nodes can't be linked across arenas, so the values are appended.  
+    if (_list_append_nodes(first, second, second->head, second->size))
+    {
+        ALLOC_ERROR(NULL);
+        return;
+    }
+
+    _free_list_arena(second);
+}
+
+
+static inline list*
+list_split(list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    if (INDEX_ERROR(l, index)) return NULL;
+
+    list* nl = new_list();
+    if (ALLOC_ERROR(nl)) return NULL;
+    if (index == 0)
+        return nl;
+
+    _cindex n = _list_node_at(l, index);
+    if (_list_append_nodes(nl, l, n, l->size - index))
+    {
+        ALLOC_ERROR(NULL);
+        free_list(nl);
+        return NULL;
+    }
+
+    //Release the moved nodes, they are no longer reachable from l.  
+    l->tail = _CN(l, n).prev;
+    _CN(l, l->tail).next = CLIST_NIL;
+    while (n != CLIST_NIL)
+    {
+        _cindex next = _CN(l, n).next;
+        _free_list_node(l, n);
+        n = next;
+    }
+
+    lindex i;
+    for (i = (index - 1) / JT_INCREMENT + 1; i < l->jt_size; ++i)
+        l->jump_table[i] = CLIST_NIL;
+    l->size = index;
+    if (l->current_index >= index)
+        l->current = CLIST_NIL;
+
+    return nl;
+}
+
+
+static inline list*
+list_split_where(list* l, filter_func filter)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    list* nl = new_list();
+    if (ALLOC_ERROR(nl)) return NULL;
+
+    _cindex n = l->head;
+    while (n != CLIST_NIL)
+    {
+        _cindex next = _CN(l, n).next;
+        if (filter(_CN(l, n).value))
+        {
+            _cindex moved = _new_list_node(nl, _CN(l, n).value);
+            if (moved == CLIST_NIL)
+            {
+                ALLOC_ERROR(NULL);
+                break;
+            }
+            _link_before(nl, CLIST_NIL, moved);
+            ++(nl->size);
+
+            if (l->current == n)
+                l->current = CLIST_NIL;
+            _unlink_node(l, n);
+            _free_list_node(l, n);
+            --(l->size);
+        }
+        n = next;
+    }
+
+    //Both lists are indexed in one pass each instead of once per move.  
+    _list_rebuild_jump_table(l);
+    _list_rebuild_jump_table(nl);
+    return nl;
+}
+
+
+#if LIST_COMPACT_MMAP
+static inline list*
+list_map_file(const char* path)
+{
+    if (!path)
+    {
+        _list_file_error(__func__, "NULL path argument!\n");
+        return NULL;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        _list_file_error(__func__, "Could not open the list file!\n");
+        return NULL;
+    }
+    struct stat st;
+    if (flock(fd, LOCK_EX | LOCK_NB) || fstat(fd, &st))
+    {
+        close(fd);
+        _list_file_error(__func__, "Could not lock the list file!\n");
+        return NULL;
+    }
+
+    //All of the reserved space is mapped at once, past the end of the file,
+    //so the list never moves when its file grows.  
+    void* base = mmap(NULL, LIST_MMAP_RESERVE, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        close(fd);
+        _list_file_error(__func__, "Could not map the list file!\n");
+        return NULL;
+    }
+
+    _list_file* file = (_list_file*)base;
+    list* l = &file->l;
+    const int is_new = st.st_size == 0;
+    if (is_new)
+    {
+        if (ftruncate(fd, _list_file_bytes(0, INITIAL_JT_SIZE)))
+        {
+            munmap(base, LIST_MMAP_RESERVE);
+            close(fd);
+            _list_file_error(__func__, "Could not grow the list file!\n");
+            return NULL;
+        }
+        memcpy(file->magic, "CLST", 4);
+        file->version = LIST_FILE_VERSION;
+        file->value_size = sizeof(LIST_DATA_TYPE);
+        file->jt_increment = JT_INCREMENT;
+        l->jt_size = INITIAL_JT_SIZE;
+        l->head = CLIST_NIL;
+        l->tail = CLIST_NIL;
+        l->current = CLIST_NIL;
+        l->free_nodes = CLIST_NIL;
+    }
+    else if ((size_t)st.st_size < LIST_FILE_HEADER_SIZE ||
+             (size_t)st.st_size > LIST_MMAP_RESERVE ||
+             memcmp(file->magic, "CLST", 4) != 0 ||
+             file->version != LIST_FILE_VERSION ||
+             file->value_size != sizeof(LIST_DATA_TYPE) ||
+             file->jt_increment != JT_INCREMENT ||
+             (size_t)st.st_size < _list_file_bytes(l->capacity, l->jt_size))
+    {
+        munmap(base, LIST_MMAP_RESERVE);
+        close(fd);
+        _list_file_error(__func__, "List file does not match this build!\n");
+        return NULL;
+    }
+
+    //Everything else is stored as positions and stays valid.  
+    l->file = file;
+    l->fd = fd;
+    l->nodes = (_cnode*)((char*)base + LIST_FILE_HEADER_SIZE);
+    l->jump_table = (_cindex*)(l->nodes + l->capacity);
+    if (is_new)
+        memset(l->jump_table, 0xFF, INITIAL_JT_SIZE * sizeof(_cindex));
+    return l;
+}
+
+
+static inline int
+list_sync(list* l)
+{
+    if (NULL_ARG_ERROR(l)) return -1;
+    if (!l->file) return 0;
+
+    if (msync(l->file, _list_file_bytes(l->capacity, l->jt_size), MS_SYNC))
+    {
+        _list_file_error(__func__, "Could not write the list file!\n");
+        return -1;
+    }
+    return 0;
+}
+#endif
+
+
+
+static inline LIST_DATA_TYPE*
+_list_ref_at(list* l, lindex index)
+{
+    _cindex n = _list_node_at(l, index);
+    l->current = n;
+    l->current_index = index;
+    return &_CN(l, n).value;
+}
+
+
+static inline void
+_list_add(list* l, LIST_DATA_TYPE value)
+{
+    _cindex n = _new_list_node(l, value);
+    if (n == CLIST_NIL)
+    {
+        ALLOC_ERROR(NULL);
+        return;
+    }
+
+    _list_insert(l, l->size, n);
+}
+
+
+static inline void
+_free_list_arena(list* l)
+{
+#if LIST_COMPACT_MMAP
+    if (l->file)
+    {
+        //Closing the file also releases its lock.  
+        int fd = l->fd;
+        munmap(l->file, LIST_MMAP_RESERVE);
+        close(fd);
+        return;
+    }
+#endif
+    free(l->nodes);
+    _free_list_structures(l);
+}
+
+
+static inline void
+_free_list_structures(list* l)
+{
+    free(l->jump_table);
+    l->jump_table = NULL;
+    l->nodes = NULL;
+    free(l);
+}
+
+
+static inline _cindex
+_new_list_node(list* l, LIST_DATA_TYPE value)
+{
+    _cindex n = l->free_nodes;
+    if (n != CLIST_NIL)
+        l->free_nodes = _CN(l, n).next;
+    else
+    {
+        if (_list_reserve(l, 1)) return CLIST_NIL;
+        n = l->used++;
+    }
+
+    _CN(l, n).value = value;
+    _CN(l, n).next = CLIST_NIL;
+    _CN(l, n).prev = CLIST_NIL;
+    return n;
+}
+
+
+static inline void
+_free_list_node(list* l, _cindex n)
+{
+    _CN(l, n).next = l->free_nodes;
+    l->free_nodes = n;
+}
+
+
+static inline int
+_list_reserve(list* l, lindex extra)
+{
+    if ((lindex)l->used + extra <= l->capacity) return 0;
+    //CLIST_NIL can't be a node position.  
+    if ((lindex)l->used + extra > (lindex)CLIST_NIL) return -1;
+
+    lindex capacity = l->capacity ? l->capacity : LIST_COMPACT_INITIAL_CAPACITY;
+    while (capacity < (lindex)l->used + extra)
+        capacity *= 2;
+    if (capacity > (lindex)CLIST_NIL)
+        capacity = (lindex)CLIST_NIL;
+
+#if LIST_COMPACT_MMAP
+    if (l->file) return _list_file_resize(l, capacity, l->jt_size);
+#endif
+    _cnode* nodes = (_cnode*)realloc(l->nodes, capacity * sizeof(_cnode));
+    if (!nodes) return -1;
+
+    l->nodes = nodes;
+    l->capacity = (_cindex)capacity;
+    return 0;
+}
+
+
+static inline int
+_list_grow_jump_table(list* l, lindex new_size)
+{
+    _cindex* new_table;
+#if LIST_COMPACT_MMAP
+    if (l->file)
+        new_table = _list_file_resize(l, l->capacity, new_size) ?
+                    NULL : l->jump_table;
+    else
+#endif
+    new_table = (_cindex*)realloc(l->jump_table, new_size * sizeof(_cindex));
+
+    if (ALLOC_ERROR(new_table)) return -1;
+
+    memset(&new_table[l->jt_size], 0xFF,
+           (new_size - l->jt_size) * sizeof(_cindex));
+    l->jump_table = new_table;
+    l->jt_size = new_size;
+    return 0;
+}
+
+
+static inline void
+_link_before(list* l, _cindex next, _cindex n)
+{
+    _cindex prev = next == CLIST_NIL ? l->tail : _CN(l, next).prev;
+    _CN(l, n).next = next;
+    _CN(l, n).prev = prev;
+
+    if (prev == CLIST_NIL)
+        l->head = n;
+    else
+        _CN(l, prev).next = n;
+
+    if (next == CLIST_NIL)
+        l->tail = n;
+    else
+        _CN(l, next).prev = n;
+}
+
+
+static inline void
+_unlink_node(list* l, _cindex n)
+{
+    _cindex prev = _CN(l, n).prev;
+    _cindex next = _CN(l, n).next;
+
+    if (prev == CLIST_NIL)
+        l->head = next;
+    else
+        _CN(l, prev).next = next;
+
+    if (next == CLIST_NIL)
+        l->tail = prev;
+    else
+        _CN(l, next).prev = prev;
+}
+
+
+static inline _cindex
+_list_node_at(const list* l, lindex index)
+{
+    if (index == l->size - 1) return l->tail;
+
+    long dist;
+    _cindex n = _get_start_node(l, index, &dist);
+    for (; dist > 0; --dist)
+        n = _CN(l, n).next;
+    for (; dist < 0; ++dist)
+        n = _CN(l, n).prev;
+    return n;
+}
+
+
+static inline _cindex
+_get_start_node(const list* l, lindex index, long* dist)
+{
+    lindex lower = index / JT_INCREMENT;
+    _cindex n = l->jump_table[lower];
+    *dist = (long)(index - lower * JT_INCREMENT);
+
+    lindex upper = (lower + 1) * JT_INCREMENT;
+    if (upper < l->size && (long)(upper - index) < *dist)
+    {
+        n = l->jump_table[lower + 1];
+        *dist = (long)index - (long)upper;
+    }
+
+    long tail_dist = (long)index - (long)(l->size - 1);
+    if (labs(tail_dist) < labs(*dist))
+    {
+        n = l->tail;
+        *dist = tail_dist;
+    }
+
+    long current_dist = (long)index - (long)l->current_index;
+    if (l->current != CLIST_NIL && labs(current_dist) < labs(*dist))
+    {
+        n = l->current;
+        *dist = current_dist;
+    }
+    return n;
+}
+
+
+static inline void
+_list_insert(list* l, lindex index, _cindex n)
+{
+    //Make sure the table has room for the entry of the new last index.  
+    lindex last_entry = l->size / JT_INCREMENT;
+    if (last_entry >= l->jt_size && _list_grow_jump_table(l, l->jt_size * 2))
+    {
+        _free_list_node(l, n);
+        return;
+    }
+
+    _cindex next = index == l->size ? CLIST_NIL : _list_node_at(l, index);
+    _link_before(l, next, n);
+
+    //Every entry at or after the index now refers to the node in front of
+    //the one it did.  
+    lindex i = (index + JT_INCREMENT - 1) / JT_INCREMENT;
+    for (; i * JT_INCREMENT < l->size; ++i)
+        l->jump_table[i] = _CN(l, l->jump_table[i]).prev;
+    if (l->size % JT_INCREMENT == 0)
+        l->jump_table[last_entry] = l->tail;
+
+    if (l->current != CLIST_NIL && l->current_index >= index)
+        ++(l->current_index);
+    ++(l->size);
+}
+
+
+static inline LIST_DATA_TYPE
+_list_remove(list* l, _cindex n, lindex index)
+{
+    LIST_DATA_TYPE value = _CN(l, n).value;
+    --(l->size);
+
+    //Every entry at or after the index now refers to the node after the one
+    //it did, and the entry of the former last index is no longer needed.  
+    lindex i = (index + JT_INCREMENT - 1) / JT_INCREMENT;
+    for (; i * JT_INCREMENT < l->size; ++i)
+        l->jump_table[i] = _CN(l, l->jump_table[i]).next;
+    if (l->size % JT_INCREMENT == 0)
+        l->jump_table[l->size / JT_INCREMENT] = CLIST_NIL;
+
+    if (l->current == n)
+    {
+        if (_CN(l, n).next != CLIST_NIL)
+            l->current = _CN(l, n).next;
+        else
+        {
+            l->current = _CN(l, n).prev;
+            --(l->current_index);
+        }
+    }
+    else if (l->current != CLIST_NIL && l->current_index > index)
+        --(l->current_index);
+
+    _unlink_node(l, n);
+    _free_list_node(l, n);
+    return value;
+}
+
+
+static inline void
+_list_rebuild_jump_table(list* l)
+{
+    lindex needed = l->size / JT_INCREMENT + 1;
+    if (needed > l->jt_size && _list_grow_jump_table(l, needed)) return;
+    memset(l->jump_table, 0xFF, l->jt_size * sizeof(_cindex));
+
+    lindex index = 0;
+    _cindex n;
+    for (n = l->head; n != CLIST_NIL; n = _CN(l, n).next, ++index)
+    {
+        if (index % JT_INCREMENT == 0)
+            l->jump_table[index / JT_INCREMENT] = n;
+        if (n == l->current)
+            l->current_index = index;
+    }
+}
+
+
+static inline int
+_list_append_nodes(list* l, const list* from, _cindex n, lindex count)
+{
+    //Reserve everything up front so a failure leaves 'l' as it was.  
+    lindex needed = (l->size + count) / JT_INCREMENT + 1;
+    if (_list_reserve(l, count)) return -1;
+    if (needed > l->jt_size && _list_grow_jump_table(l, needed * 2)) return -1;
+
+    for (; count > 0; --count, n = _CN(from, n).next)
+    {
+        _cindex copy = l->used++;
+        _CN(l, copy).value = _CN(from, n).value;
+        _link_before(l, CLIST_NIL, copy);
+
+        if (l->size % JT_INCREMENT == 0)
+            l->jump_table[l->size / JT_INCREMENT] = copy;
+        ++(l->size);
+    }
+    return 0;
+}
+
+
+static inline int
+_list_append_values(list* l, LIST_DATA_TYPE* values, lindex count)
+{
+    lindex needed = (l->size + count) / JT_INCREMENT + 1;
+    if (_list_reserve(l, count))
+    {
+        ALLOC_ERROR(NULL);
+        return -1;
+    }
+    if (needed > l->jt_size && _list_grow_jump_table(l, needed * 2)) return -1;
+
+    lindex i = 0;
+    for (; i < count; ++i)
+    {
+        _cindex n = l->used++;
+        _CN(l, n).value = values[i];
+        _link_before(l, CLIST_NIL, n);
+
+        if (l->size % JT_INCREMENT == 0)
+            l->jump_table[l->size / JT_INCREMENT] = n;
+        ++(l->size);
+    }
+    return 0;
+}
+
+
+static inline int
+_list_copy_values(list* from, list* to, lindex start, lindex end)
+{
+    if (start == end) return 0;
+
+    if (_list_append_nodes(to, from, _list_node_at(from, start), end - start))
+    {
+        ALLOC_ERROR(NULL);
+        return -1;
+    }
+    return 0;
+}
+
+
+static inline void
+_list_erase(list* l, lindex start, lindex end, int free_items)
+{
+    (void)free_items;
+    if (start == end) return;
+
+    lindex removed = end - start;
+    lindex size = l->size - removed;
+    _cindex n = _list_node_at(l, start);
+
+    //Each entry from the range onward now refers to the node 'removed' past
+    //the one it did.  They are found while the range is still linked, so
+    //each costs a walk from the nearest old entry, in one pass.  
+    lindex i = (start + JT_INCREMENT - 1) / JT_INCREMENT;
+    for (; i * JT_INCREMENT < size; ++i)
+        l->jump_table[i] = _list_node_at(l, i * JT_INCREMENT + removed);
+    for (; i * JT_INCREMENT < l->size; ++i)
+        l->jump_table[i] = CLIST_NIL;
+
+    _cindex prev = _CN(l, n).prev;
+    lindex k = 0;
+    for (; k < removed; ++k)
+    {
+        _cindex next = _CN(l, n).next;
+        #if FREE_LIST_ITEMS
+            if (free_items)
+                free(_CN(l, n).value);
+        #endif
+        _free_list_node(l, n);
+        n = next;
+    }
+
+    //Link the nodes around the range to each other.  
+    if (prev == CLIST_NIL)
+        l->head = n;
+    else
+        _CN(l, prev).next = n;
+    if (n == CLIST_NIL)
+        l->tail = prev;
+    else
+        _CN(l, n).prev = prev;
+
+    if (l->current != CLIST_NIL && l->current_index >= start)
+    {
+        if (l->current_index >= end)
+            l->current_index -= removed;
+        else
+            l->current = CLIST_NIL;
+    }
+    l->size = size;
+}
+
+
+static inline void
+_list_retain(list* l, filter_func filter, int keep)
+{
+    lindex size = l->size;
+    _cindex n = l->head;
+    while (n != CLIST_NIL)
+    {
+        _cindex next = _CN(l, n).next;
+        if (!filter(_CN(l, n).value) != !keep)
+        {
+            #if FREE_LIST_ITEMS
+                free(_CN(l, n).value);
+            #endif
+            if (l->current == n)
+                l->current = CLIST_NIL;
+            _unlink_node(l, n);
+            _free_list_node(l, n);
+            --(l->size);
+        }
+        n = next;
+    }
+
+    //The list is indexed in one pass instead of once per removal.  
+    if (l->size != size)
+        _list_rebuild_jump_table(l);
+}
+
+
+static inline void
+_list_read_values(list* l, LIST_DATA_TYPE* values)
+{
+    _cindex n;
+    for (n = l->head; n != CLIST_NIL; n = _CN(l, n).next)
+        *(values++) = _CN(l, n).value;
+}
+
+
+#if LIST_COMPACT_MMAP
+static inline int
+_list_file_resize(list* l, lindex capacity, lindex jt_size)
+{
+    size_t bytes = _list_file_bytes(capacity, jt_size);
+    if (bytes > LIST_MMAP_RESERVE) return -1;
+    if (bytes > _list_file_bytes(l->capacity, l->jt_size) &&
+        ftruncate(l->fd, bytes))
+        return -1;
+
+    //The jump_table follows the arena, so it moves when the arena grows.  
+    _cindex* table = (_cindex*)(l->nodes + capacity);
+    if (table != l->jump_table)
+    {
+        memmove(table, l->jump_table, l->jt_size * sizeof(_cindex));
+        l->jump_table = table;
+    }
+    l->capacity = (_cindex)capacity;
+    return 0;
+}
+
+
+static inline size_t
+_list_file_bytes(lindex capacity, lindex jt_size)
+{
+    return LIST_FILE_HEADER_SIZE + capacity * sizeof(_cnode) +
+           jt_size * sizeof(_cindex);
+}
+
+
+static inline void
+_list_file_error(const char* func, const char* msg)
+{
+    list_error_handler(NULL)\
+    (func, "path", msg);
+}
+#endif
+
+
+#endif
@@ -0,0 +1,347 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_concurrent.h
+// Thread safe wrapper around a clist.h list, guarded by a reader/writer lock.  
+// Lookups (size, get, where, read) share the lock and run in parallel,
+// changes (add, insert, remove, pop, sort, write) take it exclusively.  
+// Include it after configuring clist.h as usual (it includes clist.h itself)
+// and build with -pthread.  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CLIST_CONCURRENT_H
+#define CLIST_CONCURRENT_H
+
+#include <pthread.h>
+#include "clist.h"
+
+
+//List guarded by a reader/writer lock.  Do not modify internal contents.  
+typedef struct concurrent_list concurrent_list;
+//Function run on the list under the shared lock.  
+typedef void (*list_read_func) (const list*, void*);
+//Function run on the list under the exclusive lock.  
+typedef void (*list_write_func) (list*, void*);
+
+
+
+/// API functions ///
+
+
+
+/*
+Returns a newly allocated, empty concurrent list on success or NULL if memory
+allocation or creating the lock failed.  User must free with
+free_concurrent_list if the value returned is not NULL.  
+*/
+HOF concurrent_list*
+new_concurrent_list(void);
+
+/*
+Frees the concurrent list and its list.  No other thread may be using it.  
+*/
+HOF void
+free_concurrent_list(concurrent_list* cl);
+
+/*
+Returns the number of values in the list.  Shares the lock.  
+*/
+HOF lindex
+concurrent_list_size(concurrent_list* cl);
+
+/*
+Returns the value at the given index, see list_get_const().  Shares the lock.  
+*/
+HOF LIST_DATA_TYPE
+concurrent_list_get(concurrent_list* cl, lindex index);
+
+/*
+Returns a new (not concurrent) list containing all values that meet the
+requirements of the filter function, see list_where().  Shares the lock, so
+the filter may be called by several threads at once.  
+*/
+HOF list*
+concurrent_list_where(concurrent_list* cl, filter_func filter);
+
+/*
+Calls 'f'(l, ctx) with the list under the shared lock, for any number of
+lookups at the cost of one lock.  'f' must not change the list, only
+functions taking a const list* (like list_get_const) may be used.  
+*/
+HOF void
+concurrent_list_read(concurrent_list* cl, list_read_func f, void* ctx);
+
+/*
+Adds the given value to the end of the list.  Takes the lock exclusively.  
+*/
+HOF void
+concurrent_list_add(concurrent_list* cl, LIST_DATA_TYPE value);
+
+/*
+Adds the 'count' values of the given array to the end of the list under a
+single exclusive lock.  Calls list_error_handler if the array is NULL.  
+*/
+HOF void
+concurrent_list_add_all(concurrent_list* cl, LIST_DATA_TYPE* values,
+                        lindex count);
+
+/*
+Inserts the given value at the specified index, see list_insert().  Takes the
+lock exclusively.  
+*/
+HOF void
+concurrent_list_insert(concurrent_list* cl, lindex index, LIST_DATA_TYPE value);
+
+/*
+Removes and returns the value at the given index, see list_remove().  Takes
+the lock exclusively.  
+*/
+HOF LIST_DATA_TYPE
+concurrent_list_remove(concurrent_list* cl, lindex index);
+
+/*
+Removes and returns the last value, see list_pop().  Takes the lock
+exclusively.  
+*/
+HOF LIST_DATA_TYPE
+concurrent_list_pop(concurrent_list* cl);
+
+/*
+Sorts the list, see sort_list().  Takes the lock exclusively.  
+*/
+HOF void
+concurrent_list_sort(concurrent_list* cl);
+
+/*
+Calls 'f'(l, ctx) with the list under the exclusive lock, for any number of
+changes at the cost of one lock.  
+*/
+HOF void
+concurrent_list_write(concurrent_list* cl, list_write_func f, void* ctx);
+
+
+
+/// Internal functions ///
+
+
+
+/*
+Internal function that calls list_error_handler if the concurrent list is
+NULL.  Returns -1 if there is an error and 0 otherwise.  
+*/
+HOF int
+_concurrent_null_error(const concurrent_list* cl, const char* func);
+
+/*
+Internal function that calls list_error_handler if the array of values is
+NULL.  Returns -1 if there is an error and 0 otherwise.  
+*/
+HOF int
+_concurrent_values_error(LIST_DATA_TYPE* values, const char* func);
+
+
+
+struct concurrent_list
+{
+    //Created with new_list(), without a pool that readers could share.  
+    list*            l;
+    pthread_rwlock_t lock;
+};
+
+#define CONCURRENT_NULL_ERROR(cl) _concurrent_null_error(cl, __func__)
+#define CONCURRENT_VALUES_ERROR(values)                                       \
+    _concurrent_values_error(values, __func__)
+
+
+
+
+static inline concurrent_list*
+new_concurrent_list(void)
+{
+    concurrent_list* cl = (concurrent_list*)malloc(sizeof(concurrent_list));
+    if (!cl) return NULL;
+
+    cl->l = new_list();
+    if (!cl->l || pthread_rwlock_init(&cl->lock, NULL) != 0)
+    {
+        if (cl->l)
+            free_list(cl->l);
+        free(cl);
+        return NULL;
+    }
+    return cl;
+}
+
+
+static inline void
+free_concurrent_list(concurrent_list* cl)
+{
+    if (!cl) return;
+    pthread_rwlock_destroy(&cl->lock);
+    free_list(cl->l);
+    free(cl);
+}
+
+
+static inline lindex
+concurrent_list_size(concurrent_list* cl)
+{
+    if (CONCURRENT_NULL_ERROR(cl)) return (lindex)-1;
+
+    pthread_rwlock_rdlock(&cl->lock);
+    lindex size = list_size(cl->l);
+    pthread_rwlock_unlock(&cl->lock);
+    return size;
+}
+
+
+static inline LIST_DATA_TYPE
+concurrent_list_get(concurrent_list* cl, lindex index)
+{
+    if (CONCURRENT_NULL_ERROR(cl)) return ERROR_RETURN_VALUE;
+
+    pthread_rwlock_rdlock(&cl->lock);
+    LIST_DATA_TYPE value = list_get_const(cl->l, index);
+    pthread_rwlock_unlock(&cl->lock);
+    return value;
+}
+
+
+static inline list*
+concurrent_list_where(concurrent_list* cl, filter_func filter)
+{
+    if (CONCURRENT_NULL_ERROR(cl)) return NULL;
+
+    pthread_rwlock_rdlock(&cl->lock);
+    list* nl = list_where(cl->l, filter);
+    pthread_rwlock_unlock(&cl->lock);
+    return nl;
+}
+
+
+static inline void
+concurrent_list_read(concurrent_list* cl, list_read_func f, void* ctx)
+{
+    if (CONCURRENT_NULL_ERROR(cl)) return;
+
+    pthread_rwlock_rdlock(&cl->lock);
+    f(cl->l, ctx);
+    pthread_rwlock_unlock(&cl->lock);
+}
+
+
+static inline void
+concurrent_list_add(concurrent_list* cl, LIST_DATA_TYPE value)
+{
+    if (CONCURRENT_NULL_ERROR(cl)) return;
+
+    pthread_rwlock_wrlock(&cl->lock);
+    list_add(cl->l, value);
+    pthread_rwlock_unlock(&cl->lock);
+}
+
+
+static inline void
+concurrent_list_add_all(concurrent_list* cl, LIST_DATA_TYPE* values,
+                        lindex count)
+{
+    if (CONCURRENT_NULL_ERROR(cl)) return;
+    if (count == 0) return;
+    if (CONCURRENT_VALUES_ERROR(values)) return;
+
+    pthread_rwlock_wrlock(&cl->lock);
+    lindex i = 0;
+    for (; i < count; ++i)
+        list_add(cl->l, values[i]);
+    pthread_rwlock_unlock(&cl->lock);
+}
+
+
+static inline void
+concurrent_list_insert(concurrent_list* cl, lindex index, LIST_DATA_TYPE value)
+{
+    if (CONCURRENT_NULL_ERROR(cl)) return;
+
+    pthread_rwlock_wrlock(&cl->lock);
+    list_insert(cl->l, index, value);
+    pthread_rwlock_unlock(&cl->lock);
+}
+
+
+static inline LIST_DATA_TYPE
+concurrent_list_remove(concurrent_list* cl, lindex index)
+{
+    if (CONCURRENT_NULL_ERROR(cl)) return ERROR_RETURN_VALUE;
+
+    pthread_rwlock_wrlock(&cl->lock);
+    LIST_DATA_TYPE value = list_remove(cl->l, index);
+    pthread_rwlock_unlock(&cl->lock);
+    return value;
+}
+
+
+static inline LIST_DATA_TYPE
+concurrent_list_pop(concurrent_list* cl)
+{
+    if (CONCURRENT_NULL_ERROR(cl)) return ERROR_RETURN_VALUE;
+
+    pthread_rwlock_wrlock(&cl->lock);
+    LIST_DATA_TYPE value = list_pop(cl->l);
+    pthread_rwlock_unlock(&cl->lock);
+    return value;
+}
+
+
+static inline void
+concurrent_list_sort(concurrent_list* cl)
+{
+    if (CONCURRENT_NULL_ERROR(cl)) return;
+
+    pthread_rwlock_wrlock(&cl->lock);
+    sort_list(cl->l);
+    pthread_rwlock_unlock(&cl->lock);
+}
+
+
+static inline void
+concurrent_list_write(concurrent_list* cl, list_write_func f, void* ctx)
+{
+    if (CONCURRENT_NULL_ERROR(cl)) return;
+
+    pthread_rwlock_wrlock(&cl->lock);
+    f(cl->l, ctx);
+    pthread_rwlock_unlock(&cl->lock);
+}
+
+
+/// Internal functions ///
+
+
+static inline int
+_concurrent_null_error(const concurrent_list* cl, const char* func)
+{
+    if (!cl)
+    {
+        list_error_handler(NULL)\
+        (func, "cl", "NULL list argument!\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+static inline int
+_concurrent_values_error(LIST_DATA_TYPE* values, const char* func)
+{
+    if (!values)
+    {
+        list_error_handler(NULL)\
+        (func, "values", "NULL array argument!\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+#endif //CLIST_CONCURRENT_H
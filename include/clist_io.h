@@ -0,0 +1,340 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_io.h
+// Binary load and store of a clist.h list through a POSIX file descriptor.  
+// The values are written as raw bytes under a small versioned header, so
+// LIST_DATA_TYPE must be trivially copyable (no pointers it owns) and files
+// are only read back by builds with the same LIST_DATA_TYPE and byte order.  
+// Include it after configuring clist.h as usual (it includes clist.h itself).  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CLIST_IO_H
+#define CLIST_IO_H
+
+#include <errno.h>
+#include <stdint.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "clist.h"
+
+#if FREE_LIST_ITEMS
+#error "clist_io.h can not store values that are freed with the list"
+#endif
+
+//Number of values moved per system call.  
+#ifndef LIST_IO_BATCH
+#define LIST_IO_BATCH 8192
+#endif
+
+//Largest slab, in nodes, that list_read_fd() allocates for node storage.  
+#ifndef LIST_IO_MAX_SLAB
+#define LIST_IO_MAX_SLAB (1 << 20)
+#endif
+
+//Function used to write the batches, writev unless set otherwise.  
+#ifndef LIST_IO_WRITEV
+#define LIST_IO_WRITEV writev
+#endif
+
+#define LIST_IO_VERSION 1
+#define LIST_IO_BYTE_ORDER 0x01020304u
+
+
+//Header written in front of the values.  
+typedef struct _list_io_header _list_io_header;
+
+
+
+/// API functions ///
+
+
+
+/*
+Writes the size and all values of 'l' to 'fd', in batches of LIST_IO_BATCH
+values.  Values staged with list_add_pending() are not written.  
+Returns 0 on success or -1 and calls list_error_handler if writing failed.  
+*/
+HOF int
+list_write_fd(list* l, int fd);
+
+/*
+Reads a list written by list_write_fd() from 'fd' and returns it.  With node
+storage the nodes are taken from slabs of a pooled list (see
+new_pooled_list()) and the jump_table is built in one pass at the end.  
+Returns NULL and calls list_error_handler if reading failed, the header does
+not match this build or there is a memory allocation error.  User must free
+with free_list if the value returned is not NULL.  
+*/
+HOF list*
+list_read_fd(int fd);
+
+
+
+/// Internal functions ///
+
+
+
+/*
+Internal function that writes all 'count' buffers of 'iov' to 'fd', retrying
+partial and interrupted writes.  Advances the buffers past what was written,
+so they must be set again before they are reused.  Returns 0 on success or -1
+on error.  
+*/
+HOF int
+_io_writev_all(int fd, struct iovec* iov, int count);
+
+/*
+Internal function that reads up to 'bytes' bytes from 'fd' into 'buf',
+retrying partial and interrupted reads.  Returns the number of bytes read,
+which is only less than 'bytes' at the end of the file, or -1 on error.  
+*/
+HOF ssize_t
+_io_read_all(int fd, void* buf, size_t bytes);
+
+/*
+Internal function that calls list_error_handler with the given message.  
+*/
+HOF _LIST_COLD void
+_io_error(const char* func, const char* msg);
+
+/*
+Internal function that returns a new list holding the 'size' values read from
+'fd' into 'buf', or NULL on error.  
+*/
+HOF list*
+_io_read_values(int fd, LIST_DATA_TYPE* buf, lindex size);
+
+
+
+struct _list_io_header
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t value_size;
+    uint32_t byte_order;
+    uint64_t size;
+};
+
+
+
+
+static inline int
+list_write_fd(list* l, int fd)
+{
+    if (NULL_ARG_ERROR(l)) return -1;
+
+    _list_io_header header = {{'C', 'L', 'S', 'T'}, LIST_IO_VERSION,
+                              sizeof(LIST_DATA_TYPE), LIST_IO_BYTE_ORDER,
+                              l->size};
+    LIST_DATA_TYPE* buf =
+        (LIST_DATA_TYPE*)malloc(LIST_IO_BATCH * sizeof(LIST_DATA_TYPE));
+    if (ALLOC_ERROR(buf)) return -1;
+
+    //The header goes out with the first batch.  
+    struct iovec iov[2] = {{&header, sizeof(header)}, {buf, 0}};
+    struct iovec* next = iov;
+    int count = 2;
+    lindex i = 0;
+#if LIST_STORAGE == LIST_STORAGE_NODES
+    _node* node = l->head;
+#endif
+    do
+    {
+        lindex n = 0;
+#if LIST_STORAGE == LIST_STORAGE_NODES
+        for (; n < LIST_IO_BATCH && i < l->size; ++n, ++i, node = node->next)
+            buf[n] = node->value;
+#else
+        for (; n < LIST_IO_BATCH && i < l->size; ++n, ++i)
+            buf[n] = *_list_ref_at(l, i);
+#endif
+        //A short write may have moved the buffer on.  
+        iov[1].iov_base = buf;
+        iov[1].iov_len = n * sizeof(LIST_DATA_TYPE);
+        if (_io_writev_all(fd, next, count))
+        {
+            free(buf);
+            _io_error(__func__, "Could not write the list!\n");
+            return -1;
+        }
+        next = iov + 1;
+        count = 1;
+    } while (i < l->size);
+
+    free(buf);
+    return 0;
+}
+
+
+static inline list*
+list_read_fd(int fd)
+{
+    _list_io_header header;
+    ssize_t got = _io_read_all(fd, &header, sizeof(header));
+    if (got != (ssize_t)sizeof(header))
+    {
+        _io_error(__func__, "Could not read the list header!\n");
+        return NULL;
+    }
+    if (memcmp(header.magic, "CLST", 4) != 0 ||
+        header.version != LIST_IO_VERSION ||
+        header.value_size != sizeof(LIST_DATA_TYPE) ||
+        header.byte_order != LIST_IO_BYTE_ORDER ||
+        header.size != (lindex)header.size)
+    {
+        _io_error(__func__, "List header does not match this build!\n");
+        return NULL;
+    }
+
+    LIST_DATA_TYPE* buf =
+        (LIST_DATA_TYPE*)malloc(LIST_IO_BATCH * sizeof(LIST_DATA_TYPE));
+    if (ALLOC_ERROR(buf)) return NULL;
+
+    list* l = _io_read_values(fd, buf, (lindex)header.size);
+    free(buf);
+    return l;
+}
+
+
+/// Internal functions ///
+
+
+static inline int
+_io_writev_all(int fd, struct iovec* iov, int count)
+{
+    while (count > 0)
+    {
+        ssize_t written = LIST_IO_WRITEV(fd, iov, count);
+        if (written < 0)
+        {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+
+        //Skip what was written, the rest goes out with the next call.  
+        while (count > 0 && (size_t)written >= iov->iov_len)
+        {
+            written -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0)
+        {
+            iov->iov_base = (char*)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+    return 0;
+}
+
+
+static inline ssize_t
+_io_read_all(int fd, void* buf, size_t bytes)
+{
+    size_t total = 0;
+    while (total < bytes)
+    {
+        ssize_t got = read(fd, (char*)buf + total, bytes - total);
+        if (got < 0)
+        {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (got == 0) break;
+        total += got;
+    }
+    return total;
+}
+
+
+static inline void
+_io_error(const char* func, const char* msg)
+{
+    list_error_handler(NULL)\
+    (func, "fd", msg);
+}
+
+
+#if LIST_STORAGE == LIST_STORAGE_NODES
+static inline list*
+_io_read_values(int fd, LIST_DATA_TYPE* buf, lindex size)
+{
+    if (size == 0)
+    {
+        list* l = new_list();
+        ALLOC_ERROR(l);
+        return l;
+    }
+
+    list* l = new_pooled_list(size < LIST_IO_MAX_SLAB ? size : LIST_IO_MAX_SLAB);
+    if (ALLOC_ERROR(l)) return NULL;
+
+    //Chain all nodes first, the jump_table is built once they are linked.  
+    _node* head = NULL;
+    _node* tail = NULL;
+    lindex i = 0;
+    while (i < size)
+    {
+        lindex n = size - i < LIST_IO_BATCH ? size - i : LIST_IO_BATCH;
+        if (_io_read_all(fd, buf, n * sizeof(LIST_DATA_TYPE)) !=
+            (ssize_t)(n * sizeof(LIST_DATA_TYPE)))
+        {
+            //Nodes are released with the pool's slabs.  
+            free_list(l);
+            _io_error(__func__, "Could not read the list values!\n");
+            return NULL;
+        }
+
+        lindex j = 0;
+        for (; j < n; ++j)
+        {
+            _node* node = _pool_alloc(l->pool);
+            if (ALLOC_ERROR(node))
+            {
+                free_list(l);
+                return NULL;
+            }
+            node->value = buf[j];
+            _append(&head, &tail, node);
+        }
+        i += n;
+    }
+
+    _list_set_new(l, head, tail, size);
+    return l;
+}
+#else
+static inline list*
+_io_read_values(int fd, LIST_DATA_TYPE* buf, lindex size)
+{
+    list* l = new_list();
+    if (ALLOC_ERROR(l)) return NULL;
+
+    lindex i = 0;
+    while (i < size)
+    {
+        lindex n = size - i < LIST_IO_BATCH ? size - i : LIST_IO_BATCH;
+        if (_io_read_all(fd, buf, n * sizeof(LIST_DATA_TYPE)) !=
+            (ssize_t)(n * sizeof(LIST_DATA_TYPE)))
+        {
+            free_list(l);
+            _io_error(__func__, "Could not read the list values!\n");
+            return NULL;
+        }
+
+        //Each batch is appended in bulk, chunks or arena nodes at a time.  
+        if (_list_append_values(l, buf, n))
+        {
+            free_list(l);
+            return NULL;
+        }
+        i += n;
+    }
+    return l;
+}
+#endif
+
+
+#endif //CLIST_IO_H
@@ -0,0 +1,647 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_parallel.h
+// Multithreaded operations for clist.h lists with the default node storage.  
+// Include it after configuring clist.h as usual (it includes clist.h itself)
+// and build with -pthread.  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CLIST_PARALLEL_H
+#define CLIST_PARALLEL_H
+
+#include <pthread.h>
+#include "clist.h"
+
+#if LIST_STORAGE != LIST_STORAGE_NODES
+#error "clist_parallel.h requires LIST_STORAGE_NODES"
+#endif
+
+
+//Smallest number of values given to one thread, smaller lists use fewer
+//threads.  Never less than JT_INCREMENT, segments start at jump_table nodes.  
+#ifndef LIST_PARALLEL_MIN_SEGMENT
+#define LIST_PARALLEL_MIN_SEGMENT 16384
+#endif
+
+
+//Map function signature.  
+typedef LIST_DATA_TYPE (*map_func) (LIST_DATA_TYPE);
+//Reduce function signature, combines an accumulated value with the next one.  
+typedef LIST_DATA_TYPE (*reduce_func) (LIST_DATA_TYPE, LIST_DATA_TYPE);
+//Task function signature, the same as a pthread start routine.  
+typedef void* (*_task_func) (void*);
+//Gathers and sorts one segment of a list.  
+typedef struct _sort_segment_task _sort_segment_task;
+//Merges part of two sorted runs.  
+typedef struct _merge_task _merge_task;
+//Relinks part of a sorted list.  
+typedef struct _relink_task _relink_task;
+//Builds the filtered or mapped nodes of one segment of a list.  
+typedef struct _chain_task _chain_task;
+//Reduces one segment of a list.  
+typedef struct _reduce_task _reduce_task;
+
+
+
+/// API functions ///
+
+
+
+/*
+Sorts the given list using up to 'nthreads' threads.  The list is cut into
+segments at jump_table nodes, the segments are gathered and sorted
+concurrently and then merged in parallel.  The result, including the order
+of equal values, is identical to sort_list().  Falls back to sort_list() for
+small lists, for 'nthreads' < 2 and when memory can't be allocated.  
+*/
+HOF void
+sort_list_parallel(list* l, unsigned nthreads);
+
+/*
+Returns a newly created list containing all list elements of 'l' that meet the
+requirements of the filter function, in order, using up to 'nthreads'
+threads.  Each thread filters the segment of the list that starts at one
+jump_table node.  Returns NULL on memory allocation failure.  The filter
+function is called concurrently.  
+*/
+HOF list*
+list_where_parallel(list* l, filter_func filter, unsigned nthreads);
+
+/*
+Returns a newly created list containing map(value) for each list element of
+'l', in order, using up to 'nthreads' threads.  Returns NULL on memory
+allocation failure.  The map function is called concurrently.  
+*/
+HOF list*
+list_map_parallel(list* l, map_func map, unsigned nthreads);
+
+/*
+Returns the list's values combined with 'reduce', starting from 'init', using
+up to 'nthreads' threads.  Each thread reduces its own segment, starting from
+the segment's first value, and the results are then combined in order, so
+'reduce' must be associative but 'init' needn't be an identity.  Returns
+'init' for an empty list.  Calls list_error_handler and returns
+ERROR_RETURN_VALUE if the list is NULL.  
+*/
+HOF LIST_DATA_TYPE
+list_reduce_parallel(list* l, reduce_func reduce, LIST_DATA_TYPE init,
+                     unsigned nthreads);
+
+
+
+/// Internal functions ///
+
+
+
+/*
+Internal function that runs 'task' on each of the 'count' arguments of
+'arg_size' bytes in 'args', one thread per argument, and waits for all of
+them.  The first argument is run on the calling thread, as is any argument
+a thread can't be started for.  
+*/
+HOF void
+_run_tasks(_task_func task, void* args, size_t arg_size, unsigned count);
+
+/*
+Internal function that returns how many of up to 'nthreads' threads to use for
+'size' values, so that each gets at least LIST_PARALLEL_MIN_SEGMENT of them.  
+*/
+HOF unsigned
+_thread_count(lindex size, unsigned nthreads);
+
+/*
+Internal function that returns the index segment 's' of 'count' starts at,
+the index of the jump_table node closest below an even split.  The
+jump_table must be up to date.  
+*/
+HOF lindex
+_segment_bound(list* l, unsigned s, unsigned count);
+
+/*
+Internal function that returns the first node of the segment starting at
+'index', a value returned by _segment_bound().  
+*/
+HOF _node*
+_segment_start(list* l, lindex index);
+
+/*
+Internal function that builds a new list from the filtered (if 'filter' is
+not NULL) and mapped (if 'map' is not NULL) values of 'l' using up to
+'nthreads' threads.  
+*/
+HOF list*
+_list_parallel_chains(list* l, filter_func filter, map_func map,
+                      unsigned nthreads);
+
+/*
+Internal function that returns the number of the first 'k' merged values of
+'a' and 'b' that come from 'a', with equal values taken from 'a' first.  
+*/
+HOF lindex
+_merge_split(const _sort_entry* a, lindex na,
+             const _sort_entry* b, lindex nb, lindex k);
+
+/*
+Internal task that gathers a segment of the list into its entries and,
+unless it is already in order, sorts them.  
+*/
+HOF void*
+_sort_segment(void* task);
+
+/*
+Internal task that writes its share of the merge of two sorted runs.  
+*/
+HOF void*
+_merge_part(void* task);
+
+/*
+Internal task that relinks its range of a sorted list.  
+*/
+HOF void*
+_relink_part(void* task);
+
+/*
+Internal task that builds a chain of new nodes for its segment.  
+*/
+HOF void*
+_chain_part(void* task);
+
+/*
+Internal task that reduces its segment.  
+*/
+HOF void*
+_reduce_part(void* task);
+
+
+
+struct _sort_segment_task
+{
+    list*        l;
+    _node*       start;
+    _sort_entry* entries;
+    _sort_entry* tmp;
+    lindex       count;
+    int          sorted;
+};
+
+struct _merge_task
+{
+    const _sort_entry* a;
+    const _sort_entry* b;
+    lindex       na;
+    lindex       nb;
+    _sort_entry* dst;
+    //Range of the merged output written by this task.  
+    lindex       from;
+    lindex       to;
+};
+
+struct _relink_task
+{
+    list*        l;
+    const _sort_entry* entries;
+    lindex       from;
+    lindex       to;
+};
+
+struct _chain_task
+{
+    _node*       start;
+    lindex       count;
+    //List the new nodes are allocated for, without a pool.  
+    list*        nl;
+    filter_func  filter;
+    map_func     map;
+    _node*       head;
+    _node*       tail;
+    lindex       size;
+    int          failed;
+};
+
+struct _reduce_task
+{
+    _node*         start;
+    lindex         count;
+    reduce_func    reduce;
+    LIST_DATA_TYPE result;
+};
+
+
+
+
+static inline void
+sort_list_parallel(list* l, unsigned nthreads)
+{
+    if (NULL_ARG_ERROR(l)) return;
+
+    nthreads = _thread_count(l->size, nthreads);
+    if (nthreads < 2)
+    {
+        sort_list(l);
+        return;
+    }
+
+    lindex n = l->size;
+    _sort_entry* entries = (_sort_entry*)malloc(2 * n * sizeof(_sort_entry));
+    lindex* bounds = (lindex*)malloc((nthreads + 1) * sizeof(lindex));
+    //Merge tasks of a round, up to one per thread plus one per run.  
+    _merge_task* merges = (_merge_task*)malloc(2 * nthreads * sizeof(_merge_task));
+    _sort_segment_task* segments =
+        (_sort_segment_task*)malloc(nthreads * sizeof(_sort_segment_task));
+    if (!entries || !bounds || !merges || !segments)
+    {
+        free(entries);
+        free(bounds);
+        free(merges);
+        free(segments);
+        sort_list(l);
+        return;
+    }
+
+    _list_repair_jump_table(l, l->jt_size);
+    unsigned s;
+    for (s = 0; s <= nthreads; ++s)
+        bounds[s] = _segment_bound(l, s, nthreads);
+
+    for (s = 0; s < nthreads; ++s)
+    {
+        _sort_segment_task* t = &segments[s];
+        t->l = l;
+        t->start = _segment_start(l, bounds[s]);
+        t->entries = entries + bounds[s];
+        t->tmp = entries + n + bounds[s];
+        t->count = bounds[s+1] - bounds[s];
+    }
+    _run_tasks(_sort_segment, segments, sizeof(_sort_segment_task), nthreads);
+
+    int sorted = 1;
+    for (s = 0; s < nthreads && sorted; ++s)
+    {
+        sorted = segments[s].sorted;
+        if (s > 0 && LIST_COMPARATOR(entries[bounds[s]].value,
+                                     entries[bounds[s]-1].value))
+            sorted = 0;
+    }
+
+    //Merge neighbouring runs until one is left, sharing each round's output
+    //evenly between the threads.  
+    _sort_entry* src = entries;
+    _sort_entry* dst = entries + n;
+    unsigned runs = nthreads;
+    while (runs > 1 && !sorted)
+    {
+        unsigned pairs = runs / 2;
+        unsigned parts = nthreads / pairs;
+        unsigned count = 0;
+        for (s = 0; s < runs; s += 2)
+        {
+            lindex lo = bounds[s];
+            lindex mid = bounds[s+1];
+            lindex hi = s + 2 <= runs ? bounds[s+2] : mid;
+            unsigned split = s + 1 < runs ? parts : 1;
+            unsigned p;
+            for (p = 0; p < split; ++p)
+            {
+                _merge_task* t = &merges[count++];
+                t->a = src + lo;
+                t->na = mid - lo;
+                t->b = src + mid;
+                t->nb = hi - mid;
+                t->dst = dst + lo;
+                t->from = p * (hi - lo) / split;
+                t->to = (p + 1) * (hi - lo) / split;
+            }
+            bounds[s/2] = lo;
+        }
+        runs = (runs + 1) / 2;
+        bounds[runs] = n;
+        _run_tasks(_merge_part, merges, sizeof(_merge_task), count);
+
+        _sort_entry* swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (!sorted)
+    {
+        //The merge tasks are reused to hold the relink ranges.  
+        _relink_task* relinks = (_relink_task*)merges;
+        for (s = 0; s < nthreads; ++s)
+        {
+            relinks[s].l = l;
+            relinks[s].entries = src;
+            relinks[s].from = s * n / nthreads;
+            relinks[s].to = (s + 1) * n / nthreads;
+        }
+        _run_tasks(_relink_part, relinks, sizeof(_relink_task), nthreads);
+        _finish_relink(l, src);
+    }
+
+    free(entries);
+    free(bounds);
+    free(merges);
+    free(segments);
+}
+
+
+static inline list*
+list_where_parallel(list* l, filter_func filter, unsigned nthreads)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    return _list_parallel_chains(l, filter, NULL, nthreads);
+}
+
+
+static inline list*
+list_map_parallel(list* l, map_func map, unsigned nthreads)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    return _list_parallel_chains(l, NULL, map, nthreads);
+}
+
+
+static inline LIST_DATA_TYPE
+list_reduce_parallel(list* l, reduce_func reduce, LIST_DATA_TYPE init,
+                     unsigned nthreads)
+{
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (l->size == 0) return init;
+
+    _reduce_task single;
+    nthreads = _thread_count(l->size, nthreads);
+    _reduce_task* tasks = nthreads > 1 ?
+        (_reduce_task*)malloc(nthreads * sizeof(_reduce_task)) : NULL;
+    if (!tasks)
+    {
+        tasks = &single;
+        nthreads = 1;
+    }
+
+    _list_repair_jump_table(l, l->jt_size);
+    unsigned s;
+    for (s = 0; s < nthreads; ++s)
+    {
+        lindex start = _segment_bound(l, s, nthreads);
+        tasks[s].start = _segment_start(l, start);
+        tasks[s].count = _segment_bound(l, s + 1, nthreads) - start;
+        tasks[s].reduce = reduce;
+    }
+    _run_tasks(_reduce_part, tasks, sizeof(_reduce_task), nthreads);
+
+    LIST_DATA_TYPE result = init;
+    for (s = 0; s < nthreads; ++s)
+        result = reduce(result, tasks[s].result);
+
+    if (tasks != &single)
+        free(tasks);
+    return result;
+}
+
+
+/// Internal functions ///
+
+
+static inline void
+_run_tasks(_task_func task, void* args, size_t arg_size, unsigned count)
+{
+    if (count == 0) return;
+
+    pthread_t* threads = (pthread_t*)malloc(count * sizeof(pthread_t));
+    int* started = (int*)calloc(count, sizeof(int));
+    unsigned i;
+    for (i = 1; i < count && threads && started; ++i)
+        started[i] = pthread_create(&threads[i], NULL, task,
+                                    (char*)args + i * arg_size) == 0;
+
+    task(args);
+    for (i = 1; i < count; ++i)
+    {
+        if (threads && started && started[i])
+            pthread_join(threads[i], NULL);
+        else
+            task((char*)args + i * arg_size);
+    }
+
+    free(threads);
+    free(started);
+}
+
+
+static inline unsigned
+_thread_count(lindex size, unsigned nthreads)
+{
+    lindex min_segment = LIST_PARALLEL_MIN_SEGMENT > JT_INCREMENT ?
+                         LIST_PARALLEL_MIN_SEGMENT : JT_INCREMENT;
+    if (nthreads > size / min_segment)
+        nthreads = size / min_segment;
+    return nthreads > 0 ? nthreads : 1;
+}
+
+
+static inline lindex
+_segment_bound(list* l, unsigned s, unsigned count)
+{
+    if (s == 0) return 0;
+    if (s == count) return l->size;
+
+    lindex target = s * l->size / count;
+    return target - (target + l->jt_offset) % JT_INCREMENT;
+}
+
+
+static inline _node*
+_segment_start(list* l, lindex index)
+{
+    return index == 0 ? l->head : l->jump_table[_jt_entry_of(l, index)];
+}
+
+
+static inline list*
+_list_parallel_chains(list* l, filter_func filter, map_func map,
+                      unsigned nthreads)
+{
+    //Without a pool, the threads can allocate nodes for the new list at once.  
+    list* nl = new_list();
+    if (ALLOC_ERROR(nl)) return NULL;
+    if (l->size == 0) return nl;
+
+    _chain_task single;
+    nthreads = _thread_count(l->size, nthreads);
+    _chain_task* tasks = nthreads > 1 ?
+        (_chain_task*)malloc(nthreads * sizeof(_chain_task)) : NULL;
+    if (!tasks)
+    {
+        tasks = &single;
+        nthreads = 1;
+    }
+
+    _list_repair_jump_table(l, l->jt_size);
+    unsigned s;
+    for (s = 0; s < nthreads; ++s)
+    {
+        lindex start = _segment_bound(l, s, nthreads);
+        tasks[s].start = _segment_start(l, start);
+        tasks[s].count = _segment_bound(l, s + 1, nthreads) - start;
+        tasks[s].nl = nl;
+        tasks[s].filter = filter;
+        tasks[s].map = map;
+    }
+    _run_tasks(_chain_part, tasks, sizeof(_chain_task), nthreads);
+
+    //Join the chains in order.  
+    _node* head = NULL;
+    _node* tail = NULL;
+    lindex size = 0;
+    int failed = 0;
+    for (s = 0; s < nthreads; ++s)
+    {
+        failed |= tasks[s].failed;
+        if (tasks[s].size == 0) continue;
+        if (tail)
+        {
+            tail->next = tasks[s].head;
+            tasks[s].head->prev = tail;
+        }
+        else
+            head = tasks[s].head;
+        tail = tasks[s].tail;
+        size += tasks[s].size;
+    }
+
+    if (tasks != &single)
+        free(tasks);
+    if (failed)
+    {
+        _free_chain(nl, head);
+        free_list(nl);
+        ALLOC_ERROR(NULL);
+        return NULL;
+    }
+
+    if (size > 0)
+        _list_set_new(nl, head, tail, size);
+    return nl;
+}
+
+
+static inline lindex
+_merge_split(const _sort_entry* a, lindex na,
+             const _sort_entry* b, lindex nb, lindex k)
+{
+    lindex lo = k > nb ? k - nb : 0;
+    lindex hi = k < na ? k : na;
+    while (lo < hi)
+    {
+        //Too few values from 'a' if a[i] isn't greater than b[k-i-1].  
+        lindex i = lo + (hi - lo) / 2;
+        if (!LIST_COMPARATOR(b[k-i-1].value, a[i].value))
+            lo = i + 1;
+        else
+            hi = i;
+    }
+    return lo;
+}
+
+
+static inline void*
+_sort_segment(void* task)
+{
+    _sort_segment_task* t = (_sort_segment_task*)task;
+    _node* current = t->start;
+    lindex i = 0;
+    t->sorted = 1;
+    for (; i < t->count; current = current->next, ++i)
+    {
+        t->entries[i].value = current->value;
+        t->entries[i].node = current;
+        if (i > 0 && LIST_COMPARATOR(current->value, t->entries[i-1].value))
+            t->sorted = 0;
+    }
+
+    if (t->sorted)
+        return NULL;
+    if (_RADIX_SORTABLE)
+        _radix_sort_entries(t->entries, t->tmp, t->count);
+    else
+        _merge_sort_entries(t->entries, t->tmp, t->count);
+    return NULL;
+}
+
+
+static inline void*
+_merge_part(void* task)
+{
+    _merge_task* t = (_merge_task*)task;
+    lindex i = _merge_split(t->a, t->na, t->b, t->nb, t->from);
+    lindex j = t->from - i;
+    lindex k = t->from;
+    for (; k < t->to; ++k)
+    {
+        if (j < t->nb && (i == t->na || LIST_COMPARATOR(t->b[j].value,
+                                                        t->a[i].value)))
+            t->dst[k] = t->b[j++];
+        else
+            t->dst[k] = t->a[i++];
+    }
+    return NULL;
+}
+
+
+static inline void*
+_relink_part(void* task)
+{
+    _relink_task* t = (_relink_task*)task;
+    _relink_sorted_range(t->l, t->entries, t->from, t->to);
+    return NULL;
+}
+
+
+static inline void*
+_chain_part(void* task)
+{
+    _chain_task* t = (_chain_task*)task;
+    _node* current = t->start;
+    lindex i = 0;
+    t->head = NULL;
+    t->tail = NULL;
+    t->size = 0;
+    t->failed = 0;
+    for (; i < t->count; current = current->next, ++i)
+    {
+        if (t->filter && !t->filter(current->value))
+            continue;
+
+        _node* node = _new_list_node(t->nl, t->map ? t->map(current->value) :
+                                                     current->value);
+        if (!node)
+        {
+            t->failed = 1;
+            break;
+        }
+        _append(&t->head, &t->tail, node);
+        ++(t->size);
+    }
+    return NULL;
+}
+
+
+static inline void*
+_reduce_part(void* task)
+{
+    _reduce_task* t = (_reduce_task*)task;
+    _node* current = t->start;
+    LIST_DATA_TYPE result = current->value;
+    lindex i = 1;
+    for (; i < t->count; ++i)
+    {
+        current = current->next;
+        result = t->reduce(result, current->value);
+    }
+    t->result = result;
+    return NULL;
+}
+
+
+#endif //CLIST_PARALLEL_H
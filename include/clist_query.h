@@ -0,0 +1,436 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_query.h
+// Lazy, Linq-like queries over clist.h lists.  A query is a list and a short
+// pipeline of where/select/take/skip/take_while stages.  Nothing is evaluated
+// until a terminal operation (any, count, first, to_list) is called, which
+// walks the list once, passing each value through every stage in turn.  
+// Include it after configuring clist.h as usual (it includes clist.h itself).  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CLIST_QUERY_H
+#define CLIST_QUERY_H
+
+#include "clist.h"
+
+
+//Maximum number of stages in a single query.  
+#ifndef LIST_QUERY_MAX_STAGES
+#define LIST_QUERY_MAX_STAGES 16
+#endif
+
+
+//Query filter function signature, called with the value and the stage's ctx.  
+typedef int (*query_filter_func) (LIST_DATA_TYPE, void*);
+//Query select function signature, called with the value and the stage's ctx.  
+typedef LIST_DATA_TYPE (*query_select_func) (LIST_DATA_TYPE, void*);
+//Lazy query over a list.  Do not modify internal contents.  
+typedef struct list_query list_query;
+//Single stage of a query.  
+typedef struct _query_stage _query_stage;
+//State of one evaluation of a query.  
+typedef struct _query_walk _query_walk;
+
+
+enum _query_stage_kind
+{
+    _QUERY_WHERE,
+    _QUERY_SELECT,
+    _QUERY_SKIP,
+    _QUERY_TAKE,
+    _QUERY_TAKE_WHILE,
+};
+
+
+
+/// API functions ///
+
+
+
+/*
+Returns an empty query over the given list, which passes every value.  
+The list must outlive the query, and must not be changed while a terminal
+operation is running.  
+*/
+HOF list_query
+list_query_from(list* l);
+
+/*
+Adds a stage that passes only the values for which 'filter'(value, ctx)
+returns non-zero.  Returns 'q', for chaining.  Calls list_error_handler and
+marks the query as failed if it already has LIST_QUERY_MAX_STAGES stages.  
+*/
+HOF list_query*
+list_query_where(list_query* q, query_filter_func filter, void* ctx);
+
+/*
+Adds a stage that passes 'select'(value, ctx) on instead of each value.  
+Returns 'q', for chaining.  
+*/
+HOF list_query*
+list_query_select(list_query* q, query_select_func select, void* ctx);
+
+/*
+Adds a stage that drops the first 'n' values reaching it.  Returns 'q', for
+chaining.  
+*/
+HOF list_query*
+list_query_skip(list_query* q, lindex n);
+
+/*
+Adds a stage that passes at most 'n' values.  The walk stops as soon as the
+'n'th value has passed it.  Returns 'q', for chaining.  
+*/
+HOF list_query*
+list_query_take(list_query* q, lindex n);
+
+/*
+Adds a stage that passes values until the first one for which
+'filter'(value, ctx) returns zero, where the walk stops.  Returns 'q', for
+chaining.  
+*/
+HOF list_query*
+list_query_take_while(list_query* q, query_filter_func filter, void* ctx);
+
+/*
+Returns 1 if the query yields at least one value, 0 otherwise.  Stops at the
+first value.  Calls list_error_handler and returns 0 if the query's list is
+NULL or the query failed.  
+*/
+HOF int
+list_query_any(const list_query* q);
+
+/*
+Returns the number of values the query yields.  Calls list_error_handler and
+returns INDEX_ERR_RETURN_VALUE if the query's list is NULL or the query
+failed.  
+*/
+HOF lindex
+list_query_count(const list_query* q);
+
+/*
+Stores the first value the query yields in 'out' and returns 1, or returns 0
+if it yields none.  Stops at the first value.  Calls list_error_handler and
+returns 0 if the query's list is NULL or the query failed.  
+*/
+HOF int
+list_query_first(const list_query* q, LIST_DATA_TYPE* out);
+
+/*
+Returns a newly created list containing the values the query yields, in
+order.  Returns NULL on memory allocation failure.  Calls list_error_handler
+and returns NULL if the query's list is NULL or the query failed.  
+*/
+HOF list*
+list_query_to_list(const list_query* q);
+
+
+
+/// Internal functions ///
+
+
+
+/*
+Internal function that appends a stage to the query, or calls
+list_error_handler and marks the query as failed if it is full.  
+*/
+HOF list_query*
+_query_add_stage(list_query* q, _query_stage stage, const char* func);
+
+/*
+Internal function that calls list_error_handler if the query can't be run.  
+Returns -1 if there is an error and 0 otherwise.  
+*/
+HOF int
+_query_error(const list_query* q, const char* func);
+
+/*
+Internal function that prepares a walk of the query's list.  
+*/
+HOF void
+_query_start(_query_walk* w, const list_query* q);
+
+/*
+Internal function that stores the next value the query yields in 'out'.  
+Returns 1 if there was one, 0 once the walk is over.  
+*/
+HOF int
+_query_next(_query_walk* w, LIST_DATA_TYPE* out);
+
+
+
+struct _query_stage
+{
+    enum _query_stage_kind kind;
+    query_filter_func      filter;
+    query_select_func      select;
+    void*                  ctx;
+    lindex                 n;
+};
+
+struct list_query
+{
+    list*        l;
+    unsigned     count;
+    int          failed;
+    _query_stage stages[LIST_QUERY_MAX_STAGES];
+};
+
+struct _query_walk
+{
+    const list_query* q;
+    #if LIST_STORAGE == LIST_STORAGE_NODES
+        _node*        node;
+    #else
+        lindex        index;
+    #endif
+    //Values seen so far by each skip and take stage.  
+    lindex            seen[LIST_QUERY_MAX_STAGES];
+    int               done;
+};
+
+#define QUERY_ERROR(q) _query_error(q, __func__)
+
+
+
+
+static inline list_query
+list_query_from(list* l)
+{
+    list_query q;
+    q.l = l;
+    q.count = 0;
+    q.failed = 0;
+    return q;
+}
+
+
+static inline list_query*
+list_query_where(list_query* q, query_filter_func filter, void* ctx)
+{
+    _query_stage stage = {_QUERY_WHERE, filter, NULL, ctx, 0};
+    return _query_add_stage(q, stage, __func__);
+}
+
+
+static inline list_query*
+list_query_select(list_query* q, query_select_func select, void* ctx)
+{
+    _query_stage stage = {_QUERY_SELECT, NULL, select, ctx, 0};
+    return _query_add_stage(q, stage, __func__);
+}
+
+
+static inline list_query*
+list_query_skip(list_query* q, lindex n)
+{
+    _query_stage stage = {_QUERY_SKIP, NULL, NULL, NULL, n};
+    return _query_add_stage(q, stage, __func__);
+}
+
+
+static inline list_query*
+list_query_take(list_query* q, lindex n)
+{
+    _query_stage stage = {_QUERY_TAKE, NULL, NULL, NULL, n};
+    return _query_add_stage(q, stage, __func__);
+}
+
+
+static inline list_query*
+list_query_take_while(list_query* q, query_filter_func filter, void* ctx)
+{
+    _query_stage stage = {_QUERY_TAKE_WHILE, filter, NULL, ctx, 0};
+    return _query_add_stage(q, stage, __func__);
+}
+
+
+static inline int
+list_query_any(const list_query* q)
+{
+    if (QUERY_ERROR(q)) return 0;
+
+    LIST_DATA_TYPE value;
+    _query_walk w;
+    _query_start(&w, q);
+    return _query_next(&w, &value);
+}
+
+
+static inline lindex
+list_query_count(const list_query* q)
+{
+    if (QUERY_ERROR(q)) return INDEX_ERR_RETURN_VALUE;
+
+    LIST_DATA_TYPE value;
+    _query_walk w;
+    _query_start(&w, q);
+    lindex count = 0;
+    while (_query_next(&w, &value))
+        ++count;
+    return count;
+}
+
+
+static inline int
+list_query_first(const list_query* q, LIST_DATA_TYPE* out)
+{
+    if (QUERY_ERROR(q)) return 0;
+
+    _query_walk w;
+    _query_start(&w, q);
+    return _query_next(&w, out);
+}
+
+
+static inline list*
+list_query_to_list(const list_query* q)
+{
+    if (QUERY_ERROR(q)) return NULL;
+    list* nl = new_list();
+    if (ALLOC_ERROR(nl)) return NULL;
+
+    LIST_DATA_TYPE value;
+    _query_walk w;
+    _query_start(&w, q);
+    while (_query_next(&w, &value))
+    {
+        lindex size = nl->size;
+        list_add(nl, value);
+        if (nl->size == size)
+        {
+            //The values belong to the original list.  
+            while (nl->size > 0)
+                list_pop(nl);
+            free_list(nl);
+            return NULL;
+        }
+    }
+    return nl;
+}
+
+
+/// Internal functions ///
+
+
+static inline list_query*
+_query_add_stage(list_query* q, _query_stage stage, const char* func)
+{
+    if (!q) return NULL;
+    if (q->count == LIST_QUERY_MAX_STAGES)
+    {
+        list_error_handler(NULL)\
+        (func, "q", "Query has too many stages!\n");
+        q->failed = 1;
+        return q;
+    }
+
+    q->stages[q->count++] = stage;
+    return q;
+}
+
+
+static inline int
+_query_error(const list_query* q, const char* func)
+{
+    if (!q || !q->l)
+    {
+        list_error_handler(NULL)\
+        (func, "q", "NULL list argument!\n");
+        return -1;
+    }
+    if (q->failed)
+    {
+        list_error_handler(NULL)\
+        (func, "q", "Query has too many stages!\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+static inline void
+_query_start(_query_walk* w, const list_query* q)
+{
+    w->q = q;
+    #if LIST_STORAGE == LIST_STORAGE_NODES
+        w->node = q->l->head;
+    #else
+        w->index = 0;
+    #endif
+    w->done = 0;
+
+    unsigned s = 0;
+    for (; s < q->count; ++s)
+    {
+        w->seen[s] = 0;
+        if (q->stages[s].kind == _QUERY_TAKE && q->stages[s].n == 0)
+            w->done = 1;
+    }
+}
+
+
+static inline int
+_query_next(_query_walk* w, LIST_DATA_TYPE* out)
+{
+    const list_query* q = w->q;
+    while (!w->done)
+    {
+        LIST_DATA_TYPE value;
+        #if LIST_STORAGE == LIST_STORAGE_NODES
+            if (w->node == NULL) return 0;
+            value = w->node->value;
+            w->node = w->node->next;
+        #else
+            if (w->index >= q->l->size) return 0;
+            value = list_get(q->l, w->index++);
+        #endif
+
+        int passed = 1;
+        unsigned s = 0;
+        for (; s < q->count && passed; ++s)
+        {
+            const _query_stage* stage = &q->stages[s];
+            switch (stage->kind)
+            {
+                case _QUERY_WHERE:
+                    passed = stage->filter(value, stage->ctx) != 0;
+                    break;
+                case _QUERY_SELECT:
+                    value = stage->select(value, stage->ctx);
+                    break;
+                case _QUERY_SKIP:
+                    if (w->seen[s] < stage->n)
+                    {
+                        ++w->seen[s];
+                        passed = 0;
+                    }
+                    break;
+                case _QUERY_TAKE:
+                    //The value passes, but it is the last one.  
+                    if (++w->seen[s] == stage->n)
+                        w->done = 1;
+                    break;
+                case _QUERY_TAKE_WHILE:
+                    if (!stage->filter(value, stage->ctx))
+                    {
+                        w->done = 1;
+                        return 0;
+                    }
+                    break;
+            }
+        }
+
+        if (passed)
+        {
+            *out = value;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+#endif //CLIST_QUERY_H
@@ -0,0 +1,397 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_typed.h
+// Generator for lists of a given element type.  CLIST_DEFINE(prefix, T, cmp)
+// defines 'prefix'_list, holding T values directly in its nodes and sorted
+// with 'cmp' called directly, along with 'prefix'_add(), 'prefix'_get(),
+// etc.  Any number of typed lists can be defined in one translation unit,
+// next to the LIST_DATA_TYPE list of clist.h (which it includes).  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CLIST_TYPED_H
+#define CLIST_TYPED_H
+
+#include "clist.h"
+
+
+
+/// API ///
+
+
+
+/*
+Defines the following, where 'cmp'(a, b) returns non-zero if 'a' goes before
+'b'.  Lookups start from the closest of the head, the tail, the last value
+looked up and an entry of a jump_table kept every JT_INCREMENT values, as in
+clist.h.  Errors call list_error_handler, and functions returning a T then
+return a zeroed T.  
+
+'prefix'_list
+    List of T values.  Do not modify internal contents.  
+
+'prefix'_list* 'prefix'_new(void)
+    Returns a newly allocated list, or NULL if memory allocation failed.  
+    User must free with 'prefix'_free.  
+
+void 'prefix'_free('prefix'_list* l)
+    Frees the list and its nodes.  
+
+lindex 'prefix'_size(const 'prefix'_list* l)
+    Returns the number of values in the list.  
+
+void 'prefix'_add('prefix'_list* l, T value)
+    Adds the given value to the end of the list.  
+
+void 'prefix'_insert('prefix'_list* l, lindex index, T value)
+    Inserts the given value at 'index', which may be the size of the list.  
+
+T 'prefix'_get('prefix'_list* l, lindex index)
+    Returns the value at 'index'.  
+
+void 'prefix'_set('prefix'_list* l, lindex index, T value)
+    Replaces the value at 'index'.  
+
+T 'prefix'_remove('prefix'_list* l, lindex index)
+    Removes the value at 'index' and returns it.  
+
+T 'prefix'_pop('prefix'_list* l)
+    Removes the last value and returns it.  
+
+void 'prefix'_sort('prefix'_list* l)
+    Stable sort of the list by 'cmp', see sort_list().  
+*/
+#define CLIST_DEFINE(prefix, T, cmp)                                          \
+                                                                              \
+typedef struct prefix##_node prefix##_node;                                   \
+typedef struct prefix##_list prefix##_list;                                   \
+                                                                              \
+struct prefix##_node                                                          \
+{                                                                             \
+    T value;                                                                  \
+    prefix##_node* next;                                                      \
+    prefix##_node* prev;                                                      \
+};                                                                            \
+                                                                              \
+struct prefix##_list                                                          \
+{                                                                             \
+    lindex size;                                                              \
+    lindex jt_size;                                                           \
+    /* Leading jump_table entries known to be up to date. */                  \
+    lindex jt_valid;                                                          \
+    lindex current_index;                                                     \
+    prefix##_node*  head;                                                     \
+    prefix##_node*  tail;                                                     \
+    prefix##_node** jump_table;                                               \
+    prefix##_node*  current;                                                  \
+};                                                                            \
+                                                                              \
+_DEFINE_NATURAL_MERGE_SORT(_##prefix##_merge_sort, T, cmp)                    \
+                                                                              \
+/* Grows the jump_table to hold an entry for every value of a list of         \
+   'size' values.  Returns -1 on allocation failure, 0 otherwise. */          \
+static inline int                                                             \
+_##prefix##_reserve(prefix##_list* l, lindex size)                            \
+{                                                                             \
+    lindex needed = (size - 1) / JT_INCREMENT + 1;                            \
+    if (l->jt_size >= needed)                                                 \
+        return 0;                                                             \
+    prefix##_node** table = (prefix##_node**)                                 \
+        realloc(l->jump_table, needed * 2 * sizeof(prefix##_node*));          \
+    if (!table)                                                               \
+        return -1;                                                            \
+    l->jump_table = table;                                                    \
+    l->jt_size = needed * 2;                                                  \
+    return 0;                                                                 \
+}                                                                             \
+                                                                              \
+/* Returns the node at 'index' and makes it the current node.  Stale          \
+   jump_table entries are brought up to date as the walk passes them. */      \
+static inline prefix##_node*                                                  \
+_##prefix##_node_at(prefix##_list* l, lindex index)                           \
+{                                                                             \
+    if (l->jt_valid == 0)                                                     \
+    {                                                                         \
+        l->jump_table[0] = l->head;                                           \
+        l->jt_valid = 1;                                                      \
+    }                                                                         \
+    lindex entry = index / JT_INCREMENT;                                      \
+    if (entry >= l->jt_valid)                                                 \
+        entry = l->jt_valid - 1;                                              \
+    prefix##_node* node = l->jump_table[entry];                               \
+    lindex at = entry * JT_INCREMENT;                                         \
+                                                                              \
+    if (l->current)                                                           \
+    {                                                                         \
+        lindex c = l->current_index;                                          \
+        if ((c > index ? c - index : index - c) < index - at)                 \
+        {                                                                     \
+            node = l->current;                                                \
+            at = c;                                                           \
+        }                                                                     \
+    }                                                                         \
+    if (l->size - 1 - index < (at > index ? at - index : index - at))         \
+    {                                                                         \
+        node = l->tail;                                                       \
+        at = l->size - 1;                                                     \
+    }                                                                         \
+                                                                              \
+    for (; at < index; ++at)                                                  \
+    {                                                                         \
+        node = node->next;                                                    \
+        if (at + 1 == l->jt_valid * JT_INCREMENT)                             \
+            l->jump_table[l->jt_valid++] = node;                              \
+    }                                                                         \
+    for (; at > index; --at)                                                  \
+        node = node->prev;                                                    \
+                                                                              \
+    l->current = node;                                                        \
+    l->current_index = index;                                                 \
+    return node;                                                              \
+}                                                                             \
+                                                                              \
+static inline T                                                               \
+_##prefix##_zero(void)                                                        \
+{                                                                             \
+    T zero;                                                                   \
+    memset(&zero, 0, sizeof(T));                                              \
+    return zero;                                                              \
+}                                                                             \
+                                                                              \
+static inline prefix##_list*                                                  \
+prefix##_new(void)                                                            \
+{                                                                             \
+    return (prefix##_list*)calloc(1, sizeof(prefix##_list));                  \
+}                                                                             \
+                                                                              \
+static inline void                                                            \
+prefix##_free(prefix##_list* l)                                               \
+{                                                                             \
+    if (!l) return;                                                           \
+    prefix##_node* node = l->head;                                            \
+    while (node != NULL)                                                      \
+    {                                                                         \
+        prefix##_node* next = node->next;                                     \
+        free(node);                                                           \
+        node = next;                                                          \
+    }                                                                         \
+    free(l->jump_table);                                                      \
+    free(l);                                                                  \
+}                                                                             \
+                                                                              \
+static inline lindex                                                          \
+prefix##_size(const prefix##_list* l)                                         \
+{                                                                             \
+    if (_typed_null_arg_error(l, __func__)) return INDEX_ERR_RETURN_VALUE;    \
+    return l->size;                                                           \
+}                                                                             \
+                                                                              \
+static inline void                                                            \
+prefix##_add(prefix##_list* l, T value)                                       \
+{                                                                             \
+    if (_typed_null_arg_error(l, __func__)) return;                           \
+    prefix##_node* node = (prefix##_node*)malloc(sizeof(prefix##_node));      \
+    if (ALLOC_ERROR(node)) return;                                            \
+    if (_##prefix##_reserve(l, l->size + 1))                                  \
+    {                                                                         \
+        free(node);                                                           \
+        ALLOC_ERROR(NULL);                                                    \
+        return;                                                               \
+    }                                                                         \
+                                                                              \
+    node->value = value;                                                      \
+    node->next = NULL;                                                        \
+    node->prev = l->tail;                                                     \
+    if (l->tail)                                                              \
+        l->tail->next = node;                                                 \
+    else                                                                      \
+        l->head = node;                                                       \
+    l->tail = node;                                                           \
+                                                                              \
+    if (l->size == l->jt_valid * JT_INCREMENT)                                \
+        l->jump_table[l->jt_valid++] = node;                                  \
+    ++(l->size);                                                              \
+}                                                                             \
+                                                                              \
+static inline void                                                            \
+prefix##_insert(prefix##_list* l, lindex index, T value)                      \
+{                                                                             \
+    if (_typed_null_arg_error(l, __func__)) return;                           \
+    if (index == l->size)                                                     \
+    {                                                                         \
+        prefix##_add(l, value);                                               \
+        return;                                                               \
+    }                                                                         \
+    if (_typed_index_error(index, l->size, __func__)) return;                 \
+    prefix##_node* node = (prefix##_node*)malloc(sizeof(prefix##_node));      \
+    if (ALLOC_ERROR(node)) return;                                            \
+    if (_##prefix##_reserve(l, l->size + 1))                                  \
+    {                                                                         \
+        free(node);                                                           \
+        ALLOC_ERROR(NULL);                                                    \
+        return;                                                               \
+    }                                                                         \
+                                                                              \
+    prefix##_node* next = _##prefix##_node_at(l, index);                      \
+    node->value = value;                                                      \
+    node->next = next;                                                        \
+    node->prev = next->prev;                                                  \
+    if (next->prev)                                                           \
+        next->prev->next = node;                                              \
+    else                                                                      \
+        l->head = node;                                                       \
+    next->prev = node;                                                        \
+                                                                              \
+    /* Entries from 'index' on now point one value too early. */              \
+    lindex valid = (index + JT_INCREMENT - 1) / JT_INCREMENT;                 \
+    if (l->jt_valid > valid)                                                  \
+        l->jt_valid = valid;                                                  \
+    ++(l->current_index);                                                     \
+    ++(l->size);                                                              \
+}                                                                             \
+                                                                              \
+static inline T                                                               \
+prefix##_get(prefix##_list* l, lindex index)                                  \
+{                                                                             \
+    if (_typed_null_arg_error(l, __func__)) return _##prefix##_zero();        \
+    if (_typed_index_error(index, l->size, __func__))                         \
+        return _##prefix##_zero();                                            \
+    return _##prefix##_node_at(l, index)->value;                              \
+}                                                                             \
+                                                                              \
+static inline void                                                            \
+prefix##_set(prefix##_list* l, lindex index, T value)                         \
+{                                                                             \
+    if (_typed_null_arg_error(l, __func__)) return;                           \
+    if (_typed_index_error(index, l->size, __func__)) return;                 \
+    _##prefix##_node_at(l, index)->value = value;                             \
+}                                                                             \
+                                                                              \
+static inline T                                                               \
+prefix##_remove(prefix##_list* l, lindex index)                               \
+{                                                                             \
+    if (_typed_null_arg_error(l, __func__)) return _##prefix##_zero();        \
+    if (_typed_index_error(index, l->size, __func__))                         \
+        return _##prefix##_zero();                                            \
+                                                                              \
+    prefix##_node* node = _##prefix##_node_at(l, index);                      \
+    if (node->prev)                                                           \
+        node->prev->next = node->next;                                        \
+    else                                                                      \
+        l->head = node->next;                                                 \
+    if (node->next)                                                           \
+        node->next->prev = node->prev;                                        \
+    else                                                                      \
+        l->tail = node->prev;                                                 \
+                                                                              \
+    lindex valid = (index + JT_INCREMENT - 1) / JT_INCREMENT;                 \
+    if (l->jt_valid > valid)                                                  \
+        l->jt_valid = valid;                                                  \
+    l->current = NULL;                                                        \
+    --(l->size);                                                              \
+                                                                              \
+    T value = node->value;                                                    \
+    free(node);                                                               \
+    return value;                                                             \
+}                                                                             \
+                                                                              \
+static inline T                                                               \
+prefix##_pop(prefix##_list* l)                                                \
+{                                                                             \
+    if (_typed_null_arg_error(l, __func__)) return _##prefix##_zero();        \
+    if (_typed_size_error(l->size, __func__)) return _##prefix##_zero();      \
+    return prefix##_remove(l, l->size - 1);                                   \
+}                                                                             \
+                                                                              \
+static inline void                                                            \
+prefix##_sort(prefix##_list* l)                                               \
+{                                                                             \
+    if (_typed_null_arg_error(l, __func__)) return;                           \
+    if (l->size < 2) return;                                                  \
+    T* values = (T*)malloc(l->size * 2 * sizeof(T));                          \
+    if (ALLOC_ERROR(values)) return;                                          \
+                                                                              \
+    /* Only values move, so the nodes and jump_table stay valid. */           \
+    prefix##_node* node = l->head;                                            \
+    lindex i = 0;                                                             \
+    for (; i < l->size; ++i, node = node->next)                               \
+        values[i] = node->value;                                              \
+    _##prefix##_merge_sort(values, values + l->size, l->size);                \
+    for (i = 0, node = l->head; i < l->size; ++i, node = node->next)          \
+        node->value = values[i];                                              \
+    free(values);                                                             \
+}
+
+
+
+/// Internal functions ///
+
+
+
+/*
+Internal function that calls list_error_handler if the typed list is NULL.  
+Returns -1 if there is an error and 0 otherwise.  
+*/
+HOF int
+_typed_null_arg_error(const void* l, const char* func);
+
+/*
+Internal function that calls list_error_handler if 'index' is not below
+'size'.  Returns -1 if there is an error and 0 otherwise.  
+*/
+HOF int
+_typed_index_error(lindex index, lindex size, const char* func);
+
+/*
+Internal function that calls list_error_handler if 'size' is 0.  
+Returns -1 if there is an error and 0 otherwise.  
+*/
+HOF int
+_typed_size_error(lindex size, const char* func);
+
+
+
+
+static inline int
+_typed_null_arg_error(const void* l, const char* func)
+{
+    if (!l)
+    {
+        list_error_handler(NULL)\
+        (func, "NA", "Given list was NULL!\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+static inline int
+_typed_index_error(lindex index, lindex size, const char* func)
+{
+    if (index >= size)
+    {
+        char arg_as_string[24];
+        sprintf(arg_as_string, "(%ld)", index);
+        list_error_handler(NULL)\
+        (func, arg_as_string, "Index out of range!\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+static inline int
+_typed_size_error(lindex size, const char* func)
+{
+    if (size == 0)
+    {
+        list_error_handler(NULL)\
+        (func, "NA", "list contains no items!\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+#endif //CLIST_TYPED_H
@@ -0,0 +1,1181 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_unrolled.h
+// Unrolled storage for clist.h.  Values are stored in doubly linked chunks of
+// up to LIST_CHUNK_CAPACITY values and the jump_table indexes chunks, so
+// reaching an index costs one pointer hop per chunk instead of per value.  
+// Selected by putting
+//     #define LIST_STORAGE LIST_STORAGE_UNROLLED
+// before including clist.h.  Not intended to be included directly.  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CLIST_UNROLLED_H
+#define CLIST_UNROLLED_H
+
+
+//Maximum number of values stored in a single chunk.  
+#ifndef LIST_CHUNK_CAPACITY
+#define LIST_CHUNK_CAPACITY 32
+#endif
+
+
+//list chunk structure.  
+typedef struct _chunk _chunk;
+//jump_table entry, a chunk and the list index of its first value.  
+typedef struct _jt_entry _jt_entry;
+
+
+
+/// Internal functions ///
+
+
+
+/*
+Frees all memory associated with the list strucutre,
+but not the chunks (if any).  
+*/
+HOF void
+_free_list_structures(list* l);
+
+/*
+Internal function that returns a pointer to a newly allocated, empty chunk.  
+*/
+HOF _chunk*
+_new_chunk(void);
+
+/*
+Internal function that links a new, empty chunk into the list as its tail,
+indexing it if JT_INCREMENT values have been added since the last indexed
+chunk.  Returns the chunk, or NULL and calls list_error_handler if there is a
+memory allocation error.  
+*/
+HOF _chunk*
+_list_new_tail_chunk(list* l);
+
+/*
+Internal function that links the given chunk into the list as its new tail.  
+*/
+HOF void
+_link_tail_chunk(list* l, _chunk* c);
+
+/*
+Internal function that removes the given chunk from the list's chain.  
+*/
+HOF void
+_unlink_chunk(list* l, _chunk* c);
+
+/*
+Internal function that moves the values of 'c' from 'offset' onward into a
+new chunk linked in after 'c'.  Returns the new chunk or NULL on allocation
+failure.  
+*/
+HOF _chunk*
+_split_chunk_at(list* l, _chunk* c, unsigned offset);
+
+/*
+Internal function that frees the given, empty, chunk.  'entry' is the last
+jump_table entry that does not come after the chunk.  
+*/
+HOF void
+_remove_chunk(list* l, _chunk* c, lindex entry);
+
+/*
+Internal function that moves the values of the chunk after 'c' into 'c' if
+'c' has become less than a quarter full and both fit in one chunk.  'start'
+is the index of c's first value and 'entry' the last jump_table entry that
+does not come after 'c'.  
+*/
+HOF void
+_merge_with_next_chunk(list* l, _chunk* c, lindex start, lindex entry);
+
+/*
+Internal function that returns the position of the last jump_table entry
+whose chunk starts at or before the given index.  
+*/
+HOF lindex
+_jt_search(const list* l, lindex index);
+
+/*
+Internal function that returns the chunk containing the given index.  Starts
+from the closest of the surrounding jump_table entries, the tail and
+l->current.  Sets 'start' to the index of the chunk's first value and 'entry'
+to the position of the last jump_table entry at or before the index.  
+*/
+HOF _chunk*
+_list_chunk_at(const list* l, lindex index, lindex* start, lindex* entry);
+
+/*
+Internal function that walks from chunk 'c', whose first value is at index
+'s', to the chunk containing 'index'.  Sets 'start' to the index of that
+chunk's first value.  
+*/
+HOF _chunk*
+_walk_to_chunk(_chunk* c, lindex s, lindex index, lindex* start);
+
+/*
+Internal function that expands the jump_table of the given list,
+to the specified size.  Returns -1 on allocation failure, 0 otherwise.  
+*/
+HOF int
+_list_grow_jump_table(list* l, lindex new_size);
+
+/*
+Internal function that inserts a jump_table entry for chunk 'c', starting at
+'start', at position 'pos' in the table.  Returns -1 on allocation failure.  
+*/
+HOF int
+_list_insert_jt_entry(list* l, lindex pos, _chunk* c, lindex start);
+
+/*
+Internal function that points the jump_table entry at 'pos' to the given chunk,
+or removes the entry if 'c' is NULL or already has a neighbouring entry.  
+*/
+HOF void
+_list_redirect_jt_entry(list* l, lindex pos, _chunk* c, lindex start);
+
+/*
+Internal function that adds 'delta' (+1 or -1) to the start index of every
+jump_table entry from position 'pos' onward.  For use with insert/remove.  
+*/
+HOF void
+_list_shift_jump_table(list* l, lindex pos, int delta);
+
+/*
+Internal function that adds a jump_table entry after position 'pos' if the
+gap between it and the next entry (or the end) grew beyond 2*JT_INCREMENT.  
+*/
+HOF void
+_list_balance_jump_table(list* l, lindex pos);
+
+/*
+Internal function that rebuilds the jump_table by walking every chunk,
+adding an entry every JT_INCREMENT values.  
+*/
+HOF void
+_list_rebuild_jump_table(list* l);
+
+
+struct _chunk
+{
+    _chunk*  next;
+    _chunk*  prev;
+    unsigned count;
+    LIST_DATA_TYPE values[LIST_CHUNK_CAPACITY];
+};
+
+struct _jt_entry
+{
+    _chunk*  chunk;
+    lindex   start;
+};
+
+struct list
+{
+    lindex     size;
+    lindex     jt_size;
+    lindex     jt_count;
+    lindex     current_index;
+    _chunk*    head;
+    _chunk*    tail;
+    _jt_entry* jump_table;
+    _chunk*    current;
+};
+
+
+
+static inline list*
+new_list(void)
+{
+    //Allocate list struct.  
+    list* l = (list*)calloc(1, sizeof(list));
+    if (!l) return NULL;
+
+    //Allocate jump table.  
+    l->jump_table = (_jt_entry*)calloc(INITIAL_JT_SIZE, sizeof(_jt_entry));
+    if (!l->jump_table)
+    {
+        free(l);
+        return NULL;
+    }
+    l->jt_size = INITIAL_JT_SIZE;
+
+    return l;
+}
+
+
+static inline void
+free_list(list* l)
+{
+    if (!l) return;
+
+    _chunk* current = l->head;
+    while (current != NULL)
+    {
+        #if FREE_LIST_ITEMS
+            unsigned i;
+            for (i = 0; i < current->count; ++i)
+                free(current->values[i]);
+        #endif
+
+        _chunk* next = current->next;
+        free(current);
+        current = next;
+    }
+
+    _free_list_structures(l);
+}
+
+
+static inline void
+list_add(list* l, LIST_DATA_TYPE value)
+{
+    if (NULL_ARG_ERROR(l)) return;
+
+    _list_add(l, value);
+}
+
+
+static inline LIST_DATA_TYPE
+list_pop(list* l)
+{
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (SIZE_ERROR(l)) return ERROR_RETURN_VALUE;
+
+    _chunk* tail = l->tail;
+    LIST_DATA_TYPE value = tail->values[--(tail->count)];
+    --(l->size);
+
+    if (tail->count == 0)
+        _remove_chunk(l, tail, l->jt_count - 1);
+    return value;
+}
+
+
+static inline LIST_DATA_TYPE
+list_get(list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (INDEX_ERROR(l, index)) return ERROR_RETURN_VALUE;
+
+    return *_list_ref_at(l, index);
+}
+
+
+static inline LIST_DATA_TYPE
+list_get_const(const list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (INDEX_ERROR(l, index)) return ERROR_RETURN_VALUE;
+
+    //l->current may be a starting point, but it isn't moved.  
+    lindex start, entry;
+    _chunk* c = _list_chunk_at(l, index, &start, &entry);
+    return c->values[index - start];
+}
+
+
+static inline LIST_DATA_TYPE*
+list_get_ref(list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    if (INDEX_ERROR(l, index)) return NULL;
+
+    return _list_ref_at(l, index);
+}
+
+
+static inline void
+list_insert(list* l, lindex index, LIST_DATA_TYPE value)
+{
+    if (NULL_ARG_ERROR(l)) return;
+    if (l->size == 0)
+    {
+        list_add(l, value);
+        return;
+    }
+    if (INDEX_ERROR(l, index)) return;
+
+    lindex start, entry;
+    _chunk* c = _list_chunk_at(l, index, &start, &entry);
+    if (c->count == LIST_CHUNK_CAPACITY)
+    {
+        _chunk* upper = _split_chunk_at(l, c, LIST_CHUNK_CAPACITY / 2);
+        if (ALLOC_ERROR(upper)) return;
+
+        if (index - start > c->count)
+        {
+            start += c->count;
+            c = upper;
+        }
+    }
+
+    unsigned offset = (unsigned)(index - start);
+    memmove(&c->values[offset+1], &c->values[offset],
+            (c->count - offset) * sizeof(LIST_DATA_TYPE));
+    c->values[offset] = value;
+    ++(c->count);
+    ++(l->size);
+
+    //Every chunk after the indexed one now starts one later.  
+    _list_shift_jump_table(l, entry + 1, 1);
+    if (l->current && l->current_index > index)
+        ++(l->current_index);
+    _list_balance_jump_table(l, entry);
+}
+
+
+static inline LIST_DATA_TYPE
+list_remove(list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return ERROR_RETURN_VALUE;
+    if (INDEX_ERROR(l, index)) return ERROR_RETURN_VALUE;
+
+    lindex start, entry;
+    _chunk* c = _list_chunk_at(l, index, &start, &entry);
+    unsigned offset = (unsigned)(index - start);
+    LIST_DATA_TYPE value = c->values[offset];
+
+    memmove(&c->values[offset], &c->values[offset+1],
+            (c->count - offset - 1) * sizeof(LIST_DATA_TYPE));
+    --(c->count);
+    --(l->size);
+
+    _list_shift_jump_table(l, entry + 1, -1);
+    if (l->current && l->current_index > index)
+        --(l->current_index);
+
+    if (c->count == 0)
+        _remove_chunk(l, c, entry);
+    else
+        _merge_with_next_chunk(l, c, start, entry);
+    return value;
+}
+
+
+static inline lindex
+list_size(const list* l)
+{
+    if (NULL_ARG_ERROR(l)) return INDEX_ERR_RETURN_VALUE;
+
+    return l->size;
+}
+
+
+static inline void
+sort_list(list* l)
+{
+    if (NULL_ARG_ERROR(l)) return;
+    if (l->size < 2) return;
+
+    //Values have no identity in a chunk, so sort a copy and write it back.  
+    //Chunk fill counts, and therefore the jump_table, are unchanged.  
+    LIST_DATA_TYPE* values = (LIST_DATA_TYPE*)malloc(l->size * sizeof(LIST_DATA_TYPE));
+    LIST_DATA_TYPE* tmp = (LIST_DATA_TYPE*)malloc(l->size * sizeof(LIST_DATA_TYPE));
+    if (!values || !tmp)
+    {
+        free(values);
+        free(tmp);
+        ALLOC_ERROR(NULL);
+        return;
+    }
+
+    lindex i = 0;
+    _chunk* c;
+    for (c = l->head; c != NULL; c = c->next)
+    {
+        memcpy(&values[i], c->values, c->count * sizeof(LIST_DATA_TYPE));
+        i += c->count;
+    }
+
+    _merge_sort_values(values, tmp, l->size);
+
+    i = 0;
+    for (c = l->head; c != NULL; c = c->next)
+    {
+        memcpy(c->values, &values[i], c->count * sizeof(LIST_DATA_TYPE));
+        i += c->count;
+    }
+
+    free(values);
+    free(tmp);
+}
+
+
+static inline list*
+list_where(list* l, filter_func filter)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    list* new_collection = new_list();
+    if (ALLOC_ERROR(new_collection)) return NULL;
+
+    _chunk* c;
+    for (c = l->head; c != NULL; c = c->next)
+    {
+        unsigned i;
+        for (i = 0; i < c->count; ++i)
+        {
+            if (filter(c->values[i]))
+                list_add(new_collection, c->values[i]);
+        }
+    }
+
+    return new_collection;
+}
+
+
+static inline void
+list_merge(list* first, list* second)
+{
+    if (NULL_ARG_ERROR(first)) return;
+    if (second == NULL || second->size == 0) return;
+
+    lindex needed = first->jt_count + second->jt_count;
+    if (needed > first->jt_size)
+        if (_list_grow_jump_table(first, needed * 2)) return;
+
+    //Second list's entries follow the first's, shifted by its size.  
+    lindex i;
+    for (i = 0; i < second->jt_count; ++i)
+    {
+        _jt_entry e = second->jump_table[i];
+        e.start += first->size;
+        first->jump_table[first->jt_count++] = e;
+    }
+
+    if (first->tail)
+    {
+        first->tail->next = second->head;
+        second->head->prev = first->tail;
+    }
+    else
+        first->head = second->head;
+    first->tail = second->tail;
+    first->size += second->size;
+
+    _free_list_structures(second);
+}
+
+
+static inline list*
+list_split(list* l, lindex index)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    if (INDEX_ERROR(l, index)) return NULL;
+    if (index == 0)
+        return new_list();
+
+    list* nl = new_list();
+    if (ALLOC_ERROR(nl)) return NULL;
+
+    lindex start, entry;
+    _chunk* c = _list_chunk_at(l, index, &start, &entry);
+    if (index > start)
+    {
+        c = _split_chunk_at(l, c, (unsigned)(index - start));
+        if (ALLOC_ERROR(c))
+        {
+            free_list(nl);
+            return NULL;
+        }
+        start = index;
+    }
+
+    //Entries at or after the split point move to the new list.  
+    lindex first_moved = entry;
+    if (l->jump_table[entry].start < index)
+        ++first_moved;
+    lindex moved = l->jt_count - first_moved;
+    if (moved + 1 > nl->jt_size && _list_grow_jump_table(nl, moved + 1))
+    {
+        free_list(nl);
+        return NULL;
+    }
+
+    if (moved == 0 || l->jump_table[first_moved].chunk != c)
+        _list_insert_jt_entry(nl, 0, c, 0);
+    lindex i;
+    for (i = first_moved; i < l->jt_count; ++i)
+    {
+        _jt_entry e = l->jump_table[i];
+        e.start -= index;
+        nl->jump_table[nl->jt_count++] = e;
+    }
+    l->jt_count = first_moved;
+
+    nl->head = c;
+    nl->tail = l->tail;
+    nl->size = l->size - index;
+    l->tail = c->prev;
+    l->tail->next = NULL;
+    c->prev = NULL;
+    l->size = index;
+
+    if (l->current && l->current_index >= index)
+        l->current = NULL;
+
+    return nl;
+}
+
+
+static inline list*
+list_split_where(list* l, filter_func filter)
+{
+    if (NULL_ARG_ERROR(l)) return NULL;
+    list* nl = new_list();
+    if (ALLOC_ERROR(nl)) return NULL;
+
+    //Compact the values that stay into the front of l's chunks.  The write
+    //position can never pass the read position because every chunk it
+    //passes is filled to capacity.  
+    _chunk* w = l->head;
+    unsigned w_count = 0;
+    lindex kept = 0;
+    _chunk* r;
+    for (r = l->head; r != NULL; r = r->next)
+    {
+        unsigned i;
+        for (i = 0; i < r->count; ++i)
+        {
+            LIST_DATA_TYPE value = r->values[i];
+            if (filter(value))
+            {
+                list_add(nl, value);
+                continue;
+            }
+
+            if (w_count == LIST_CHUNK_CAPACITY)
+            {
+                w->count = LIST_CHUNK_CAPACITY;
+                w = w->next;
+                w_count = 0;
+            }
+            w->values[w_count++] = value;
+            ++kept;
+        }
+    }
+
+    if (kept == 0)
+        w = NULL;
+    else
+        w->count = w_count;
+
+    //Free the chunks past the last one written to.  
+    _chunk* unused = w ? w->next : l->head;
+    while (unused != NULL)
+    {
+        _chunk* next = unused->next;
+        free(unused);
+        unused = next;
+    }
+
+    if (w)
+        w->next = NULL;
+    else
+        l->head = NULL;
+    l->tail = w;
+    l->size = kept;
+    l->current = NULL;
+    l->current_index = 0;
+    _list_rebuild_jump_table(l);
+
+    return nl;
+}
+
+
+
+static inline LIST_DATA_TYPE*
+_list_ref_at(list* l, lindex index)
+{
+    lindex start, entry;
+    _chunk* c = _list_chunk_at(l, index, &start, &entry);
+    l->current = c;
+    l->current_index = start;
+    return &c->values[index - start];
+}
+
+
+static inline void
+_list_add(list* l, LIST_DATA_TYPE value)
+{
+    if (!l->tail || l->tail->count == LIST_CHUNK_CAPACITY)
+        if (!_list_new_tail_chunk(l)) return;
+
+    l->tail->values[l->tail->count++] = value;
+    ++(l->size);
+}
+
+
+static inline int
+_list_append_values(list* l, LIST_DATA_TYPE* values, lindex count)
+{
+    lindex size = l->size;
+    while (count > 0)
+    {
+        if (!l->tail || l->tail->count == LIST_CHUNK_CAPACITY)
+        {
+            if (!_list_new_tail_chunk(l))
+            {
+                _list_truncate(l, size);
+                return -1;
+            }
+        }
+
+        //Fill the tail chunk with a single copy.  
+        _chunk* c = l->tail;
+        lindex n = LIST_CHUNK_CAPACITY - c->count;
+        if (n > count)
+            n = count;
+        memcpy(&c->values[c->count], values, n * sizeof(LIST_DATA_TYPE));
+        c->count += (unsigned)n;
+        l->size += n;
+        values += n;
+        count -= n;
+    }
+    return 0;
+}
+
+
+static inline int
+_list_copy_values(list* from, list* to, lindex start, lindex end)
+{
+    if (start == end) return 0;
+
+    lindex size = to->size;
+    lindex s, entry;
+    _chunk* c = _list_chunk_at(from, start, &s, &entry);
+    lindex offset = start - s;
+    lindex left = end - start;
+    while (left > 0)
+    {
+        //Counted before appending, as 'to' may be 'from'.  
+        lindex n = c->count - offset;
+        if (n > left)
+            n = left;
+        if (_list_append_values(to, &c->values[offset], n))
+        {
+            _list_truncate(to, size);
+            return -1;
+        }
+        left -= n;
+        c = c->next;
+        offset = 0;
+    }
+    return 0;
+}
+
+
+static inline void
+_list_erase(list* l, lindex start, lindex end, int free_items)
+{
+    (void)free_items;
+    if (start == end) return;
+
+    lindex removed = end - start;
+    lindex s, entry;
+    _chunk* c = _list_chunk_at(l, start, &s, &entry);
+    lindex offset = start - s;
+    _chunk* before = offset > 0 ? c : c->prev;
+    lindex before_start = offset > 0 ? s : s - (before ? before->count : 0);
+
+    //Cut the range out of the chunks it covers.  Only the first and last
+    //of them can keep values, the others are freed.  
+    lindex left = removed;
+    while (left > 0)
+    {
+        _chunk* next = c->next;
+        lindex n = c->count - offset;
+        if (n > left)
+            n = left;
+        #if FREE_LIST_ITEMS
+            lindex i;
+            for (i = 0; free_items && i < n; ++i)
+                free(c->values[offset + i]);
+        #endif
+
+        if (n == c->count)
+        {
+            _unlink_chunk(l, c);
+            free(c);
+        }
+        else
+        {
+            memmove(&c->values[offset], &c->values[offset + n],
+                    (c->count - offset - n) * sizeof(LIST_DATA_TYPE));
+            c->count -= (unsigned)n;
+        }
+        left -= n;
+        c = next;
+        offset = 0;
+    }
+    //The chunk now starting at 'start', if the first one didn't keep the
+    //values after the range.  
+    _chunk* after = before ? before->next : l->head;
+    if (before && before_start + before->count > start)
+        after = NULL;
+    l->size -= removed;
+
+    //Entries of chunks that started in the range are dropped, one entry for
+    //the chunk now starting at 'start' takes their place and the entries
+    //after them move back, all in one pass.  
+    lindex w = entry;
+    lindex dropped = l->jt_count;
+    lindex i;
+    for (i = entry; i < l->jt_count; ++i)
+    {
+        _jt_entry e = l->jump_table[i];
+        if (e.start >= start && e.start < end)
+        {
+            if (dropped == l->jt_count)
+                dropped = w;
+            continue;
+        }
+        if (e.start >= end)
+            e.start -= removed;
+        l->jump_table[w++] = e;
+    }
+    if (dropped != l->jt_count)
+    {
+        l->jt_count = w;
+        if (after && (dropped == w || l->jump_table[dropped].chunk != after))
+            _list_insert_jt_entry(l, dropped, after, start);
+    }
+
+    if (l->current && l->current_index >= start)
+    {
+        if (l->current_index >= end)
+            l->current_index -= removed;
+        else
+        {
+            l->current = NULL;
+            l->current_index = 0;
+        }
+    }
+
+    //The chunks around the range may now fit in one.  
+    if (after)
+        _merge_with_next_chunk(l, after, start, _jt_search(l, start));
+    if (before)
+        _merge_with_next_chunk(l, before, before_start,
+                               _jt_search(l, before_start));
+}
+
+
+static inline void
+_list_retain(list* l, filter_func filter, int keep)
+{
+    //Compact the values that stay into the front of the chunks, as
+    //list_split_where() does, and index the chunks once at the end.  
+    _chunk* w = l->head;
+    unsigned w_count = 0;
+    lindex kept = 0;
+    _chunk* r;
+    for (r = l->head; r != NULL; r = r->next)
+    {
+        unsigned i;
+        for (i = 0; i < r->count; ++i)
+        {
+            LIST_DATA_TYPE value = r->values[i];
+            if (!filter(value) != !keep)
+            {
+                #if FREE_LIST_ITEMS
+                    free(value);
+                #endif
+                continue;
+            }
+
+            if (w_count == LIST_CHUNK_CAPACITY)
+            {
+                w->count = LIST_CHUNK_CAPACITY;
+                w = w->next;
+                w_count = 0;
+            }
+            w->values[w_count++] = value;
+            ++kept;
+        }
+    }
+    if (kept == 0)
+        w = NULL;
+    else
+        w->count = w_count;
+
+    //Free the chunks past the last one written to.  
+    _chunk* unused = w ? w->next : l->head;
+    while (unused != NULL)
+    {
+        _chunk* next = unused->next;
+        free(unused);
+        unused = next;
+    }
+
+    if (w)
+        w->next = NULL;
+    else
+        l->head = NULL;
+    l->tail = w;
+    l->size = kept;
+    l->current = NULL;
+    l->current_index = 0;
+    _list_rebuild_jump_table(l);
+}
+
+
+static inline void
+_list_read_values(list* l, LIST_DATA_TYPE* values)
+{
+    _chunk* c;
+    for (c = l->head; c != NULL; c = c->next)
+    {
+        memcpy(values, c->values, c->count * sizeof(LIST_DATA_TYPE));
+        values += c->count;
+    }
+}
+
+
+static inline void
+_free_list_structures(list* l)
+{
+    free(l->jump_table);
+    l->jump_table = NULL;
+    l->head = NULL;
+    l->tail = NULL;
+    free(l);
+}
+
+
+static inline _chunk*
+_new_chunk(void)
+{
+    _chunk* c = (_chunk*)malloc(sizeof(_chunk));
+    if (!c) return NULL;
+
+    c->next = NULL;
+    c->prev = NULL;
+    c->count = 0;
+    return c;
+}
+
+
+static inline _chunk*
+_list_new_tail_chunk(list* l)
+{
+    _chunk* c = _new_chunk();
+    if (ALLOC_ERROR(c)) return NULL;
+
+    //Index a new chunk every JT_INCREMENT values.  
+    lindex last = l->jt_count;
+    if (last == 0 || l->size - l->jump_table[last-1].start >= JT_INCREMENT)
+    {
+        if (_list_insert_jt_entry(l, last, c, l->size))
+        {
+            free(c);
+            return NULL;
+        }
+    }
+    _link_tail_chunk(l, c);
+    return c;
+}
+
+
+static inline void
+_link_tail_chunk(list* l, _chunk* c)
+{
+    c->next = NULL;
+    c->prev = l->tail;
+    if (l->tail)
+        l->tail->next = c;
+    else
+        l->head = c;
+    l->tail = c;
+}
+
+
+static inline void
+_unlink_chunk(list* l, _chunk* c)
+{
+    if (c->prev)
+        c->prev->next = c->next;
+    else
+        l->head = c->next;
+
+    if (c->next)
+        c->next->prev = c->prev;
+    else
+        l->tail = c->prev;
+}
+
+
+static inline _chunk*
+_split_chunk_at(list* l, _chunk* c, unsigned offset)
+{
+    _chunk* upper = _new_chunk();
+    if (!upper) return NULL;
+
+    upper->count = c->count - offset;
+    memcpy(upper->values, &c->values[offset],
+           upper->count * sizeof(LIST_DATA_TYPE));
+    c->count = offset;
+
+    upper->prev = c;
+    upper->next = c->next;
+    if (c->next)
+        c->next->prev = upper;
+    else
+        l->tail = upper;
+    c->next = upper;
+
+    return upper;
+}
+
+
+static inline void
+_remove_chunk(list* l, _chunk* c, lindex entry)
+{
+    if (l->jt_count > 0 && l->jump_table[entry].chunk == c)
+    {
+        //An empty chunk starts where its successor does.  
+        lindex start = l->jump_table[entry].start;
+        if (c->next)
+            _list_redirect_jt_entry(l, entry, c->next, start);
+        else if (c->prev)
+            _list_redirect_jt_entry(l, entry, c->prev, start - c->prev->count);
+        else
+            _list_redirect_jt_entry(l, entry, NULL, 0);
+    }
+
+    if (l->current == c)
+    {
+        l->current = NULL;
+        l->current_index = 0;
+    }
+
+    _unlink_chunk(l, c);
+    free(c);
+}
+
+
+static inline void
+_merge_with_next_chunk(list* l, _chunk* c, lindex start, lindex entry)
+{
+    _chunk* next = c->next;
+    if (c->count >= LIST_CHUNK_CAPACITY / 4 || next == NULL ||
+        c->count + next->count > LIST_CHUNK_CAPACITY)
+        return;
+
+    memcpy(&c->values[c->count], next->values,
+           next->count * sizeof(LIST_DATA_TYPE));
+    c->count += next->count;
+
+    if (entry + 1 < l->jt_count && l->jump_table[entry+1].chunk == next)
+        _list_redirect_jt_entry(l, entry + 1, c, start);
+
+    if (l->current == next)
+    {
+        l->current = c;
+        l->current_index = start;
+    }
+
+    _unlink_chunk(l, next);
+    free(next);
+}
+
+
+static inline lindex
+_jt_search(const list* l, lindex index)
+{
+    //The first entry always refers to the head chunk, at index 0.  
+    lindex lo = 0, hi = l->jt_count;
+    while (hi - lo > 1)
+    {
+        lindex mid = lo + (hi - lo) / 2;
+        if (l->jump_table[mid].start <= index)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+
+static inline _chunk*
+_list_chunk_at(const list* l, lindex index, lindex* start, lindex* entry)
+{
+    lindex e = _jt_search(l, index);
+    *entry = e;
+
+    _chunk* c = l->jump_table[e].chunk;
+    lindex s = l->jump_table[e].start;
+    lindex dist = index - s;
+
+    //Walking backward from the next entry, or the tail, may be shorter.  
+    _chunk* after = l->tail;
+    lindex after_start = l->size - l->tail->count;
+    if (e + 1 < l->jt_count)
+    {
+        after = l->jump_table[e+1].chunk;
+        after_start = l->jump_table[e+1].start;
+    }
+    lindex after_dist = after_start > index ? after_start - index
+                                            : index - after_start;
+    if (after_dist < dist)
+    {
+        c = after;
+        s = after_start;
+        dist = after_dist;
+    }
+
+    if (l->current)
+    {
+        lindex current_dist = l->current_index > index ?
+                              l->current_index - index :
+                              index - l->current_index;
+        if (current_dist < dist)
+        {
+            c = l->current;
+            s = l->current_index;
+        }
+    }
+
+    return _walk_to_chunk(c, s, index, start);
+}
+
+
+static inline _chunk*
+_walk_to_chunk(_chunk* c, lindex s, lindex index, lindex* start)
+{
+    while (index < s)
+    {
+        c = c->prev;
+        s -= c->count;
+    }
+    while (index >= s + c->count)
+    {
+        s += c->count;
+        c = c->next;
+    }
+
+    *start = s;
+    return c;
+}
+
+
+static inline int
+_list_grow_jump_table(list* l, lindex new_size)
+{
+    _jt_entry* new_table =\
+    (_jt_entry*)realloc(l->jump_table, new_size * sizeof(_jt_entry));
+
+    if (ALLOC_ERROR(new_table)) return -1;
+
+    l->jump_table = new_table;
+    l->jt_size = new_size;
+    return 0;
+}
+
+
+static inline int
+_list_insert_jt_entry(list* l, lindex pos, _chunk* c, lindex start)
+{
+    if (l->jt_count == l->jt_size)
+        if (_list_grow_jump_table(l, l->jt_size * 2)) return -1;
+
+    memmove(&l->jump_table[pos+1], &l->jump_table[pos],
+            (l->jt_count - pos) * sizeof(_jt_entry));
+    l->jump_table[pos].chunk = c;
+    l->jump_table[pos].start = start;
+    ++(l->jt_count);
+    return 0;
+}
+
+
+static inline void
+_list_redirect_jt_entry(list* l, lindex pos, _chunk* c, lindex start)
+{
+    int duplicate = c == NULL ||
+                    (pos > 0 && l->jump_table[pos-1].chunk == c) ||
+                    (pos + 1 < l->jt_count && l->jump_table[pos+1].chunk == c);
+
+    if (duplicate)
+    {
+        memmove(&l->jump_table[pos], &l->jump_table[pos+1],
+                (l->jt_count - pos - 1) * sizeof(_jt_entry));
+        --(l->jt_count);
+    }
+    else
+    {
+        l->jump_table[pos].chunk = c;
+        l->jump_table[pos].start = start;
+    }
+}
+
+
+static inline void
+_list_shift_jump_table(list* l, lindex pos, int delta)
+{
+    for (; pos < l->jt_count; ++pos)
+        l->jump_table[pos].start += delta;
+}
+
+
+static inline void
+_list_balance_jump_table(list* l, lindex pos)
+{
+    lindex start = l->jump_table[pos].start;
+    lindex next_start = pos + 1 < l->jt_count ? l->jump_table[pos+1].start
+                                              : l->size;
+    if (next_start - start <= 2 * JT_INCREMENT) return;
+
+    _chunk* c = l->jump_table[pos].chunk;
+    lindex s = start;
+    while (s < start + JT_INCREMENT)
+    {
+        s += c->count;
+        c = c->next;
+    }
+
+    //A sparser table is still correct, so allocation failure is ignored.  
+    if (l->jt_count == l->jt_size)
+    {
+        _jt_entry* new_table = (_jt_entry*)realloc(l->jump_table,
+                                   l->jt_size * 2 * sizeof(_jt_entry));
+        if (!new_table) return;
+        l->jump_table = new_table;
+        l->jt_size *= 2;
+    }
+    _list_insert_jt_entry(l, pos + 1, c, s);
+}
+
+
+static inline void
+_list_rebuild_jump_table(list* l)
+{
+    l->jt_count = 0;
+
+    lindex needed = l->size / JT_INCREMENT + 1;
+    if (needed > l->jt_size)
+    {
+        _jt_entry* new_table = (_jt_entry*)realloc(l->jump_table,
+                                                   needed * sizeof(_jt_entry));
+        if (ALLOC_ERROR(new_table)) return;
+        l->jump_table = new_table;
+        l->jt_size = needed;
+    }
+
+    lindex start = 0;
+    _chunk* c;
+    for (c = l->head; c != NULL; c = c->next)
+    {
+        if (l->jt_count == 0 ||
+            start - l->jump_table[l->jt_count-1].start >= JT_INCREMENT)
+        {
+            l->jump_table[l->jt_count].chunk = c;
+            l->jump_table[l->jt_count].start = start;
+            ++(l->jt_count);
+        }
+        start += c->count;
+    }
+}
+
+
+#endif
@@ -0,0 +1,79 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_btree_free_test.c
+// Verifies LIST_STORAGE_BTREE with FREE_LIST_ITEMS.  Built once more by the
+// btree_test target with CLONE_FREED_VALUES, which must fail to compile since
+// list_clone_cow() is not available when the lists free their values.  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdbool.h>
+#include <string.h>
+#include "../../acutest/include/acutest.h"
+
+#define LIST_DATA_TYPE char*
+#define ERROR_RETURN_VALUE NULL
+#define FREE_LIST_ITEMS 1
+#define LIST_STORAGE LIST_STORAGE_BTREE
+
+#include "../include/clist.h"
+
+
+bool ERROR_STATUS = false;
+
+bool not_in_error = false;
+bool in_error = true;
+
+void check_error_status(bool should_be_error)
+{
+    bool current = ERROR_STATUS;
+    ERROR_STATUS = false;
+    TEST_CHECK(current == should_be_error);
+}
+
+int error_handler(const char* func, const char* arg, const char* msg)
+{
+    ERROR_STATUS = true;
+    return 0;
+}
+
+
+int starts_with_a(char* s)
+{
+    return s[0] == 'a';
+}
+
+
+void test_values_are_freed(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    int i = 0;
+    for (; i < 1000; ++i)
+        list_add(l, strdup(i % 3 ? "b" : "a"));
+
+    //Every value removed here is freed exactly once, which ASan checks.  
+    list_remove_range(l, 100, 400);
+    list_retain(l, starts_with_a);
+    TEST_CHECK(list_size(l) == 234);
+    list* moved = new_list();
+    list_add_range(l, moved, 0, 100);
+    TEST_CHECK(list_size(moved) == 100);
+    TEST_CHECK(strcmp(list_get(moved, 99), "a") == 0);
+
+#ifdef CLONE_FREED_VALUES
+    list* clone = list_clone_cow(l);
+    free_list(clone);
+#endif
+
+    check_error_status(not_in_error);
+    free_list(moved);
+    free_list(l);
+}
+
+
+TEST_LIST = {
+    {"Removed values are freed once", test_values_are_freed},
+    {NULL, NULL}
+};
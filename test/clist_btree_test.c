@@ -0,0 +1,613 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_btree_test.c
+// Verifies correct behavior of clist.h with LIST_STORAGE_BTREE.  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdbool.h>
+#include "../../acutest/include/acutest.h"
+
+#define LIST_DATA_TYPE long
+#define ERROR_RETURN_VALUE -1
+#define LIST_STORAGE LIST_STORAGE_BTREE
+
+#include "../include/clist.h"
+
+
+bool ERROR_STATUS = false;
+
+bool not_in_error = false;
+bool in_error = true;
+
+void check_error_status(bool should_be_error)
+{
+    bool current = ERROR_STATUS;
+    ERROR_STATUS = false;
+    TEST_CHECK(current == should_be_error);
+}
+
+int error_handler(const char* func, const char* arg, const char* msg)
+{
+    ERROR_STATUS = true;
+    return 0;
+}
+
+/*
+Checks the subtree 'n' of height 'h', whose first value is at 'start', and
+returns the number of values below it.  Compares the values against
+'expected' if it is not NULL.  
+*/
+lindex check_subtree(_bnode* n, unsigned h, lindex start, const long* expected)
+{
+    TEST_CHECK(n->refs > 0);
+    if (h == 0)
+    {
+        TEST_CHECK(n->count <= LIST_BTREE_LEAF_CAPACITY);
+        unsigned i;
+        for (i = 0; expected && i < n->count; ++i)
+            TEST_CHECK(_LEAF(n)->values[i] == expected[start + i]);
+        return n->count;
+    }
+
+    TEST_CHECK(n->count > 0 && n->count <= LIST_BTREE_FANOUT);
+    lindex size = 0;
+    unsigned i;
+    for (i = 0; i < n->count; ++i)
+    {
+        lindex child = check_subtree(_INNER(n)->children[i], h - 1,
+                                     start + size, expected);
+        TEST_CHECK(child == _INNER(n)->sizes[i]);
+        size += child;
+    }
+    return size;
+}
+
+/*
+Checks the counts of every node of 'l' against each other and, if 'expected'
+is not NULL, the list's values against 'expected'.  
+*/
+void check_structure(list* l, const long* expected)
+{
+    if (l->size == 0)
+    {
+        TEST_CHECK(l->root == NULL);
+        return;
+    }
+
+    TEST_ASSERT(l->root != NULL);
+    //A root with a single child would have been replaced by it.  
+    TEST_CHECK(l->height == 0 || l->root->count > 1);
+    TEST_CHECK(check_subtree(l->root, l->height, 0, expected) == l->size);
+}
+
+/*
+Returns the number of nodes below and including 'n', of height 'h', that
+are not shared with other lists.  
+*/
+lindex count_own_nodes(_bnode* n, unsigned h)
+{
+    if (n->refs > 1) return 0;
+
+    lindex count = 1;
+    unsigned i;
+    for (i = 0; h > 0 && i < n->count; ++i)
+        count += count_own_nodes(_INNER(n)->children[i], h - 1);
+    return count;
+}
+
+
+int filter1to10(long x)
+{
+    return x > 0 && x <= 10;
+}
+
+int is_even(long x)
+{
+    return x % 2 == 0;
+}
+
+
+void test_new_list_intial_values(void)
+{
+    list* l = new_list();
+    TEST_ASSERT(l != NULL);
+    TEST_CHECK(list_size(l) == 0);
+    TEST_CHECK(l->root == NULL);
+    TEST_CHECK(l->height == 0);
+    free_list(l);
+}
+
+
+void test_api_null_checks(void)
+{
+    list_error_handler(error_handler);
+
+    TEST_CHECK(list_size(NULL) == (lindex)-1);
+    check_error_status(in_error);
+    list_add(NULL, 1);
+    check_error_status(in_error);
+    TEST_CHECK(list_pop(NULL) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_get(NULL, 0) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_get_const(NULL, 0) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_clone_cow(NULL) == NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_get_ref(NULL, 0) == NULL);
+    check_error_status(in_error);
+    list_set(NULL, 0, 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_emplace_back(NULL) == NULL);
+    check_error_status(in_error);
+    list_insert(NULL, 0, 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_remove(NULL, 0) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+    sort_list(NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_lower_bound(NULL, 0) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_upper_bound(NULL, 0) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_contains_sorted(NULL, 0) == 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_insert_sorted(NULL, 0) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_where(NULL, NULL) == NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_split(NULL, 0) == NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_split_where(NULL, NULL) == NULL);
+    check_error_status(in_error);
+}
+
+
+void test_add_get_pop(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+
+    long i = 0;
+    for (; i < 10000; ++i)
+        list_add(l, i);
+    TEST_CHECK(list_size(l) == 10000);
+    //Appends fill leaves completely.  
+    TEST_CHECK(l->height == 2);
+    TEST_CHECK(_INNER(l->root)->sizes[0] ==
+               LIST_BTREE_LEAF_CAPACITY * LIST_BTREE_FANOUT);
+    for (i = 0; i < 10000; ++i)
+        TEST_CHECK(list_get(l, i) == i);
+    for (i = 9999; i >= 0; i -= 7)
+        TEST_CHECK(list_get(l, i) == i);
+    check_structure(l, NULL);
+
+    TEST_CHECK(list_get(l, 10000) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+
+    for (i = 9999; i >= 0; --i)
+        TEST_CHECK(list_pop(l) == i);
+    TEST_CHECK(list_size(l) == 0);
+    TEST_CHECK(l->root == NULL);
+    TEST_CHECK(list_pop(l) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+
+    free_list(l);
+}
+
+
+void test_random_insert_remove(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long* expected = (long*)malloc(40000 * sizeof(long));
+    lindex n = 0;
+
+    int i = 0;
+    for (; i < 30000; ++i)
+    {
+        long value = rand();
+        lindex index = n ? rand() % n : 0;
+        if (n > 0 && rand() % 3 == 0)
+        {
+            TEST_CHECK(list_remove(l, index) == expected[index]);
+            memmove(&expected[index], &expected[index+1],
+                    (n - index - 1) * sizeof(long));
+            --n;
+        }
+        else
+        {
+            list_insert(l, index, value);
+            memmove(&expected[index+1], &expected[index],
+                    (n - index) * sizeof(long));
+            expected[index] = value;
+            ++n;
+        }
+
+        if (i % 1000 == 0)
+            check_structure(l, expected);
+    }
+
+    TEST_CHECK(list_size(l) == n);
+    check_structure(l, expected);
+    lindex j = 0;
+    for (; j < n; ++j)
+    {
+        TEST_CHECK(list_get(l, j) == expected[j]);
+        TEST_CHECK(list_get_const(l, n - 1 - j) == expected[n - 1 - j]);
+    }
+
+    //Update every value in place, then fill a new slot.  
+    for (j = 0; j < n; ++j)
+        *list_get_ref(l, j) += 1;
+    list_set(l, 0, -5);
+    long* slot = list_emplace_back(l);
+    TEST_ASSERT(slot != NULL);
+    TEST_CHECK(*slot == 0);
+    *slot = 7;
+    TEST_CHECK(list_get(l, n) == 7);
+    TEST_CHECK(list_get(l, 0) == -5);
+    for (j = 1; j < n; ++j)
+        TEST_CHECK(list_get_const(l, j) == expected[j] + 1);
+    TEST_CHECK(list_get_unchecked(l, n) == 7);
+    list_set_unchecked(l, n, 8);
+    list_add_unchecked(l, 9);
+    long value = 0;
+    TEST_CHECK(list_try_get(l, n, &value) == LIST_OK && value == 8);
+    TEST_CHECK(list_try_get(l, n + 1, &value) == LIST_OK && value == 9);
+    TEST_CHECK(list_try_get(l, n + 2, &value) == LIST_INDEX_OUT_OF_RANGE);
+    check_error_status(not_in_error);
+    TEST_CHECK(list_get_ref(l, n + 2) == NULL);
+    check_error_status(in_error);
+    list_set(l, n + 2, 0);
+    check_error_status(in_error);
+
+    check_error_status(not_in_error);
+    free(expected);
+    free_list(l);
+}
+
+
+void test_front_inserts_and_removes(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+
+    long i = 20000;
+    for (; i >= 0; --i)
+        list_insert(l, 0, i);
+    for (i = 0; i <= 20000; ++i)
+        TEST_CHECK(list_get(l, i) == i);
+    check_structure(l, NULL);
+
+    for (i = 0; i < 20000; ++i)
+        TEST_CHECK(list_remove(l, 0) == i);
+    TEST_CHECK(list_size(l) == 1);
+    //Removes merge nodes back together.  
+    TEST_CHECK(l->height == 0);
+    check_structure(l, NULL);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+
+void test_sort(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 100000; ++i)
+        list_add(l, rand() % 1000);
+
+    sort_list(l);
+    check_structure(l, NULL);
+    long prev = list_get(l, 0);
+    for (i = 1; i < 100000; ++i)
+    {
+        long value = list_get(l, i);
+        TEST_CHECK(prev <= value);
+        prev = value;
+    }
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+
+void test_sorted_search_and_insert(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    TEST_CHECK(list_lower_bound(l, 1) == 0);
+
+    long i = 0;
+    for (; i < 20000; ++i)
+    {
+        long value = rand() % 3000 * 2;
+        lindex index = list_insert_sorted(l, value);
+        TEST_CHECK(list_get(l, index) == value);
+        TEST_CHECK(index + 1 == list_size(l) || list_get(l, index + 1) > value);
+    }
+    check_structure(l, NULL);
+
+    for (i = -1; i < 6001; ++i)
+    {
+        lindex lower = list_lower_bound(l, i);
+        lindex upper = list_upper_bound(l, i);
+        TEST_CHECK(lower == 0 || list_get(l, lower - 1) < i);
+        TEST_CHECK(lower == list_size(l) || list_get(l, lower) >= i);
+        TEST_CHECK(upper == list_size(l) || list_get(l, upper) > i);
+        TEST_CHECK(list_contains_sorted(l, i) == (upper > lower));
+        if (i % 2)
+            TEST_CHECK(upper == lower);
+    }
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+
+void test_where_and_split_where(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 10001; ++i)
+        list_add(l, i);
+
+    list* small = list_where(l, filter1to10);
+    TEST_CHECK(list_size(small) == 10);
+    for (i = 0; i < 10; ++i)
+        TEST_CHECK(list_get(small, i) == i + 1);
+    free_list(small);
+
+    list* evens = list_split_where(l, is_even);
+    TEST_CHECK(list_size(evens) == 5001);
+    TEST_CHECK(list_size(l) == 5000);
+    check_structure(l, NULL);
+    check_structure(evens, NULL);
+    for (i = 0; i < 5000; ++i)
+    {
+        TEST_CHECK(list_get(evens, i) == 2 * i);
+        TEST_CHECK(list_get(l, i) == 2 * i + 1);
+    }
+
+    list* none = list_split_where(evens, is_even);
+    TEST_CHECK(list_size(evens) == 0);
+    TEST_CHECK(evens->root == NULL);
+    TEST_CHECK(list_size(none) == 5001);
+
+    check_error_status(not_in_error);
+    free_list(none);
+    free_list(evens);
+    free_list(l);
+}
+
+
+void test_split_and_merge(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 10000; ++i)
+        list_add(l, i);
+
+    //Split in the middle of a leaf.  
+    list* second = list_split(l, 5005);
+    TEST_CHECK(list_size(l) == 5005);
+    TEST_CHECK(list_size(second) == 4995);
+    check_structure(l, NULL);
+    check_structure(second, NULL);
+    for (i = 0; i < 4995; ++i)
+        TEST_CHECK(list_get(second, i) == i + 5005);
+
+    list* third = list_split(second, 1);
+    TEST_CHECK(list_size(second) == 1);
+    TEST_CHECK(list_get(third, 0) == 5006);
+
+    list_merge(second, third);
+    list_merge(l, second);
+    TEST_CHECK(list_size(l) == 10000);
+    check_structure(l, NULL);
+    for (i = 0; i < 10000; ++i)
+        TEST_CHECK(list_get(l, i) == i);
+
+    list* empty = list_split(l, 0);
+    TEST_CHECK(list_size(empty) == 0);
+    TEST_CHECK(list_split(l, 10000) == NULL);
+    check_error_status(in_error);
+
+    list_merge(empty, l);
+    TEST_CHECK(list_size(empty) == 10000);
+    check_structure(empty, NULL);
+
+    free_list(empty);
+}
+
+
+void test_random_split_merge(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long* expected = (long*)malloc(100000 * sizeof(long));
+    lindex n = 0;
+    for (; n < 100000; ++n)
+    {
+        expected[n] = (long)n;
+        list_add(l, (long)n);
+    }
+
+    //Cut the list in two and glue it back, which covers joining trees of
+    //every combination of heights.  
+    int i = 0;
+    for (; i < 200; ++i)
+    {
+        lindex index = rand() % n;
+        list* second = list_split(l, index);
+        TEST_ASSERT(second != NULL);
+        TEST_CHECK(list_size(l) == index);
+        TEST_CHECK(list_size(second) == n - index);
+        check_structure(l, expected);
+        check_structure(second, &expected[index]);
+
+        if (i % 2)
+            list_merge(l, second);
+        else
+        {
+            //Rotate the values instead.  
+            list_merge(second, l);
+            l = second;
+            long* rotated = (long*)malloc(n * sizeof(long));
+            memcpy(rotated, &expected[index], (n - index) * sizeof(long));
+            memcpy(&rotated[n - index], expected, index * sizeof(long));
+            free(expected);
+            expected = rotated;
+        }
+        TEST_CHECK(list_size(l) == n);
+        check_structure(l, expected);
+    }
+
+    //Splitting off single values leaves small trees to join.  
+    list* tail = list_split(l, n - 1);
+    list* head = list_split(l, 0);
+    list_merge(head, l);
+    l = head;
+    list_merge(tail, l);
+    TEST_CHECK(list_get(tail, 0) == expected[n-1]);
+    TEST_CHECK(list_get(tail, 1) == expected[0]);
+    check_structure(tail, NULL);
+
+    check_error_status(not_in_error);
+    free(expected);
+    free_list(tail);
+}
+
+
+void test_clone_cow(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    const lindex size = 20000;
+    long* expected = (long*)malloc(2 * size * sizeof(long));
+    long* original = (long*)malloc(size * sizeof(long));
+    lindex n = 0;
+    for (; n < size; ++n)
+    {
+        original[n] = expected[n] = (long)n;
+        list_add(l, (long)n);
+    }
+
+    //Cloning shares the whole tree, a change copies only its path.  
+    list* snapshot = list_clone_cow(l);
+    TEST_ASSERT(snapshot != NULL);
+    TEST_CHECK(snapshot->root == l->root);
+    TEST_CHECK(count_own_nodes(l->root, l->height) == 0);
+    list_set(l, 0, -1);
+    expected[0] = -1;
+    TEST_CHECK(count_own_nodes(l->root, l->height) == l->height + 1);
+    TEST_CHECK(list_get(snapshot, 0) == 0);
+    check_structure(l, expected);
+    check_structure(snapshot, original);
+
+    //Changes to either side are not seen by the other.  
+    list* middle = NULL;
+    long* middle_expected = (long*)malloc(2 * size * sizeof(long));
+    lindex middle_size = 0;
+    int i = 0;
+    for (; i < 20000; ++i)
+    {
+        lindex index = rand() % n;
+        int op = rand() % 4;
+        if (op == 0)
+        {
+            TEST_CHECK(list_remove(l, index) == expected[index]);
+            memmove(&expected[index], &expected[index+1],
+                    (n - index - 1) * sizeof(long));
+            --n;
+        }
+        else if (op == 1)
+        {
+            list_insert(l, index, i);
+            memmove(&expected[index+1], &expected[index],
+                    (n - index) * sizeof(long));
+            expected[index] = i;
+            ++n;
+        }
+        else
+        {
+            *list_get_ref(l, index) = i;
+            expected[index] = i;
+        }
+
+        if (i == 10000)
+        {
+            middle = list_clone_cow(l);
+            memcpy(middle_expected, expected, n * sizeof(long));
+            middle_size = n;
+            list_add(middle, -7);
+            middle_expected[middle_size++] = -7;
+            list_remove(middle, 0);
+            memmove(middle_expected, &middle_expected[1],
+                    --middle_size * sizeof(long));
+        }
+        if (i % 2000 == 0)
+            check_structure(l, expected);
+    }
+
+    TEST_CHECK(list_size(l) == n);
+    check_structure(l, expected);
+    check_structure(snapshot, original);
+    TEST_CHECK(list_size(middle) == middle_size);
+    check_structure(middle, middle_expected);
+
+    //Sorting, splitting and merging a clone leave the source alone.  
+    list* sorted = list_clone_cow(l);
+    sort_list(sorted);
+    list* tail = list_split(sorted, n / 2);
+    list_merge(tail, sorted);
+    TEST_CHECK(list_size(tail) == n);
+    check_structure(tail, NULL);
+    check_structure(l, expected);
+
+    //Merging two lists that share nodes.  
+    list* twice = list_clone_cow(snapshot);
+    list_merge(twice, list_clone_cow(snapshot));
+    TEST_CHECK(list_size(twice) == 2 * size);
+    TEST_CHECK(list_get(twice, size) == 0);
+    TEST_CHECK(list_get(twice, 2 * size - 1) == (long)size - 1);
+    list_insert(twice, size, -3);
+    TEST_CHECK(list_get(twice, size) == -3);
+    check_structure(twice, NULL);
+    check_structure(snapshot, original);
+
+    free_list(l);
+    check_structure(snapshot, original);
+    check_structure(middle, middle_expected);
+    check_error_status(not_in_error);
+    free_list(snapshot);
+    free_list(middle);
+    free_list(tail);
+    free_list(twice);
+    free(expected);
+    free(original);
+    free(middle_expected);
+}
+
+
+TEST_LIST = {
+    {"New list has correct intial values", test_new_list_intial_values},
+    {"API functions have null list checks", test_api_null_checks},
+    {"Add, get and pop", test_add_get_pop},
+    {"Random inserts and removes", test_random_insert_remove},
+    {"Front inserts and removes", test_front_inserts_and_removes},
+    {"Sorting", test_sort},
+    {"Sorted search and insert", test_sorted_search_and_insert},
+    {"Where and split where", test_where_and_split_where},
+    {"Split and merge", test_split_and_merge},
+    {"Random splits and merges", test_random_split_merge},
+    {"Copy-on-write clones", test_clone_cow},
+    {NULL, NULL}
+};
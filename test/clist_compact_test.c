@@ -0,0 +1,667 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_compact_test.c
+// Verifies correct behavior of clist.h with LIST_STORAGE_COMPACT.  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdbool.h>
+#include "../../acutest/include/acutest.h"
+
+#define LIST_DATA_TYPE long
+#define ERROR_RETURN_VALUE -1
+#define LIST_STORAGE LIST_STORAGE_COMPACT
+#define LIST_COMPACT_MMAP 1
+
+#include "../include/clist.h"
+
+
+bool ERROR_STATUS = false;
+
+bool not_in_error = false;
+bool in_error = true;
+
+void check_error_status(bool should_be_error)
+{
+    bool current = ERROR_STATUS;
+    ERROR_STATUS = false;
+    TEST_CHECK(current == should_be_error);
+}
+
+int error_handler(const char* func, const char* arg, const char* msg)
+{
+    ERROR_STATUS = true;
+    return 0;
+}
+
+/*
+Checks the links, jump_table and free nodes of 'l' against each other and,
+if 'expected' is not NULL, the list's values against 'expected'.  
+*/
+void check_structure(list* l, const long* expected)
+{
+    lindex index = 0;
+    _cindex prev = CLIST_NIL;
+    _cindex n = l->head;
+    for (; n != CLIST_NIL; prev = n, n = l->nodes[n].next, ++index)
+    {
+        TEST_ASSERT(n < l->used);
+        TEST_ASSERT(l->nodes[n].prev == prev);
+        if (index % JT_INCREMENT == 0)
+            TEST_ASSERT(l->jump_table[index / JT_INCREMENT] == n);
+        if (n == l->current)
+            TEST_ASSERT(l->current_index == index);
+        if (expected)
+            TEST_ASSERT(l->nodes[n].value == expected[index]);
+    }
+
+    TEST_CHECK(l->tail == prev);
+    TEST_CHECK(index == l->size);
+    lindex i = (l->size + JT_INCREMENT - 1) / JT_INCREMENT;
+    for (; i < l->jt_size; ++i)
+        TEST_CHECK(l->jump_table[i] == CLIST_NIL);
+
+    //Every node handed out is either linked or free.  
+    lindex n_free = 0;
+    for (n = l->free_nodes; n != CLIST_NIL; n = l->nodes[n].next)
+        ++n_free;
+    TEST_CHECK(n_free + l->size == l->used);
+}
+
+
+int filter1to10(long x)
+{
+    return x > 0 && x <= 10;
+}
+
+int is_even(long x)
+{
+    return x % 2 == 0;
+}
+
+
+void test_new_list_intial_values(void)
+{
+    list* l = new_list();
+    TEST_ASSERT(l != NULL);
+    TEST_CHECK(list_size(l) == 0);
+    TEST_CHECK(l->head == CLIST_NIL);
+    TEST_CHECK(l->tail == CLIST_NIL);
+    TEST_CHECK(l->current == CLIST_NIL);
+    TEST_CHECK(l->jt_size == INITIAL_JT_SIZE);
+    TEST_CHECK(l->jump_table[0] == CLIST_NIL);
+    TEST_CHECK(l->used == 0);
+    free_list(l);
+}
+
+
+void test_api_null_checks(void)
+{
+    list_error_handler(error_handler);
+
+    TEST_CHECK(list_size(NULL) == (lindex)-1);
+    check_error_status(in_error);
+    list_add(NULL, 1);
+    check_error_status(in_error);
+    TEST_CHECK(list_pop(NULL) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_get(NULL, 0) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_get_const(NULL, 0) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_get_ref(NULL, 0) == NULL);
+    check_error_status(in_error);
+    list_set(NULL, 0, 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_emplace_back(NULL) == NULL);
+    check_error_status(in_error);
+    list_insert(NULL, 0, 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_remove(NULL, 0) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+    sort_list(NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_lower_bound(NULL, 0) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_upper_bound(NULL, 0) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_contains_sorted(NULL, 0) == 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_insert_sorted(NULL, 0) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_where(NULL, NULL) == NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_split(NULL, 0) == NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_split_where(NULL, NULL) == NULL);
+    check_error_status(in_error);
+}
+
+
+void test_add_get_pop(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+
+    long i = 0;
+    for (; i < 10000; ++i)
+        list_add(l, i);
+    TEST_CHECK(list_size(l) == 10000);
+    //Nodes are smaller than a value and two pointers.  
+    TEST_CHECK(sizeof(_cnode) < sizeof(long) + 2 * sizeof(void*));
+    TEST_CHECK(l->used == 10000);
+    for (i = 0; i < 10000; ++i)
+        TEST_CHECK(list_get(l, i) == i);
+    for (i = 9999; i >= 0; i -= 7)
+        TEST_CHECK(list_get(l, i) == i);
+    check_structure(l, NULL);
+
+    TEST_CHECK(list_get(l, 10000) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+
+    for (i = 9999; i >= 0; --i)
+        TEST_CHECK(list_pop(l) == i);
+    TEST_CHECK(list_size(l) == 0);
+    TEST_CHECK(l->head == CLIST_NIL);
+    TEST_CHECK(l->jump_table[0] == CLIST_NIL);
+    //Popped nodes are reused.  
+    list_add(l, 1);
+    TEST_CHECK(l->used == 10000);
+    TEST_CHECK(list_pop(l) == 1);
+    TEST_CHECK(list_pop(l) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+
+    free_list(l);
+}
+
+
+void test_random_insert_remove(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long* expected = (long*)malloc(40000 * sizeof(long));
+    lindex n = 0;
+
+    int i = 0;
+    for (; i < 30000; ++i)
+    {
+        long value = rand();
+        lindex index = n ? rand() % n : 0;
+        if (n > 0 && rand() % 3 == 0)
+        {
+            TEST_CHECK(list_remove(l, index) == expected[index]);
+            memmove(&expected[index], &expected[index+1],
+                    (n - index - 1) * sizeof(long));
+            --n;
+        }
+        else
+        {
+            list_insert(l, index, value);
+            memmove(&expected[index+1], &expected[index],
+                    (n - index) * sizeof(long));
+            expected[index] = value;
+            ++n;
+        }
+
+        if (i % 1000 == 0)
+            check_structure(l, expected);
+    }
+
+    TEST_CHECK(list_size(l) == n);
+    check_structure(l, expected);
+    lindex j = 0;
+    for (; j < n; ++j)
+    {
+        TEST_CHECK(list_get(l, j) == expected[j]);
+        TEST_CHECK(list_get_const(l, n - 1 - j) == expected[n - 1 - j]);
+    }
+
+    //Update every value in place, then fill a new slot.  
+    for (j = 0; j < n; ++j)
+        *list_get_ref(l, j) += 1;
+    list_set(l, 0, -5);
+    long* slot = list_emplace_back(l);
+    TEST_ASSERT(slot != NULL);
+    TEST_CHECK(*slot == 0);
+    *slot = 7;
+    TEST_CHECK(list_get(l, n) == 7);
+    TEST_CHECK(list_get(l, 0) == -5);
+    for (j = 1; j < n; ++j)
+        TEST_CHECK(list_get_const(l, j) == expected[j] + 1);
+    TEST_CHECK(list_get_unchecked(l, n) == 7);
+    list_set_unchecked(l, n, 8);
+    list_add_unchecked(l, 9);
+    long value = 0;
+    TEST_CHECK(list_try_get(l, n, &value) == LIST_OK && value == 8);
+    TEST_CHECK(list_try_get(l, n + 1, &value) == LIST_OK && value == 9);
+    TEST_CHECK(list_try_get(l, n + 2, &value) == LIST_INDEX_OUT_OF_RANGE);
+    check_error_status(not_in_error);
+    TEST_CHECK(list_get_ref(l, n + 2) == NULL);
+    check_error_status(in_error);
+    list_set(l, n + 2, 0);
+    check_error_status(in_error);
+
+    check_error_status(not_in_error);
+    free(expected);
+    free_list(l);
+}
+
+
+void test_front_inserts_and_removes(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+
+    long i = 20000;
+    for (; i >= 0; --i)
+        list_insert(l, 0, i);
+    for (i = 0; i <= 20000; ++i)
+        TEST_CHECK(list_get(l, i) == i);
+    check_structure(l, NULL);
+
+    for (i = 0; i < 20000; ++i)
+        TEST_CHECK(list_remove(l, 0) == i);
+    TEST_CHECK(list_size(l) == 1);
+    check_structure(l, NULL);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+
+void test_sort(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 100000; ++i)
+        list_add(l, rand() % 1000);
+
+    sort_list(l);
+    check_structure(l, NULL);
+    long prev = list_get(l, 0);
+    for (i = 1; i < 100000; ++i)
+    {
+        long value = list_get(l, i);
+        TEST_CHECK(prev <= value);
+        prev = value;
+    }
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+
+void test_where_and_split_where(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 10001; ++i)
+        list_add(l, i);
+
+    list* small = list_where(l, filter1to10);
+    TEST_CHECK(list_size(small) == 10);
+    for (i = 0; i < 10; ++i)
+        TEST_CHECK(list_get(small, i) == i + 1);
+    free_list(small);
+
+    list* evens = list_split_where(l, is_even);
+    TEST_CHECK(list_size(evens) == 5001);
+    TEST_CHECK(list_size(l) == 5000);
+    check_structure(l, NULL);
+    check_structure(evens, NULL);
+    for (i = 0; i < 5000; ++i)
+    {
+        TEST_CHECK(list_get(evens, i) == 2 * i);
+        TEST_CHECK(list_get(l, i) == 2 * i + 1);
+    }
+
+    list* none = list_split_where(evens, is_even);
+    TEST_CHECK(list_size(evens) == 0);
+    TEST_CHECK(evens->head == CLIST_NIL);
+    TEST_CHECK(list_size(none) == 5001);
+
+    check_error_status(not_in_error);
+    free_list(none);
+    free_list(evens);
+    free_list(l);
+}
+
+
+void test_split_and_merge(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 10000; ++i)
+        list_add(l, i);
+
+    list* second = list_split(l, 5005);
+    TEST_CHECK(list_size(l) == 5005);
+    TEST_CHECK(list_size(second) == 4995);
+    check_structure(l, NULL);
+    check_structure(second, NULL);
+    for (i = 0; i < 4995; ++i)
+        TEST_CHECK(list_get(second, i) == i + 5005);
+
+    list* third = list_split(second, 1);
+    TEST_CHECK(list_size(second) == 1);
+    TEST_CHECK(list_get(third, 0) == 5006);
+
+    list_merge(second, third);
+    list_merge(l, second);
+    TEST_CHECK(list_size(l) == 10000);
+    check_structure(l, NULL);
+    for (i = 0; i < 10000; ++i)
+        TEST_CHECK(list_get(l, i) == i);
+
+    list* empty = list_split(l, 0);
+    TEST_CHECK(list_size(empty) == 0);
+    TEST_CHECK(list_split(l, 10000) == NULL);
+    check_error_status(in_error);
+
+    list_merge(empty, l);
+    TEST_CHECK(list_size(empty) == 10000);
+    check_structure(empty, NULL);
+
+    free_list(empty);
+}
+
+
+void test_random_split_merge(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long* expected = (long*)malloc(100000 * sizeof(long));
+    lindex n = 0;
+    for (; n < 100000; ++n)
+    {
+        expected[n] = (long)n;
+        list_add(l, (long)n);
+    }
+
+    //Cut the list in two and glue it back.  
+    int i = 0;
+    for (; i < 200; ++i)
+    {
+        lindex index = rand() % n;
+        list* second = list_split(l, index);
+        TEST_ASSERT(second != NULL);
+        TEST_CHECK(list_size(l) == index);
+        TEST_CHECK(list_size(second) == n - index);
+        check_structure(l, expected);
+        check_structure(second, &expected[index]);
+
+        if (i % 2)
+            list_merge(l, second);
+        else
+        {
+            //Rotate the values instead.  
+            list_merge(second, l);
+            l = second;
+            long* rotated = (long*)malloc(n * sizeof(long));
+            memcpy(rotated, &expected[index], (n - index) * sizeof(long));
+            memcpy(&rotated[n - index], expected, index * sizeof(long));
+            free(expected);
+            expected = rotated;
+        }
+        TEST_CHECK(list_size(l) == n);
+        check_structure(l, expected);
+    }
+
+    //Splitting off single values.  
+    list* tail = list_split(l, n - 1);
+    list* head = list_split(l, 0);
+    list_merge(head, l);
+    l = head;
+    list_merge(tail, l);
+    TEST_CHECK(list_get(tail, 0) == expected[n-1]);
+    TEST_CHECK(list_get(tail, 1) == expected[0]);
+    check_structure(tail, NULL);
+
+    check_error_status(not_in_error);
+    free(expected);
+    free_list(tail);
+}
+
+
+void test_relocation(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long expected[5001];
+    long i = 0;
+    for (; i < 5000; ++i)
+        list_add(l, i);
+    TEST_CHECK(list_remove(l, 0) == 0);
+    list_insert(l, 2500, 0);
+    list_get(l, 4000);
+
+    //The arena holds no pointers, so a plain copy of it is a valid list.  
+    _cnode* moved = (_cnode*)malloc(l->capacity * sizeof(_cnode));
+    memcpy(moved, l->nodes, l->used * sizeof(_cnode));
+    free(l->nodes);
+    l->nodes = moved;
+
+    for (i = 0; i < 5000; ++i)
+        expected[i] = i < 2500 ? i + 1 : (i == 2500 ? 0 : i);
+    expected[5000] = 5000;
+    list_add(l, 5000);
+    check_structure(l, expected);
+    for (i = 0; i <= 5000; ++i)
+        TEST_CHECK(list_get(l, i) == expected[i]);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+
+void test_mapped_file(void)
+{
+    list_error_handler(error_handler);
+    char path[] = "/tmp/clist_compact_test_XXXXXX";
+    int fd = mkstemp(path);
+    TEST_ASSERT(fd >= 0);
+    close(fd);
+
+    list* l = list_map_file(path);
+    TEST_ASSERT(l != NULL);
+    TEST_CHECK(list_size(l) == 0);
+    long expected[5001];
+    long i = 0;
+    for (; i < 5000; ++i)
+        list_add(l, i);
+    TEST_CHECK(list_remove(l, 0) == 0);
+    list_insert(l, 2500, 0);
+    list_get(l, 4000);
+    check_structure(l, NULL);
+
+    //The file stays locked while the list is open.  
+    TEST_CHECK(list_map_file(path) == NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_sync(l) == 0);
+    free_list(l);
+
+    //Reopened, the list is as it was left and keeps growing in the file.  
+    l = list_map_file(path);
+    TEST_ASSERT(l != NULL);
+    for (i = 0; i < 5000; ++i)
+        expected[i] = i < 2500 ? i + 1 : (i == 2500 ? 0 : i);
+    expected[5000] = 5000;
+    list_add(l, 5000);
+    check_structure(l, expected);
+    for (i = 0; i <= 5000; ++i)
+        TEST_CHECK(list_get(l, i) == expected[i]);
+    for (i = 0; i < 20000; ++i)
+        list_add(l, i);
+    TEST_CHECK(list_get(l, 25000) == 19999);
+    free_list(l);
+
+    l = list_map_file(path);
+    TEST_ASSERT(l != NULL);
+    TEST_CHECK(list_size(l) == 25001);
+    check_structure(l, NULL);
+    sort_list(l);
+    TEST_CHECK(list_get(l, 0) == 0);
+    TEST_CHECK(list_get(l, 25000) == 19999);
+
+    //Lists split off a mapped list, or merged into it, are on the heap.  
+    list* tail = list_split(l, 20000);
+    TEST_CHECK(list_size(tail) == 5001);
+    list_merge(l, tail);
+    TEST_CHECK(list_size(l) == 25001);
+    check_structure(l, NULL);
+    free_list(l);
+
+    //Heap lists are not synced, files of other types are not mapped.  
+    list* heap = new_list();
+    TEST_CHECK(list_sync(heap) == 0);
+    free_list(heap);
+    fd = open(path, O_WRONLY | O_TRUNC);
+    TEST_CHECK(write(fd, "not a list", 10) == 10);
+    close(fd);
+    TEST_CHECK(list_map_file(path) == NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_map_file(NULL) == NULL);
+    check_error_status(in_error);
+
+    check_error_status(not_in_error);
+    unlink(path);
+}
+
+
+void test_random_ranges(void)
+{
+    list_error_handler(error_handler);
+    long* expected = (long*)malloc(200000 * sizeof(long));
+    lindex n = 0;
+    for (; n < 20000; ++n)
+        expected[n] = (long)n;
+    list* l = array_as_list(expected, n);
+    check_structure(l, expected);
+
+    //Ranges of every length, at any offset within the chunks or jump_table
+    //gaps they start and end in.  
+    int i = 0;
+    for (; i < 300; ++i)
+    {
+        lindex start = rand() % (n + 1);
+        lindex end = start + rand() % (i % 3 ? 40 : n - start + 1);
+        if (end > n)
+            end = n;
+        if (n > 0)
+            list_get(l, rand() % n);
+
+        if (i % 3 == 0)
+        {
+            list_remove_range(l, start, end);
+            memmove(&expected[start], &expected[end], (n - end) * sizeof(long));
+            n -= end - start;
+        }
+        else if (i % 3 == 1)
+        {
+            //A list's own range is copied onto its end.  
+            list_copy_range(l, l, start, end);
+            memcpy(&expected[n], &expected[start], (end - start) * sizeof(long));
+            n += end - start;
+        }
+        else
+        {
+            list* moved = new_list();
+            list_add(moved, -1);
+            list_add_range(l, moved, start, end);
+            TEST_CHECK(list_size(moved) == end - start + 1);
+            check_structure(moved, NULL);
+            list_merge(l, moved);
+            long* range = (long*)malloc((end - start + 1) * sizeof(long));
+            memcpy(range, &expected[start], (end - start) * sizeof(long));
+            memmove(&expected[start], &expected[end], (n - end) * sizeof(long));
+            n -= end - start;
+            expected[n++] = -1;
+            memcpy(&expected[n], range, (end - start) * sizeof(long));
+            n += end - start;
+            free(range);
+        }
+        TEST_CHECK(list_size(l) == n);
+        check_structure(l, expected);
+    }
+
+    list* copy = copy_list(l);
+    check_structure(copy, expected);
+    list_remove_range(copy, 0, n);
+    TEST_CHECK(list_size(copy) == 0);
+    check_structure(copy, NULL);
+    list_add(copy, 1);
+    TEST_CHECK(list_get(copy, 0) == 1);
+
+    check_error_status(not_in_error);
+    free(expected);
+    free_list(copy);
+    free_list(l);
+}
+
+
+void test_retain_and_remove_where(void)
+{
+    list_error_handler(error_handler);
+    long* expected = (long*)malloc(20000 * sizeof(long));
+    lindex n = 0;
+    for (; n < 20000; ++n)
+        expected[n] = rand() % 100;
+    list* l = array_as_list(expected, n);
+    list_get(l, 15000);
+
+    //Values are kept in order and the list is indexed again.  
+    list_retain(l, filter1to10);
+    lindex i = 0, kept = 0;
+    for (; i < n; ++i)
+        if (filter1to10(expected[i]))
+            expected[kept++] = expected[i];
+    n = kept;
+    TEST_CHECK(list_size(l) == n);
+    check_structure(l, expected);
+
+    list_remove_where(l, is_even);
+    for (i = 0, kept = 0; i < n; ++i)
+        if (!is_even(expected[i]))
+            expected[kept++] = expected[i];
+    n = kept;
+    TEST_CHECK(list_size(l) == n);
+    check_structure(l, expected);
+    for (i = 0; i < n; ++i)
+        TEST_CHECK(list_get(l, i) == expected[i]);
+
+    //Nothing, then everything, is removed.  
+    list_remove_where(l, is_even);
+    TEST_CHECK(list_size(l) == n);
+    check_structure(l, expected);
+    list_retain(l, is_even);
+    TEST_CHECK(list_size(l) == 0);
+    check_structure(l, NULL);
+    list_add(l, 3);
+    TEST_CHECK(list_get(l, 0) == 3);
+
+    check_error_status(not_in_error);
+    free(expected);
+    free_list(l);
+}
+
+
+TEST_LIST = {
+    {"New list has correct intial values", test_new_list_intial_values},
+    {"API functions have null list checks", test_api_null_checks},
+    {"Add, get and pop", test_add_get_pop},
+    {"Random inserts and removes", test_random_insert_remove},
+    {"Front inserts and removes", test_front_inserts_and_removes},
+    {"Sorting", test_sort},
+    {"Where and split where", test_where_and_split_where},
+    {"Split and merge", test_split_and_merge},
+    {"Random splits and merges", test_random_split_merge},
+    {"Arena relocation", test_relocation},
+    {"Lists in mapped files", test_mapped_file},
+    {"Random range moves, copies and removes", test_random_ranges},
+    {"Retain and remove where", test_retain_and_remove_where},
+    {NULL, NULL}
+};
@@ -0,0 +1,203 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_concurrent_test.c
+// Verifies correct behavior of clist_concurrent.h.  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdbool.h>
+#include <string.h>
+#include "../../acutest/include/acutest.h"
+
+#define LIST_DATA_TYPE long
+#define ERROR_RETURN_VALUE -1
+
+#include "../include/clist_concurrent.h"
+
+
+bool ERROR_STATUS = false;
+const char* ERROR_ARG = NULL;
+
+bool not_in_error = false;
+bool in_error = true;
+
+void check_error_status(bool should_be_error)
+{
+    bool current = ERROR_STATUS;
+    ERROR_STATUS = false;
+    TEST_CHECK(current == should_be_error);
+}
+
+int error_handler(const char* func, const char* arg, const char* msg)
+{
+    ERROR_STATUS = true;
+    ERROR_ARG = arg;
+    return 0;
+}
+
+
+#define WRITERS 4
+#define READERS 4
+#define ADDS_PER_WRITER 5000
+
+int is_negative(long x)
+{
+    return x < 0;
+}
+
+//Sums every value of the list into ctx.  
+void sum_values(const list* l, void* ctx)
+{
+    lindex i = 0;
+    for (; i < list_size(l); ++i)
+        *(long*)ctx += list_get_const(l, i);
+}
+
+//Adds -1 to -10 to the front of the list.  
+void add_negatives(list* l, void* ctx)
+{
+    long i = 1;
+    for (; i <= 10; ++i)
+        list_insert(l, 0, -i);
+}
+
+//Adds its values in batches of 100.  
+void* writer(void* arg)
+{
+    concurrent_list* cl = (concurrent_list*)arg;
+    long batch[100];
+    int i = 0;
+    for (; i < ADDS_PER_WRITER; i += 100)
+    {
+        int j = 0;
+        for (; j < 100; ++j)
+            batch[j] = i + j;
+        concurrent_list_add_all(cl, batch, 100);
+    }
+    return NULL;
+}
+
+//Checks that every value it can see is in range, while the writers run.  
+void* reader(void* arg)
+{
+    concurrent_list* cl = (concurrent_list*)arg;
+    long bad = 0;
+    int i = 0;
+    for (; i < 2000; ++i)
+    {
+        lindex size = concurrent_list_size(cl);
+        if (size == 0) continue;
+        long value = concurrent_list_get(cl, (i * 7919) % size);
+        if (value < 0 || value >= ADDS_PER_WRITER)
+            ++bad;
+    }
+    return (void*)bad;
+}
+
+
+void test_api_null_checks(void)
+{
+    list_error_handler(error_handler);
+    TEST_CHECK(concurrent_list_size(NULL) == (lindex)-1);
+    check_error_status(in_error);
+    TEST_CHECK(concurrent_list_get(NULL, 0) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(concurrent_list_where(NULL, NULL) == NULL);
+    check_error_status(in_error);
+    concurrent_list_read(NULL, NULL, NULL);
+    check_error_status(in_error);
+    concurrent_list_add(NULL, 0);
+    check_error_status(in_error);
+    concurrent_list_add_all(NULL, NULL, 1);
+    check_error_status(in_error);
+    concurrent_list_insert(NULL, 0, 0);
+    check_error_status(in_error);
+    TEST_CHECK(concurrent_list_remove(NULL, 0) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(concurrent_list_pop(NULL) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+    concurrent_list_sort(NULL);
+    check_error_status(in_error);
+    concurrent_list_write(NULL, NULL, NULL);
+    check_error_status(in_error);
+    free_concurrent_list(NULL);
+
+    //A NULL array is a bad argument, not an allocation failure.  
+    concurrent_list* cl = new_concurrent_list();
+    concurrent_list_add_all(cl, NULL, 1);
+    check_error_status(in_error);
+    TEST_CHECK(ERROR_ARG != NULL && strcmp(ERROR_ARG, "values") == 0);
+    TEST_CHECK(concurrent_list_size(cl) == 0);
+    free_concurrent_list(cl);
+}
+
+
+void test_operations(void)
+{
+    list_error_handler(error_handler);
+    concurrent_list* cl = new_concurrent_list();
+    TEST_ASSERT(cl != NULL);
+
+    long i = 0;
+    for (; i < 100; ++i)
+        concurrent_list_add(cl, 99 - i);
+    concurrent_list_insert(cl, 0, 1000);
+    TEST_CHECK(concurrent_list_get(cl, 0) == 1000);
+    TEST_CHECK(concurrent_list_remove(cl, 0) == 1000);
+    TEST_CHECK(concurrent_list_pop(cl) == 0);
+
+    concurrent_list_sort(cl);
+    TEST_CHECK(concurrent_list_get(cl, 0) == 1);
+    TEST_CHECK(concurrent_list_size(cl) == 99);
+
+    concurrent_list_write(cl, add_negatives, NULL);
+    list* negatives = concurrent_list_where(cl, is_negative);
+    TEST_CHECK(list_size(negatives) == 10);
+    TEST_CHECK(list_get(negatives, 0) == -10);
+    free_list(negatives);
+
+    long sum = 0;
+    concurrent_list_read(cl, sum_values, &sum);
+    TEST_CHECK(sum == 99 * 100 / 2 - 55);
+
+    TEST_CHECK(concurrent_list_get(cl, 1000) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+
+    check_error_status(not_in_error);
+    free_concurrent_list(cl);
+}
+
+
+void test_concurrent_readers_and_writers(void)
+{
+    list_error_handler(error_handler);
+    concurrent_list* cl = new_concurrent_list();
+    pthread_t threads[WRITERS + READERS];
+    int t = 0;
+    for (; t < WRITERS + READERS; ++t)
+        TEST_ASSERT(pthread_create(&threads[t], NULL, t < WRITERS ? writer : reader,
+                                   cl) == 0);
+    for (t = 0; t < WRITERS + READERS; ++t)
+    {
+        void* bad;
+        pthread_join(threads[t], &bad);
+        TEST_CHECK(bad == NULL);
+    }
+
+    TEST_CHECK(concurrent_list_size(cl) == WRITERS * ADDS_PER_WRITER);
+    long sum = 0;
+    concurrent_list_read(cl, sum_values, &sum);
+    TEST_CHECK(sum == (long)WRITERS * ADDS_PER_WRITER * (ADDS_PER_WRITER - 1) / 2);
+
+    check_error_status(not_in_error);
+    free_concurrent_list(cl);
+}
+
+
+TEST_LIST = {
+    {"API functions have null list checks", test_api_null_checks},
+    {"Concurrent list operations", test_operations},
+    {"Concurrent readers and writers", test_concurrent_readers_and_writers},
+    {NULL, NULL}
+};
@@ -0,0 +1,295 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_cpp_test.cpp
+// Verifies correct behavior of clist.hpp.  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#include <numeric>
+#include <random>
+#include <string>
+#include "../../acutest/include/acutest.h"
+
+#include "../include/clist.hpp"
+
+
+//Counts the live instances, to check that every value is destroyed.  
+struct counted
+{
+    static int live;
+    int value;
+
+    explicit counted(int v) : value(v) { ++live; }
+    counted(const counted& other) : value(other.value) { ++live; }
+    ~counted() { --live; }
+};
+
+int counted::live = 0;
+
+//Throws when constructed from a negative value.  
+struct picky
+{
+    int value;
+
+    explicit picky(int v) : value(v)
+    {
+        if (v < 0)
+            throw std::invalid_argument("negative");
+    }
+};
+
+//Pairs are ordered by key only, so the order of equal keys shows stability.  
+struct key_less
+{
+    bool operator()(const std::pair<int, int>& a, const std::pair<int, int>& b) const
+    {
+        return a.first < b.first;
+    }
+};
+
+struct unique_less
+{
+    bool operator()(const std::unique_ptr<int>& a, const std::unique_ptr<int>& b) const
+    {
+        return *a < *b;
+    }
+};
+
+/*
+Checks that 'l' holds the values of 'expected', by index and by iteration.  
+*/
+template <class List>
+void check_same(List& l, const std::vector<long>& expected)
+{
+    TEST_ASSERT(l.size() == expected.size());
+    TEST_CHECK(std::equal(l.begin(), l.end(), expected.begin()));
+    TEST_CHECK(std::equal(l.rbegin(), l.rend(), expected.rbegin()));
+    const List& cl = l;
+    for (std::size_t i = 0; i < expected.size(); i += 97)
+    {
+        TEST_CHECK(l[i] == expected[i]);
+        TEST_CHECK(cl[expected.size() - 1 - i] == expected[expected.size() - 1 - i]);
+    }
+}
+
+
+void test_operations(void)
+{
+    clist<long> l;
+    std::vector<long> expected;
+    for (long i = 0; i < 10000; ++i)
+    {
+        l.push_back(i);
+        expected.push_back(i);
+    }
+    check_same(l, expected);
+
+    l.emplace_at(5000, -1);
+    expected.insert(expected.begin() + 5000, -1);
+    l.push_front(-2);
+    expected.insert(expected.begin(), -2);
+    l.emplace(l.iterator_at(3000), -3);
+    expected.insert(expected.begin() + 3000, -3);
+    l.insert(l.end(), -4);
+    expected.push_back(-4);
+    check_same(l, expected);
+
+    l.erase_at(4000);
+    expected.erase(expected.begin() + 4000);
+    TEST_CHECK(*l.erase(l.iterator_at(100)) == expected[101]);
+    expected.erase(expected.begin() + 100);
+    l.pop_front();
+    expected.erase(expected.begin());
+    l.pop_back();
+    expected.pop_back();
+    check_same(l, expected);
+
+    TEST_CHECK(l.front() == expected.front());
+    TEST_CHECK(l.back() == expected.back());
+    TEST_CHECK(l.iterator_at(l.size()) == l.end());
+
+    bool thrown = false;
+    try { l.at(l.size()); } catch (const std::out_of_range&) { thrown = true; }
+    TEST_CHECK(thrown);
+    thrown = false;
+    try { l.emplace_at(l.size() + 1, 0); } catch (const std::out_of_range&) { thrown = true; }
+    TEST_CHECK(thrown);
+    TEST_CHECK(l.size() == expected.size());
+
+    l.clear();
+    TEST_CHECK(l.empty());
+    TEST_CHECK(l.begin() == l.end());
+    l.push_back(1);
+    TEST_CHECK(l[0] == 1);
+}
+
+
+void test_random_operations(void)
+{
+    clist<long> l;
+    std::vector<long> expected;
+    std::mt19937 rng(1234);
+    for (int step = 0; step < 20000; ++step)
+    {
+        std::size_t size = expected.size();
+        std::size_t index = size ? rng() % size : 0;
+        long value = (long)rng();
+        switch (rng() % 8)
+        {
+            case 0:
+            case 1:
+                l.push_back(value);
+                expected.push_back(value);
+                break;
+            case 2:
+                l.emplace_at(index, value);
+                expected.insert(expected.begin() + index, value);
+                break;
+            case 3:
+                l.push_front(value);
+                expected.insert(expected.begin(), value);
+                break;
+            case 4:
+                if (size == 0) break;
+                l.erase_at(index);
+                expected.erase(expected.begin() + index);
+                break;
+            case 5:
+                if (size == 0) break;
+                l.pop_back();
+                expected.pop_back();
+                break;
+            case 6:
+                if (size == 0) break;
+                TEST_CHECK(l[index] == expected[index]);
+                l[index] = value;
+                expected[index] = value;
+                break;
+            case 7:
+                if (size == 0) break;
+                TEST_CHECK(l.at(size - 1 - index) == expected[size - 1 - index]);
+                break;
+        }
+    }
+    check_same(l, expected);
+}
+
+
+void test_sort(void)
+{
+    clist<std::pair<int, int>, key_less> l;
+    for (int i = 0; i < 5000; ++i)
+        l.emplace_back((i * 7919) % 100, i);
+    auto first = l.begin();
+    const std::pair<int, int>* first_value = &*first;
+    l[2500];
+
+    l.sort();
+    TEST_CHECK(std::is_sorted(l.begin(), l.end(), key_less()));
+    for (std::size_t i = 1; i < l.size(); ++i)
+        if (l[i].first == l[i-1].first)
+            TEST_CHECK(l[i].second > l[i-1].second);
+
+    //Nodes were relinked, not copied.  
+    TEST_CHECK(&*first == first_value);
+    TEST_CHECK(l[4999].first == 99);
+
+    clist<long, std::greater<long>> d = {3, 1, 4, 1, 5, 9, 2, 6};
+    d.sort();
+    std::vector<long> expected = {9, 6, 5, 4, 3, 2, 1, 1};
+    check_same(d, expected);
+}
+
+
+void test_move_only_values(void)
+{
+    clist<std::unique_ptr<int>, unique_less> l;
+    for (int i = 0; i < 100; ++i)
+        l.emplace_back(new int(99 - i));
+    l.emplace(l.begin(), std::make_unique<int>(1000));
+    l.emplace_at(50, std::make_unique<int>(-1));
+    l.sort();
+    TEST_CHECK(*l.front() == -1);
+    TEST_CHECK(*l.back() == 1000);
+    TEST_CHECK(*l[50] == 49);
+
+    clist<std::unique_ptr<int>, unique_less> moved(std::move(l));
+    TEST_CHECK(l.empty());
+    TEST_CHECK(moved.size() == 102);
+    l = std::move(moved);
+    TEST_CHECK(moved.empty());
+    TEST_CHECK(*l[101] == 1000);
+
+    std::unique_ptr<int> taken = std::move(l.back());
+    l.pop_back();
+    TEST_CHECK(*taken == 1000);
+    TEST_CHECK(l.size() == 101);
+}
+
+
+void test_algorithms(void)
+{
+    clist<std::string> l = {"c", "a", "d", "b"};
+    TEST_CHECK(std::find(l.begin(), l.end(), "d") == l.iterator_at(2));
+    TEST_CHECK(std::count_if(l.cbegin(), l.cend(),
+                             [](const std::string& s) { return s < "c"; }) == 2);
+    std::reverse(l.begin(), l.end());
+    TEST_CHECK(l[0] == "b" && l[3] == "c");
+    TEST_CHECK(std::accumulate(l.begin(), l.end(), std::string()) == "bdac");
+    TEST_CHECK(std::distance(l.begin(), l.end()) == 4);
+    TEST_CHECK(*std::prev(l.end()) == "c");
+    TEST_CHECK(*std::max_element(l.begin(), l.end()) == "d");
+
+    clist<std::string>::const_iterator it = l.begin();
+    TEST_CHECK(it == l.cbegin());
+
+    clist<std::string> copy = l;
+    copy[0] = "x";
+    TEST_CHECK(l[0] == "b");
+    copy = l;
+    TEST_CHECK(std::equal(copy.begin(), copy.end(), l.begin()));
+
+    swap(copy, l);
+    TEST_CHECK(copy.size() == 4);
+}
+
+
+void test_values_are_destroyed(void)
+{
+    {
+        clist<counted> l;
+        for (int i = 0; i < 3000; ++i)
+            l.emplace_back(i);
+        l.erase_at(10);
+        l.pop_front();
+        l.erase(l.begin());
+        TEST_CHECK(counted::live == 2997);
+
+        clist<counted> copy = l;
+        TEST_CHECK(counted::live == 2 * 2997);
+        copy.clear();
+        TEST_CHECK(counted::live == 2997);
+    }
+    TEST_CHECK(counted::live == 0);
+
+    //A throwing constructor leaves the list unchanged.  
+    clist<picky> p;
+    p.emplace_back(1);
+    bool thrown = false;
+    try { p.emplace_at(0, -1); } catch (const std::invalid_argument&) { thrown = true; }
+    TEST_CHECK(thrown);
+    TEST_CHECK(p.size() == 1);
+    TEST_CHECK(p[0].value == 1);
+}
+
+
+TEST_LIST = {
+    {"List operations", test_operations},
+    {"Random operations match std::vector", test_random_operations},
+    {"Stable sort by Compare", test_sort},
+    {"Move-only values", test_move_only_values},
+    {"Standard algorithms on list iterators", test_algorithms},
+    {"Values are destroyed with the list", test_values_are_destroyed},
+    {NULL, NULL}
+};
@@ -0,0 +1,207 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_io_test.c
+// Verifies correct behavior of clist_io.h.  
+// Built once for each storage layout by the io_test target.  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "../../acutest/include/acutest.h"
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define LIST_DATA_TYPE long
+#define ERROR_RETURN_VALUE -1
+#define LIST_IO_WRITEV short_writev
+
+//Largest number of bytes short_writev writes per call, 0 for no limit.  
+size_t WRITE_LIMIT = 0;
+
+//writev that writes at most WRITE_LIMIT bytes, like an interrupted pipe.  
+ssize_t short_writev(int fd, const struct iovec* iov, int count)
+{
+    if (WRITE_LIMIT == 0 || iov[0].iov_len == 0)
+        return writev(fd, iov, count);
+    return write(fd, iov[0].iov_base,
+                 iov[0].iov_len < WRITE_LIMIT ? iov[0].iov_len : WRITE_LIMIT);
+}
+
+#include "../include/clist_io.h"
+
+
+bool ERROR_STATUS = false;
+
+bool not_in_error = false;
+bool in_error = true;
+
+void check_error_status(bool should_be_error)
+{
+    bool current = ERROR_STATUS;
+    ERROR_STATUS = false;
+    TEST_CHECK(current == should_be_error);
+}
+
+int error_handler(const char* func, const char* arg, const char* msg)
+{
+    ERROR_STATUS = true;
+    return 0;
+}
+
+
+//Writes 'l' to a new temporary file and reads it back.  
+list* round_trip(list* l)
+{
+    FILE* f = tmpfile();
+    if (!TEST_CHECK(f != NULL)) return NULL;
+    int fd = fileno(f);
+    TEST_CHECK(list_write_fd(l, fd) == 0);
+    TEST_CHECK(lseek(fd, 0, SEEK_SET) == 0);
+    list* nl = list_read_fd(fd);
+    fclose(f);
+    return nl;
+}
+
+
+void test_api_null_checks(void)
+{
+    list_error_handler(error_handler);
+    TEST_CHECK(list_write_fd(NULL, 1) == -1);
+    check_error_status(in_error);
+    TEST_CHECK(list_read_fd(-1) == NULL);
+    check_error_status(in_error);
+}
+
+
+void test_round_trip(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 100; ++i)
+        list_add(l, i * i);
+
+    list* nl = round_trip(l);
+    TEST_ASSERT(nl != NULL);
+    TEST_CHECK(list_size(nl) == 100);
+    for (i = 0; i < 100; ++i)
+        TEST_CHECK(list_get(nl, i) == i * i);
+
+    //The loaded list is a normal list.  
+    list_insert(nl, 50, -1);
+    TEST_CHECK(list_get(nl, 50) == -1);
+    TEST_CHECK(list_get(nl, 51) == 50 * 50);
+    TEST_CHECK(list_remove(nl, 0) == 0);
+    TEST_CHECK(list_pop(nl) == 99 * 99);
+
+    check_error_status(not_in_error);
+    free_list(nl);
+    free_list(l);
+}
+
+
+void test_empty_and_large_lists(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    list* nl = round_trip(l);
+    TEST_ASSERT(nl != NULL);
+    TEST_CHECK(list_size(nl) == 0);
+    list_add(nl, 7);
+    TEST_CHECK(list_get(nl, 0) == 7);
+    free_list(nl);
+
+    //Several batches, the last one partial, and many jump_table entries.  
+    const long count = 3 * LIST_IO_BATCH + 123;
+    long i = 0;
+    for (; i < count; ++i)
+        list_add(l, count - i);
+    nl = round_trip(l);
+    TEST_ASSERT(nl != NULL);
+    TEST_CHECK(list_size(nl) == (lindex)count);
+    for (i = count - 1; i >= 0; i -= 997)
+        TEST_CHECK(list_get(nl, i) == count - i);
+    sort_list(nl);
+    TEST_CHECK(list_get(nl, 0) == 1);
+    TEST_CHECK(list_get(nl, count - 1) == count);
+
+    check_error_status(not_in_error);
+    free_list(nl);
+    free_list(l);
+}
+
+
+void test_bad_input(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 1000; ++i)
+        list_add(l, i);
+
+    //Cut off in the middle of the values.  
+    FILE* f = tmpfile();
+    TEST_ASSERT(f != NULL);
+    int fd = fileno(f);
+    TEST_CHECK(list_write_fd(l, fd) == 0);
+    TEST_CHECK(ftruncate(fd, lseek(fd, 0, SEEK_CUR) - sizeof(long)) == 0);
+    TEST_CHECK(lseek(fd, 0, SEEK_SET) == 0);
+    TEST_CHECK(list_read_fd(fd) == NULL);
+    check_error_status(in_error);
+
+    //Values of a different size.  
+    TEST_CHECK(lseek(fd, 8, SEEK_SET) == 8);
+    uint32_t value_size = sizeof(long) + 1;
+    TEST_CHECK(write(fd, &value_size, sizeof(value_size)) == sizeof(value_size));
+    TEST_CHECK(lseek(fd, 0, SEEK_SET) == 0);
+    TEST_CHECK(list_read_fd(fd) == NULL);
+    check_error_status(in_error);
+
+    //Not a list at all.  
+    TEST_CHECK(lseek(fd, 0, SEEK_SET) == 0);
+    TEST_CHECK(write(fd, "XXXX", 4) == 4);
+    TEST_CHECK(lseek(fd, 0, SEEK_SET) == 0);
+    TEST_CHECK(list_read_fd(fd) == NULL);
+    check_error_status(in_error);
+    fclose(f);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+
+void test_short_writes(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    const long count = 2 * LIST_IO_BATCH + 5;
+    long i = 0;
+    for (; i < count; ++i)
+        list_add(l, i * 3);
+
+    //Every batch is written in pieces that end inside a value.  
+    WRITE_LIMIT = 1000;
+    list* nl = round_trip(l);
+    WRITE_LIMIT = 0;
+    TEST_ASSERT(nl != NULL);
+    TEST_CHECK(list_size(nl) == (lindex)count);
+    for (i = 0; i < count; ++i)
+        TEST_CHECK(list_get(nl, i) == i * 3);
+
+    check_error_status(not_in_error);
+    free_list(nl);
+    free_list(l);
+}
+
+
+TEST_LIST = {
+    {"API functions have null list checks", test_api_null_checks},
+    {"Lists are written and read back", test_round_trip},
+    {"Empty and multi batch lists are written and read back", test_empty_and_large_lists},
+    {"Truncated and foreign files are rejected", test_bad_input},
+    {"Short writes are continued", test_short_writes},
+    {NULL, NULL}
+};
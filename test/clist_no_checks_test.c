@@ -0,0 +1,83 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_no_checks_test.c
+// Verifies correct behavior of clist.h built with CLIST_NO_CHECKS.  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdbool.h>
+#include "../../acutest/include/acutest.h"
+
+#define LIST_DATA_TYPE long
+#define ERROR_RETURN_VALUE -1
+#define CLIST_NO_CHECKS 1
+
+#include "../include/clist.h"
+
+
+bool ERROR_STATUS = false;
+
+bool not_in_error = false;
+bool in_error = true;
+
+void check_error_status(bool should_be_error)
+{
+    bool current = ERROR_STATUS;
+    ERROR_STATUS = false;
+    TEST_CHECK(current == should_be_error);
+}
+
+int error_handler(const char* func, const char* arg, const char* msg)
+{
+    ERROR_STATUS = true;
+    return 0;
+}
+
+
+void test_operations(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 5000; ++i)
+        list_add(l, i);
+    list_insert(l, 0, -1);
+    TEST_CHECK(list_remove(l, 0) == -1);
+    TEST_CHECK(list_pop(l) == 4999);
+    for (i = 0; i < 4999; ++i)
+        TEST_CHECK(list_get(l, i) == i);
+
+    list* second = list_split(l, 2000);
+    TEST_CHECK(list_size(l) == 2000);
+    TEST_CHECK(list_get(second, 0) == 2000);
+    list_merge(l, second);
+    TEST_CHECK(list_size(l) == 4999);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+
+void test_try_get_still_checks(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    list_add(l, 1);
+
+    long value = 0;
+    TEST_CHECK(list_try_get(l, 0, &value) == LIST_OK);
+    TEST_CHECK(value == 1);
+    TEST_CHECK(list_try_get(l, 1, &value) == LIST_INDEX_OUT_OF_RANGE);
+    TEST_CHECK(list_try_get(NULL, 0, &value) == LIST_NULL_ARG);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+
+TEST_LIST = {
+    {"List operations without checks", test_operations},
+    {"list_try_get still checks its arguments", test_try_get_still_checks},
+    {NULL, NULL}
+};
@@ -0,0 +1,394 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_parallel_test.c
+// Verifies correct behavior of clist_parallel.h.  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdbool.h>
+#include "../../acutest/include/acutest.h"
+
+//Values are ordered by key only, so the order of equal keys shows stability.  
+#define KEY_RANGE 100000
+static inline int key_less(long a, long b)
+{
+    return a / KEY_RANGE < b / KEY_RANGE;
+}
+
+#define LIST_DATA_TYPE long
+#define ERROR_RETURN_VALUE -1
+#define LIST_COMPARATOR key_less
+#define LIST_PARALLEL_MIN_SEGMENT 1000
+
+#include "../include/clist_parallel.h"
+
+
+bool ERROR_STATUS = false;
+
+bool not_in_error = false;
+bool in_error = true;
+
+void check_error_status(bool should_be_error)
+{
+    bool current = ERROR_STATUS;
+    ERROR_STATUS = false;
+    TEST_CHECK(current == should_be_error);
+}
+
+int error_handler(const char* func, const char* arg, const char* msg)
+{
+    ERROR_STATUS = true;
+    return 0;
+}
+
+/*
+Checks the links and jump_table of 'l'.  
+*/
+void check_structure(list* l)
+{
+    _node* prev = NULL;
+    _node* current = l->head;
+    lindex index = 0;
+    for (; current != NULL; prev = current, current = current->next, ++index)
+    {
+        TEST_ASSERT(current->prev == prev);
+        if ((index + l->jt_offset) % JT_INCREMENT == 0)
+            TEST_ASSERT(l->jump_table[_jt_entry_of(l, index)] == current);
+    }
+    TEST_CHECK(l->tail == prev);
+    TEST_CHECK(index == l->size);
+    if (l->current)
+        TEST_CHECK(list_get(l, l->current_index) == l->current->value);
+}
+
+/*
+Fills 'a' and 'b' with the same 'n' values, each a random key and its
+position.  
+*/
+void fill_lists(list* a, list* b, lindex n, long keys)
+{
+    lindex i = 0;
+    for (; i < n; ++i)
+    {
+        long value = (rand() % keys) * KEY_RANGE + i % KEY_RANGE;
+        list_add(a, value);
+        list_add(b, value);
+    }
+}
+
+/*
+Checks that 'a' and 'b' hold the same values in the same order.  
+*/
+void check_same(list* a, list* b)
+{
+    TEST_ASSERT(list_size(a) == list_size(b));
+    _node* x = a->head;
+    _node* y = b->head;
+    for (; x != NULL; x = x->next, y = y->next)
+        TEST_ASSERT(x->value == y->value);
+}
+
+
+void test_api_null_checks(void)
+{
+    list_error_handler(error_handler);
+    sort_list_parallel(NULL, 4);
+    check_error_status(in_error);
+    TEST_CHECK(list_where_parallel(NULL, NULL, 4) == NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_map_parallel(NULL, NULL, 4) == NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_reduce_parallel(NULL, NULL, 0, 4) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+}
+
+
+void test_matches_sort_list(void)
+{
+    list_error_handler(error_handler);
+    unsigned threads[] = {2, 3, 4, 7, 8, 16};
+    unsigned t = 0;
+    for (; t < sizeof(threads) / sizeof(threads[0]); ++t)
+    {
+        list* a = new_list();
+        list* b = new_list();
+        fill_lists(a, b, 50000 + rand() % 5000, 1 + rand() % 200);
+
+        sort_list(a);
+        sort_list_parallel(b, threads[t]);
+        check_same(a, b);
+        check_structure(b);
+
+        free_list(a);
+        free_list(b);
+    }
+    check_error_status(not_in_error);
+}
+
+
+void test_shifted_and_stale_jump_table(void)
+{
+    list_error_handler(error_handler);
+    list* a = new_list();
+    list* b = new_list();
+    lindex i = 0;
+    for (; i < 30001; ++i)
+    {
+        long value = (rand() % 50) * KEY_RANGE + i;
+        list_push_front(a, value);
+        list_push_front(b, value);
+    }
+    list_cursor c = list_cursor_at(b, 12345);
+    list_cursor_remove_here(&c);
+    c = list_cursor_at(a, 12345);
+    list_cursor_remove_here(&c);
+    TEST_CHECK(b->jt_offset > 0);
+    TEST_CHECK(b->jt_stale_from != JT_ALL_VALID);
+
+    list_get(b, 20000);
+    _node* current = b->current;
+    sort_list(a);
+    sort_list_parallel(b, 6);
+    check_same(a, b);
+    check_structure(b);
+    TEST_CHECK(b->current == current);
+    TEST_CHECK(b->jt_stale_from == JT_ALL_VALID);
+
+    check_error_status(not_in_error);
+    free_list(a);
+    free_list(b);
+}
+
+
+void test_sorted_and_small_lists(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    lindex i = 0;
+    for (; i < 20000; ++i)
+        list_add(l, i * KEY_RANGE);
+
+    //Nothing moves for a list that is already in order.  
+    _node* head = l->head;
+    sort_list_parallel(l, 8);
+    TEST_CHECK(l->head == head);
+    check_structure(l);
+
+    //Descending runs across segment boundaries.  
+    list* r = new_list();
+    list* s = new_list();
+    for (i = 0; i < 20000; ++i)
+    {
+        list_add(r, (20000 - i / 7) * KEY_RANGE + i % 7);
+        list_add(s, (20000 - i / 7) * KEY_RANGE + i % 7);
+    }
+    sort_list(r);
+    sort_list_parallel(s, 5);
+    check_same(r, s);
+    check_structure(s);
+
+    //Too small to split.  
+    list* small = new_list();
+    list_add(small, 3 * KEY_RANGE);
+    list_add(small, 1 * KEY_RANGE);
+    sort_list_parallel(small, 32);
+    TEST_CHECK(list_get(small, 0) == 1 * KEY_RANGE);
+    sort_list_parallel(small, 0);
+    TEST_CHECK(list_get(small, 1) == 3 * KEY_RANGE);
+
+    list* empty = new_list();
+    sort_list_parallel(empty, 4);
+    TEST_CHECK(list_size(empty) == 0);
+
+    check_error_status(not_in_error);
+    free_list(empty);
+    free_list(small);
+    free_list(r);
+    free_list(s);
+    free_list(l);
+}
+
+
+int odd_key(long x)
+{
+    return (x / KEY_RANGE) % 2 == 1;
+}
+
+long next_key(long x)
+{
+    return x + KEY_RANGE;
+}
+
+//Keeps the smallest key, and the first value with it.  
+long min_key(long acc, long x)
+{
+    return key_less(x, acc) ? x : acc;
+}
+
+long sum(long acc, long x)
+{
+    return acc + x;
+}
+
+
+void test_where_map_reduce(void)
+{
+    list_error_handler(error_handler);
+    unsigned threads[] = {1, 2, 3, 8};
+    unsigned t = 0;
+    for (; t < sizeof(threads) / sizeof(threads[0]); ++t)
+    {
+        list* a = new_list();
+        list* b = new_pooled_list(0);
+        fill_lists(a, b, 20000 + rand() % 5000, 100);
+        //Start from a shifted jump_table.  
+        list_push_front(b, 0);
+        list_pop_front(b);
+
+        list* odd = list_where(a, odd_key);
+        list* odd_parallel = list_where_parallel(b, odd_key, threads[t]);
+        check_same(odd, odd_parallel);
+        check_structure(odd_parallel);
+
+        list* mapped = list_map_parallel(b, next_key, threads[t]);
+        check_structure(mapped);
+        TEST_ASSERT(list_size(mapped) == list_size(a));
+        _node* x = a->head;
+        _node* y = mapped->head;
+        for (; x != NULL; x = x->next, y = y->next)
+            TEST_ASSERT(y->value == x->value + KEY_RANGE);
+
+        long expected = 0;
+        for (x = a->head; x != NULL; x = x->next)
+            expected += x->value;
+        TEST_CHECK(list_reduce_parallel(b, sum, 0, threads[t]) == expected);
+        TEST_CHECK(list_reduce_parallel(b, sum, 5, threads[t]) == expected + 5);
+
+        long first_min = a->head->value;
+        for (x = a->head; x != NULL; x = x->next)
+            first_min = min_key(first_min, x->value);
+        TEST_CHECK(list_reduce_parallel(b, min_key, b->head->value, threads[t])
+                   == first_min);
+
+        free_list(odd);
+        free_list(odd_parallel);
+        free_list(mapped);
+        free_list(a);
+        free_list(b);
+    }
+
+    list* empty = new_list();
+    list* none = list_where_parallel(empty, odd_key, 4);
+    TEST_CHECK(list_size(none) == 0);
+    TEST_CHECK(list_reduce_parallel(empty, sum, 7, 4) == 7);
+
+    check_error_status(not_in_error);
+    free_list(none);
+    free_list(empty);
+}
+
+
+//Reads every value of the list with list_get_const.  
+void* read_all(void* arg)
+{
+    list* l = (list*)arg;
+    lindex i = 0;
+    long sum = 0;
+    for (; i < l->size; ++i)
+        sum += list_get_const(l, (i * 7919) % l->size);
+    return (void*)sum;
+}
+
+void test_concurrent_get_const(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0, expected = 0;
+    for (; i < 20000; ++i)
+    {
+        list_add(l, i);
+        expected += i;
+    }
+    list_get(l, 100);
+
+    pthread_t threads[4];
+    int t = 0;
+    for (; t < 4; ++t)
+        TEST_ASSERT(pthread_create(&threads[t], NULL, read_all, l) == 0);
+    for (t = 0; t < 4; ++t)
+    {
+        void* sum;
+        pthread_join(threads[t], &sum);
+        TEST_CHECK((long)sum == expected);
+    }
+    TEST_CHECK(l->current_index == 100);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+
+
+#define PRODUCERS 4
+#define PENDING_PER_PRODUCER 20000
+
+//Stages its values, each tagged with the producer in the high digits.  
+void* stage_values(void* arg)
+{
+    list* l = ((void**)arg)[0];
+    long producer = (long)((void**)arg)[1];
+    long i = 0;
+    for (; i < PENDING_PER_PRODUCER; ++i)
+        list_add_pending(l, producer * PENDING_PER_PRODUCER + i);
+    return NULL;
+}
+
+void test_concurrent_add_pending(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    pthread_t threads[PRODUCERS];
+    void* args[PRODUCERS][2];
+    long p = 0;
+    for (; p < PRODUCERS; ++p)
+    {
+        args[p][0] = l;
+        args[p][1] = (void*)p;
+        TEST_ASSERT(pthread_create(&threads[p], NULL, stage_values, args[p]) == 0);
+    }
+
+    //The owner drains while the producers are still staging.  
+    lindex drained = 0;
+    while (drained < PRODUCERS * PENDING_PER_PRODUCER)
+        drained += list_drain_pending(l);
+    for (p = 0; p < PRODUCERS; ++p)
+        pthread_join(threads[p], NULL);
+    TEST_CHECK(list_drain_pending(l) == 0);
+    TEST_CHECK(list_size(l) == PRODUCERS * PENDING_PER_PRODUCER);
+    check_structure(l);
+
+    //Each producer's values arrive in the order they were staged.  
+    long next[PRODUCERS] = {0};
+    _node* node = l->head;
+    for (; node != NULL; node = node->next)
+    {
+        long producer = node->value / PENDING_PER_PRODUCER;
+        TEST_CHECK(node->value % PENDING_PER_PRODUCER == next[producer]);
+        ++next[producer];
+    }
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+TEST_LIST = {
+    {"API functions have null list checks", test_api_null_checks},
+    {"Parallel sort matches sort_list", test_matches_sort_list},
+    {"Parallel sort with a shifted and stale jump table", test_shifted_and_stale_jump_table},
+    {"Parallel sort of sorted and small lists", test_sorted_and_small_lists},
+    {"Parallel where, map and reduce", test_where_map_reduce},
+    {"Concurrent reads with list_get_const", test_concurrent_get_const},
+    {"Concurrent producers staging values", test_concurrent_add_pending},
+    {NULL, NULL}
+};
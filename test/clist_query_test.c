@@ -0,0 +1,194 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_query_test.c
+// Verifies correct behavior of clist_query.h.  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdbool.h>
+#include "../../acutest/include/acutest.h"
+
+#define LIST_DATA_TYPE long
+#define ERROR_RETURN_VALUE -1
+
+#include "../include/clist_query.h"
+
+
+bool ERROR_STATUS = false;
+
+bool not_in_error = false;
+bool in_error = true;
+
+void check_error_status(bool should_be_error)
+{
+    bool current = ERROR_STATUS;
+    ERROR_STATUS = false;
+    TEST_CHECK(current == should_be_error);
+}
+
+int error_handler(const char* func, const char* arg, const char* msg)
+{
+    ERROR_STATUS = true;
+    return 0;
+}
+
+
+int is_multiple_of(long x, void* ctx)
+{
+    return x % *(long*)ctx == 0;
+}
+
+int less_than(long x, void* ctx)
+{
+    return x < *(long*)ctx;
+}
+
+long times(long x, void* ctx)
+{
+    return x * *(long*)ctx;
+}
+
+//Counts its calls in ctx, to show how far the list was walked.  
+int count_calls(long x, void* ctx)
+{
+    ++*(long*)ctx;
+    return 1;
+}
+
+
+void test_api_null_checks(void)
+{
+    list_error_handler(error_handler);
+    list_query q = list_query_from(NULL);
+    TEST_CHECK(list_query_any(&q) == 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_query_count(&q) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
+    long value;
+    TEST_CHECK(list_query_first(&q, &value) == 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_query_to_list(&q) == NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_query_count(NULL) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_query_take(NULL, 1) == NULL);
+    check_error_status(not_in_error);
+}
+
+
+void test_stages(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 10000; ++i)
+        list_add(l, i);
+
+    long three = 3, ten = 10, limit = 100;
+    list_query q = list_query_from(l);
+    TEST_CHECK(list_query_count(&q) == 10000);
+
+    list_query_where(&q, is_multiple_of, &three);
+    TEST_CHECK(list_query_count(&q) == 3334);
+
+    list_query_take(list_query_skip(list_query_select(&q, times, &ten), 2), 5);
+    list* result = list_query_to_list(&q);
+    TEST_CHECK(list_size(result) == 5);
+    for (i = 0; i < 5; ++i)
+        TEST_CHECK(list_get(result, i) == (i + 2) * 30);
+    free_list(result);
+
+    //Queries can be run again.  
+    long first = 0;
+    TEST_CHECK(list_query_first(&q, &first) == 1);
+    TEST_CHECK(first == 60);
+    TEST_CHECK(list_query_count(&q) == 5);
+
+    list_query w = list_query_from(l);
+    list_query_take_while(&w, less_than, &limit);
+    TEST_CHECK(list_query_count(&w) == 100);
+    list_query_where(&w, is_multiple_of, &ten);
+    TEST_CHECK(list_query_count(&w) == 10);
+
+    list_query none = list_query_from(l);
+    list_query_take(&none, 0);
+    TEST_CHECK(list_query_any(&none) == 0);
+    TEST_CHECK(list_query_first(&none, &first) == 0);
+    result = list_query_to_list(&none);
+    TEST_CHECK(list_size(result) == 0);
+    free_list(result);
+
+    list* empty = new_list();
+    list_query e = list_query_from(empty);
+    TEST_CHECK(list_query_any(&e) == 0);
+    TEST_CHECK(list_query_count(&e) == 0);
+
+    //The list itself is unchanged.  
+    TEST_CHECK(list_size(l) == 10000);
+    TEST_CHECK(list_get(l, 9999) == 9999);
+
+    check_error_status(not_in_error);
+    free_list(empty);
+    free_list(l);
+}
+
+
+void test_walk_stops_early(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 10000; ++i)
+        list_add(l, i);
+
+    long calls = 0, limit = 10;
+    list_query q = list_query_from(l);
+    list_query_take(list_query_where(&q, count_calls, &calls), 50);
+    TEST_CHECK(list_query_count(&q) == 50);
+    TEST_CHECK(calls == 50);
+
+    calls = 0;
+    TEST_CHECK(list_query_any(&q) == 1);
+    TEST_CHECK(calls == 1);
+
+    calls = 0;
+    list_query w = list_query_from(l);
+    list_query_where(list_query_take_while(&w, less_than, &limit), count_calls, &calls);
+    TEST_CHECK(list_query_count(&w) == 10);
+    TEST_CHECK(calls == 10);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+
+void test_too_many_stages(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    list_add(l, 1);
+
+    list_query q = list_query_from(l);
+    unsigned i = 0;
+    for (; i < LIST_QUERY_MAX_STAGES; ++i)
+        list_query_skip(&q, 0);
+    check_error_status(not_in_error);
+    TEST_CHECK(list_query_count(&q) == 1);
+
+    list_query_skip(&q, 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_query_count(&q) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
+
+    free_list(l);
+}
+
+
+TEST_LIST = {
+    {"API functions have null list checks", test_api_null_checks},
+    {"Query stages", test_stages},
+    {"Terminals stop walking the list early", test_walk_stops_early},
+    {"Too many query stages is an error", test_too_many_stages},
+    {NULL, NULL}
+};
@@ -9,6 +9,7 @@
 
 
 #include <stdbool.h>
+#include <limits.h>
 #include "../../acutest/include/acutest.h"
 
 #define LIST_DATA_TYPE long
@@ -98,6 +99,18 @@ void test_api_null_checks(void)
     TEST_CHECK(list_get(NULL, 0) == ERROR_RETURN_VALUE);
     check_error_status(in_error);
 
+    TEST_CHECK(list_get_const(NULL, 0) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+
+    TEST_CHECK(list_get_ref(NULL, 0) == NULL);
+    check_error_status(in_error);
+
+    list_set(NULL, 0, 0);
+    check_error_status(in_error);
+
+    TEST_CHECK(list_emplace_back(NULL) == NULL);
+    check_error_status(in_error);
+
     list_insert(NULL, 0, 0);
     check_error_status(in_error);
 
@@ -106,6 +119,14 @@ void test_api_null_checks(void)
 
     sort_list(NULL);
     check_error_status(in_error);
+    TEST_CHECK(list_lower_bound(NULL, 0) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_upper_bound(NULL, 0) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_contains_sorted(NULL, 0) == 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_insert_sorted(NULL, 0) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
 
     TEST_CHECK(list_where(NULL, NULL) == NULL);
     check_error_status(in_error);
@@ -119,6 +140,50 @@ void test_api_null_checks(void)
     TEST_CHECK(list_split_where(NULL, NULL) == NULL);
     check_error_status(in_error);
 
+    list_retain(NULL, NULL);
+    check_error_status(in_error);
+    list_remove_where(NULL, NULL);
+    check_error_status(in_error);
+
+    list_add_range(NULL, l, 0, 0);
+    check_error_status(in_error);
+    list_add_range(l, NULL, 0, 0);
+    check_error_status(in_error);
+    list_remove_range(NULL, 0, 0);
+    check_error_status(in_error);
+    list_copy_range(NULL, l, 0, 0);
+    check_error_status(in_error);
+    TEST_CHECK(copy_list(NULL) == NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_as_array(NULL) == NULL);
+    check_error_status(in_error);
+    TEST_CHECK(array_as_list(NULL, 1) == NULL);
+    check_error_status(in_error);
+
+    TEST_CHECK(list_trim_pool(NULL) == 0);
+    check_error_status(in_error);
+
+    list_push_front(NULL, 0);
+    check_error_status(in_error);
+
+    TEST_CHECK(list_pop_front(NULL) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+
+    list_cursor c = list_cursor_at(NULL, 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_cursor_next(&c) == 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_cursor_prev(NULL) == 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_cursor_get(&c) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+    list_cursor_set(NULL, 0);
+    check_error_status(in_error);
+    list_cursor_insert_before(&c, 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_cursor_remove_here(NULL) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+
     free_list(l);
 }
 
@@ -1374,6 +1439,1125 @@ void test_split_where(void)
 }
 
 
+lindex pool_free_count(_node_pool* pool)
+{
+    lindex count = 0;
+    _node* n = pool->free_nodes;
+    for (; n != NULL; n = n->next)
+        ++count;
+    return count;
+}
+
+void test_pooled_list_recycles_nodes(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_pooled_list(100);
+    TEST_ASSERT(l != NULL);
+    TEST_CHECK(l->pool != NULL);
+    TEST_CHECK(l->pool->slab_size == 100);
+
+    int i = 0;
+    for (; i < 1000; ++i)
+        list_add(l, i);
+    TEST_CHECK(l->pool->slab_count == 10);
+    for (i = 0; i < 1000; ++i)
+        TEST_CHECK(list_get(l, i) == i);
+
+    //Removed nodes go back to the pool and are reused before new slabs.  
+    for (i = 0; i < 500; ++i)
+        list_remove(l, 0);
+    TEST_CHECK(pool_free_count(l->pool) == 500);
+    for (i = 0; i < 500; ++i)
+        list_insert(l, 0, 499 - i);
+    TEST_CHECK(pool_free_count(l->pool) == 0);
+    TEST_CHECK(l->pool->slab_count == 10);
+    for (i = 0; i < 1000; ++i)
+        TEST_CHECK(list_get(l, i) == i);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+void test_pool_trim(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_pooled_list(0);
+    TEST_ASSERT(l != NULL);
+    TEST_CHECK(l->pool->slab_size == DEFAULT_SLAB_SIZE);
+    TEST_CHECK(list_trim_pool(l) == 0);
+
+    int i = 0;
+    for (; i < 4 * DEFAULT_SLAB_SIZE; ++i)
+        list_add(l, i);
+    TEST_CHECK(l->pool->slab_count == 4);
+    TEST_CHECK(list_trim_pool(l) == 0);
+
+    //Free the newest two slabs' worth of nodes.  
+    for (i = 0; i < 2 * DEFAULT_SLAB_SIZE; ++i)
+        list_pop(l);
+    TEST_CHECK(list_trim_pool(l) == 2);
+    TEST_CHECK(l->pool->slab_count == 2);
+    TEST_CHECK(pool_free_count(l->pool) == 0);
+    for (i = 0; i < 2 * DEFAULT_SLAB_SIZE; ++i)
+        TEST_CHECK(list_get(l, i) == i);
+
+    //Nodes spread over slabs keep them alive.  
+    list_remove(l, 0);
+    TEST_CHECK(list_trim_pool(l) == 0);
+
+    while (list_size(l) > 0)
+        list_pop(l);
+    TEST_CHECK(list_trim_pool(l) == 2);
+    TEST_CHECK(l->pool->slabs == NULL);
+    TEST_CHECK(l->pool->free_nodes == NULL);
+
+    list_add(l, 7);
+    TEST_CHECK(list_get(l, 0) == 7);
+    TEST_CHECK(l->pool->slab_count == 1);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+void test_pooled_split_and_where_share_pool(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_pooled_list(64);
+    int i = 0;
+    for (; i < 1000; ++i)
+        list_add(l, i);
+
+    list* second_half = list_split(l, 500);
+    list* small = list_where(l, filter1to10);
+    list* moved = list_split_where(second_half, lessthan500);
+    TEST_CHECK(second_half->pool == l->pool);
+    TEST_CHECK(small->pool == l->pool);
+    TEST_CHECK(moved->pool == l->pool);
+    TEST_CHECK(l->pool->refs == 4);
+
+    //Freeing the original list first must leave the others usable.  
+    free_list(l);
+    TEST_CHECK(small->pool->refs == 3);
+    TEST_CHECK(list_size(small) == 10);
+    TEST_CHECK(list_get(small, 9) == 10);
+    TEST_CHECK(list_get(second_half, 499) == 999);
+    TEST_CHECK(list_size(moved) == 0);
+
+    check_error_status(not_in_error);
+    free_list(small);
+    free_list(moved);
+    free_list(second_half);
+}
+
+void test_merge_across_pools(void)
+{
+    list_error_handler(error_handler);
+    list* pooled1 = new_pooled_list(16);
+    list* pooled2 = new_pooled_list(16);
+    list* heap = new_list();
+
+    int i = 0;
+    for (; i < 100; ++i)
+    {
+        list_add(pooled1, i);
+        list_add(pooled2, i + 100);
+        list_add(heap, i + 200);
+    }
+    list_remove(pooled2, 0);
+    list_insert(pooled2, 0, 100);
+
+    //Unshared pool is absorbed whole.  
+    _node_pool* pool = pooled1->pool;
+    list_merge(pooled1, pooled2);
+    TEST_CHECK(pooled1->pool == pool);
+    TEST_CHECK(pool->slab_count == 14);
+
+    //Heap nodes are copied into the pool.  
+    list_merge(pooled1, heap);
+    TEST_CHECK(list_size(pooled1) == 300);
+    for (i = 0; i < 300; ++i)
+        TEST_CHECK(list_get(pooled1, i) == i);
+
+    //Pooled nodes are copied onto the heap.  
+    heap = new_list();
+    list_add(heap, -1);
+    list* split = list_split(pooled1, 150);
+    list_merge(heap, split);
+    TEST_CHECK(heap->pool == NULL);
+    TEST_CHECK(list_size(heap) == 151);
+    TEST_CHECK(list_get(heap, 150) == 299);
+    TEST_CHECK(pool->refs == 1);
+
+    free_list(pooled1);
+    check_error_status(not_in_error);
+    free_list(heap);
+}
+
+void test_move_node_across_pools(void)
+{
+    list_error_handler(error_handler);
+    list* pooled = new_pooled_list(8);
+    list* heap = new_list();
+    int i = 0;
+    for (; i < 10; ++i)
+        list_add(pooled, i);
+
+    _move_node(pooled, heap, _list_pointer_at(pooled, 3), 3);
+    _move_node(pooled, heap, pooled->head, 0);
+    TEST_CHECK(list_size(pooled) == 8);
+    TEST_CHECK(pool_free_count(pooled->pool) == 2);
+    TEST_CHECK(list_get(heap, 0) == 3);
+    TEST_CHECK(list_get(heap, 1) == 0);
+    TEST_CHECK(list_get(pooled, 0) == 1);
+    TEST_CHECK(list_get(pooled, 2) == 4);
+
+    _move_node(heap, pooled, heap->tail, 1);
+    TEST_CHECK(list_size(heap) == 1);
+    TEST_CHECK(pool_free_count(pooled->pool) == 1);
+    TEST_CHECK(pooled->tail->value == 0);
+
+    check_error_status(not_in_error);
+    free_list(pooled);
+    free_list(heap);
+}
+
+
+/*
+Checks that every jump_table entry that isn't marked out of date refers to the
+node at its index, or is NULL if that index is outside the list.  
+*/
+void check_jump_table(list* l)
+{
+    _node* current = l->head;
+    long index = 0;
+    lindex i = 0;
+    for (; i < l->jt_size && i < l->jt_stale_from; ++i)
+    {
+        long jt_index = _jt_index_of(l, i);
+        if (jt_index < 0 || jt_index >= (long)l->size)
+        {
+            TEST_ASSERT(l->jump_table[i] == NULL);
+            continue;
+        }
+
+        for (; index < jt_index; ++index)
+            current = current->next;
+        TEST_ASSERT(l->jump_table[i] == current);
+    }
+}
+
+void test_push_front_pop_front(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+
+    long i = 0;
+    for (; i < 5000; ++i)
+        list_push_front(l, 4999 - i);
+    TEST_CHECK(list_size(l) == 5000);
+    for (i = 0; i < 5000; ++i)
+        TEST_CHECK(list_get(l, i) == i);
+    check_jump_table(l);
+
+    //Existing entries are left alone by further pushes.  
+    _node* first_entry = l->jump_table[l->jt_offset / JT_INCREMENT];
+    list_push_front(l, -1);
+    TEST_CHECK(l->jump_table[(l->jt_offset + 1) / JT_INCREMENT] == first_entry);
+    check_jump_table(l);
+
+    for (i = -1; i < 2500; ++i)
+        TEST_CHECK(list_pop_front(l) == i);
+    TEST_CHECK(list_get(l, 0) == 2500);
+    TEST_CHECK(l->head->value == 2500);
+    check_jump_table(l);
+
+    //Back operations work with the shifted table.  
+    for (i = 5000; i < 7000; ++i)
+        list_add(l, i);
+    for (i = 0; i < 4500; ++i)
+        TEST_CHECK(list_get(l, i) == i + 2500);
+    TEST_CHECK(list_pop(l) == 6999);
+    list_insert(l, 10, -10);
+    TEST_CHECK(list_remove(l, 10) == -10);
+    check_jump_table(l);
+
+    while (list_size(l) > 0)
+        list_pop_front(l);
+    TEST_CHECK(l->head == NULL);
+    TEST_CHECK(list_pop_front(l) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+
+    list_push_front(l, 1);
+    TEST_CHECK(list_get(l, 0) == 1);
+    TEST_CHECK(l->tail->value == 1);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+void test_deque_battery(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long* expected = (long*)malloc(40000 * sizeof(long));
+    lindex n = 0;
+
+    int i = 0;
+    for (; i < 40000; ++i)
+    {
+        long value = rand();
+        int op = rand() % 8;
+        if (n == 0 || op < 3)
+        {
+            list_push_front(l, value);
+            memmove(&expected[1], expected, n * sizeof(long));
+            expected[0] = value;
+            ++n;
+        }
+        else if (op < 5)
+        {
+            list_add(l, value);
+            expected[n++] = value;
+        }
+        else if (op == 5)
+        {
+            TEST_CHECK(list_pop_front(l) == expected[0]);
+            memmove(expected, &expected[1], --n * sizeof(long));
+        }
+        else if (op == 6)
+            TEST_CHECK(list_pop(l) == expected[--n]);
+        else
+        {
+            lindex index = rand() % n;
+            TEST_CHECK(list_get(l, index) == expected[index]);
+        }
+
+        if (i % 4000 == 0)
+            check_jump_table(l);
+    }
+
+    sort_list(l);
+    check_jump_table(l);
+    list* second = list_split(l, n / 2);
+    check_jump_table(l);
+    list_merge(l, second);
+    check_jump_table(l);
+    TEST_CHECK(list_size(l) == n);
+
+    check_error_status(not_in_error);
+    free(expected);
+    free_list(l);
+}
+
+void test_sort_is_stable(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    _node** order = (_node**)malloc(20000 * sizeof(_node*));
+
+    //Front pushes shift the table and a cursor remove leaves it stale.  
+    long i = 0;
+    for (; i < 20001; ++i)
+        list_push_front(l, i % 7);
+    list_cursor c = list_cursor_at(l, 5000);
+    list_cursor_remove_here(&c);
+    TEST_CHECK(l->jt_offset > 0);
+    TEST_CHECK(l->jt_stale_from != JT_ALL_VALID);
+
+    _node* current = l->head;
+    for (i = 0; i < 20000; ++i, current = current->next)
+        order[i] = current;
+    list_get(l, 12345);
+    _node* got = l->current;
+
+    sort_list(l);
+    TEST_CHECK(l->jt_stale_from == JT_ALL_VALID);
+    check_jump_table(l);
+    TEST_CHECK(l->current == got);
+    TEST_CHECK(list_get(l, l->current_index) == got->value);
+
+    //Nodes with equal values keep their original order.  
+    long key = 0;
+    _node* prev = NULL;
+    current = l->head;
+    for (; key < 7; ++key)
+    {
+        for (i = 0; i < 20000; ++i)
+        {
+            if (order[i]->value != key)
+                continue;
+            TEST_ASSERT(current == order[i]);
+            TEST_CHECK(current->prev == prev);
+            prev = current;
+            current = current->next;
+        }
+    }
+    TEST_CHECK(current == NULL);
+    TEST_CHECK(l->tail == prev);
+
+    check_error_status(not_in_error);
+    free(order);
+    free_list(l);
+}
+
+/*
+Returns the index of the first value in 'values' that 'value' goes before, the
+way list_lower_bound() and list_upper_bound() do.  
+*/
+lindex linear_bound(const long* values, lindex n, long value, int upper)
+{
+    lindex i = 0;
+    while (i < n && (upper ? values[i] <= value : values[i] < value))
+        ++i;
+    return i;
+}
+
+void test_sorted_search(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long* values = (long*)malloc(12000 * sizeof(long));
+
+    TEST_CHECK(list_lower_bound(l, 5) == 0);
+    TEST_CHECK(list_upper_bound(l, 5) == 0);
+    TEST_CHECK(!list_contains_sorted(l, 5));
+
+    //Pushed to the front so the jump_table is offset.  
+    lindex i = 0;
+    for (; i < 12000; ++i)
+        values[i] = (i / 3) * 2;
+    for (i = 12000; i > 0; --i)
+        list_push_front(l, values[i-1]);
+
+    for (i = 0; i < 3000; ++i)
+    {
+        long value = rand() % 8100 - 50;
+        lindex lower = list_lower_bound(l, value);
+        TEST_CHECK(lower == linear_bound(values, 12000, value, 0));
+        TEST_CHECK(list_upper_bound(l, value) == linear_bound(values, 12000, value, 1));
+        TEST_CHECK(list_contains_sorted(l, value) ==
+                   (value >= 0 && value <= 7998 && value % 2 == 0));
+        if (lower < 12000)
+            TEST_CHECK(list_get(l, lower) == values[lower]);
+    }
+    TEST_CHECK(list_lower_bound(l, -1) == 0);
+    TEST_CHECK(list_upper_bound(l, 7998) == 12000);
+
+    check_error_status(not_in_error);
+    free(values);
+    free_list(l);
+}
+
+void test_insert_sorted(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+
+    lindex i = 0;
+    for (; i < 20000; ++i)
+    {
+        long value = rand() % 5000;
+        lindex index = list_insert_sorted(l, value);
+        TEST_CHECK(list_get(l, index) == value);
+        //Inserted after any equal values.  
+        TEST_CHECK(index + 1 == list_size(l) || list_get(l, index + 1) > value);
+    }
+
+    _node* current = l->head->next;
+    for (; current != NULL; current = current->next)
+        TEST_CHECK(current->prev->value <= current->value);
+    check_jump_table(l);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+/*
+Checks the links, jump_table and values of 'l' against 'expected'.  
+*/
+void check_list(list* l, const long* expected, lindex n)
+{
+    TEST_ASSERT(list_size(l) == n);
+    _node* prev = NULL;
+    _node* current = l->head;
+    lindex i = 0;
+    for (; i < n; ++i, prev = current, current = current->next)
+    {
+        TEST_ASSERT(current->prev == prev);
+        TEST_ASSERT(current->value == expected[i]);
+    }
+    TEST_CHECK(current == NULL);
+    TEST_CHECK(l->tail == prev);
+    check_jump_table(l);
+    for (i = 0; i < n; i += 997)
+        TEST_CHECK(list_get(l, i) == expected[i]);
+}
+
+void test_add_and_remove_range(void)
+{
+    list_error_handler(error_handler);
+    list* l1 = new_list();
+    list* l2 = new_list();
+    long* expected1 = (long*)malloc(30000 * sizeof(long));
+    long* expected2 = (long*)malloc(30000 * sizeof(long));
+
+    long i = 0;
+    for (; i < 20000; ++i)
+    {
+        list_add(l1, i);
+        expected1[i] = i;
+    }
+    list_get(l1, 15000);
+
+    //Moved into an empty list.  
+    list_add_range(l1, l2, 5000, 17000);
+    memmove(expected2, &expected1[5000], 12000 * sizeof(long));
+    memmove(&expected1[5000], &expected1[17000], 3000 * sizeof(long));
+    check_list(l1, expected1, 8000);
+    check_list(l2, expected2, 12000);
+
+    //Appended to a list, and to the end of the same list.  
+    list_add_range(l1, l2, 0, 10);
+    memmove(&expected2[12000], expected1, 10 * sizeof(long));
+    memmove(expected1, &expected1[10], 7990 * sizeof(long));
+    list_add_range(l2, l2, 100, 200);
+    memmove(&expected2[12010], &expected2[100], 100 * sizeof(long));
+    memmove(&expected2[100], &expected2[200], 11910 * sizeof(long));
+    check_list(l1, expected1, 7990);
+    check_list(l2, expected2, 12010);
+
+    list_remove_range(l2, 11000, 12010);
+    list_remove_range(l2, 0, 1);
+    memmove(expected2, &expected2[1], 10999 * sizeof(long));
+    check_list(l2, expected2, 10999);
+
+    //Empty ranges do nothing, invalid ones are errors.  
+    list_remove_range(l2, 5, 5);
+    list_add_range(l1, l2, 7990, 7990);
+    check_error_status(not_in_error);
+    list_remove_range(l2, 6, 5);
+    check_error_status(in_error);
+    list_add_range(l1, l2, 0, 7991);
+    check_error_status(in_error);
+    check_list(l1, expected1, 7990);
+    check_list(l2, expected2, 10999);
+
+    //Whole lists.  
+    list_add_range(l1, l2, 0, 7990);
+    memmove(&expected2[10999], expected1, 7990 * sizeof(long));
+    check_list(l1, expected1, 0);
+    check_list(l2, expected2, 18989);
+    list_add(l1, -1);
+    TEST_CHECK(list_get(l1, 0) == -1);
+    list_remove_range(l2, 0, 18989);
+    TEST_CHECK(l2->head == NULL && l2->tail == NULL);
+    list_add(l2, -2);
+    TEST_CHECK(list_get(l2, 0) == -2);
+
+    check_error_status(not_in_error);
+    free(expected1);
+    free(expected2);
+    free_list(l1);
+    free_list(l2);
+}
+
+void test_range_across_pools(void)
+{
+    list_error_handler(error_handler);
+    list* pooled = new_pooled_list(64);
+    list* heap = new_list();
+    long expected[3000];
+
+    long i = 0;
+    for (; i < 3000; ++i)
+    {
+        list_add(pooled, i);
+        expected[i] = i;
+    }
+
+    //Nodes are copied into the other allocator.  
+    list_add_range(pooled, heap, 1000, 2000);
+    check_list(heap, &expected[1000], 1000);
+    memmove(&expected[1000], &expected[2000], 1000 * sizeof(long));
+    check_list(pooled, expected, 2000);
+    list_add_range(heap, pooled, 0, 1000);
+    TEST_CHECK(list_size(heap) == 0);
+    TEST_CHECK(list_get(pooled, 2999) == 1999);
+
+    list* copy = copy_list(pooled);
+    TEST_CHECK(copy->pool == pooled->pool);
+    list_copy_range(pooled, heap, 0, 3000);
+    for (i = 0; i < 3000; ++i)
+        TEST_CHECK(list_get(copy, i) == list_get(heap, i));
+
+    check_error_status(not_in_error);
+    free_list(copy);
+    free_list(pooled);
+    free_list(heap);
+}
+
+void test_copies_and_arrays(void)
+{
+    list_error_handler(error_handler);
+    long* values = (long*)malloc(25000 * sizeof(long));
+    long i = 0;
+    for (; i < 25000; ++i)
+        values[i] = rand();
+
+    //Large enough to need a bigger jump_table than a new list has.  
+    list* l = array_as_list(values, 25000);
+    check_list(l, values, 25000);
+    list* copy = copy_list(l);
+    check_list(copy, values, 25000);
+    TEST_CHECK(copy->head != l->head);
+
+    list_copy_range(l, copy, 24000, 25000);
+    list_copy_range(copy, copy, 0, 10);
+    TEST_CHECK(list_size(copy) == 26010);
+    TEST_CHECK(list_get(copy, 25000) == values[24000]);
+    TEST_CHECK(list_get(copy, 26009) == values[9]);
+
+    long* arr = list_as_array(l);
+    TEST_CHECK(memcmp(arr, values, 25000 * sizeof(long)) == 0);
+    free(arr);
+
+    list* empty = array_as_list(NULL, 0);
+    TEST_CHECK(list_size(empty) == 0);
+    arr = list_as_array(empty);
+    TEST_CHECK(arr != NULL);
+    free(arr);
+    list* empty_copy = copy_list(empty);
+    TEST_CHECK(list_size(empty_copy) == 0);
+
+    check_error_status(not_in_error);
+    free(values);
+    free_list(empty_copy);
+    free_list(empty);
+    free_list(copy);
+    free_list(l);
+}
+
+void test_merge_into_empty_and_large_split(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 30000; ++i)
+        list_add(l, i);
+
+    //The new list needs more than INITIAL_JT_SIZE entries.  
+    list* second = list_split(l, 1);
+    TEST_CHECK(list_size(second) == 29999);
+    for (i = 0; i < 29999; i += 101)
+        TEST_CHECK(list_get(second, i) == i + 1);
+    check_jump_table(second);
+
+    list* empty = new_list();
+    list_merge(empty, second);
+    TEST_CHECK(list_size(empty) == 29999);
+    TEST_CHECK(empty->head->value == 1 && empty->tail->value == 29999);
+    check_jump_table(empty);
+    list_merge(empty, l);
+    TEST_CHECK(list_get(empty, 29999) == 0);
+
+    check_error_status(not_in_error);
+    free_list(empty);
+}
+
+int is_multiple_of_3(long x)
+{
+    return x % 3 == 0;
+}
+
+int is_even(long x)
+{
+    return x % 2 == 0;
+}
+
+void test_large_split_where_and_retain(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 100000; ++i)
+        list_push_front(l, 99999 - i);
+    list_get(l, 50000);
+
+    long* expected = (long*)malloc(100000 * sizeof(long));
+    list* thirds = list_split_where(l, is_multiple_of_3);
+    //The cached node is kept if it stays in the list.  
+    TEST_CHECK(l->current != NULL && l->current->value == 50000);
+    TEST_CHECK(l->current_index == 33333);
+    for (i = 0; i < 33334; ++i)
+        expected[i] = 3 * i;
+    check_list(thirds, expected, 33334);
+    lindex n = 0;
+    for (i = 0; i < 100000; ++i)
+        if (i % 3 != 0)
+            expected[n++] = i;
+    check_list(l, expected, n);
+
+    //Keep the values 1 to 10.  
+    list_retain(l, filter1to10);
+    long small[] = {1, 2, 4, 5, 7, 8, 10};
+    check_list(l, small, 7);
+    list_remove_where(l, is_even);
+    long odd[] = {1, 5, 7};
+    check_list(l, odd, 3);
+    list_add(l, 11);
+    TEST_CHECK(list_get(l, 3) == 11);
+
+    list_remove_where(thirds, filter1to10);
+    TEST_CHECK(list_size(thirds) == 33331);
+    TEST_CHECK(list_get(thirds, 0) == 0 && list_get(thirds, 1) == 12);
+    list_retain(thirds, filter1to10);
+    TEST_CHECK(list_size(thirds) == 0);
+    TEST_CHECK(thirds->head == NULL && thirds->tail == NULL);
+    check_jump_table(thirds);
+    list_add(thirds, 5);
+    TEST_CHECK(list_get(thirds, 0) == 5);
+
+    list* none = list_split_where(thirds, is_even);
+    TEST_CHECK(list_size(none) == 0);
+    TEST_CHECK(list_size(thirds) == 1);
+
+    check_error_status(not_in_error);
+    free(expected);
+    free_list(none);
+    free_list(thirds);
+    free_list(l);
+}
+
+void test_natural_merge_sort(void)
+{
+    lindex n = 20000;
+    _sort_entry* entries = (_sort_entry*)malloc(2 * n * sizeof(_sort_entry));
+
+    //Sorted, sorted with a new tail, descending, sawtooth and few values.  
+    int kind = 0;
+    for (; kind < 5; ++kind)
+    {
+        lindex i = 0;
+        for (; i < n; ++i)
+        {
+            long value = rand() % 5;
+            if (kind == 0)
+                value = i / 3;
+            else if (kind == 1)
+                value = i < n - 500 ? (long)i : rand() % (long)n;
+            else if (kind == 2)
+                value = n - i / 2;
+            else if (kind == 3)
+                value = (i / 100) % 2 ? (long)(n - i) : (long)i;
+            entries[i].value = value;
+            //Remembers the original position.  
+            entries[i].node = (_node*)(entries + i);
+        }
+
+        _merge_sort_entries(entries, entries + n, n);
+        for (i = 1; i < n; ++i)
+        {
+            TEST_ASSERT(entries[i-1].value <= entries[i].value);
+            if (entries[i-1].value == entries[i].value)
+                TEST_ASSERT(entries[i-1].node < entries[i].node);
+        }
+    }
+
+    free(entries);
+}
+
+void test_radix_keys_keep_order(void)
+{
+    TEST_CHECK(_RADIX_SORTABLE);
+
+    //Keys of every width order like the values they come from.  
+    TEST_CHECK(_radix_key_signed(-128, 8) == 0);
+    TEST_CHECK(_radix_key_signed(-1, 8) == 127);
+    TEST_CHECK(_radix_key_signed(0, 8) == 128);
+    TEST_CHECK(_radix_key_signed(127, 8) == 255);
+    TEST_CHECK(_radix_key_signed(-32768, 16) == 0);
+    TEST_CHECK(_radix_key_signed(32767, 16) == 65535);
+    TEST_CHECK(_radix_key_signed(-1, 32) < _radix_key_signed(0, 32));
+    TEST_CHECK(_radix_key_signed(-2147483647 - 1, 32) == 0);
+    TEST_CHECK(_radix_key_signed(LLONG_MIN, 64) == 0);
+    TEST_CHECK(_radix_key_signed(LLONG_MAX, 64) == ~0ULL);
+    TEST_CHECK(_radix_key_unsigned(ULLONG_MAX, 64) > _radix_key_unsigned(0, 64));
+    TEST_CHECK(_radix_key_char(-1, 8) < _radix_key_char(1, 8) || (char)-1 > 0);
+}
+
+void test_radix_sort_signed_values(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 50000; ++i)
+        list_add(l, ((long)rand() << 32 | rand()) - LONG_MAX / 2);
+    list_add(l, LONG_MIN);
+    list_add(l, LONG_MAX);
+    list_add(l, -1);
+    list_add(l, 0);
+
+    sort_list(l);
+    TEST_CHECK(list_get(l, 0) == LONG_MIN);
+    TEST_CHECK(list_get(l, 50003) == LONG_MAX);
+    _node* current = l->head->next;
+    for (; current != NULL; current = current->next)
+        TEST_CHECK(current->prev->value <= current->value);
+    check_jump_table(l);
+
+    //Only the low digit differs.  
+    list* small = new_list();
+    for (i = 0; i < 3000; ++i)
+        list_add(small, 1000000 + (i * 7) % 256);
+    sort_list(small);
+    for (i = 1; i < 3000; ++i)
+        TEST_CHECK(list_get(small, i - 1) <= list_get(small, i));
+
+    check_error_status(not_in_error);
+    free_list(small);
+    free_list(l);
+}
+
+void test_queue_reuses_jump_table(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 5000; ++i)
+        list_add(l, i);
+
+    //Entries freed at the front are reused at the back.  
+    for (; i < 1000000; ++i)
+    {
+        list_add(l, i);
+        TEST_ASSERT(list_pop_front(l) == i - 5000);
+    }
+    TEST_CHECK(l->jt_size == INITIAL_JT_SIZE);
+    check_jump_table(l);
+    for (i = 0; i < 5000; ++i)
+        TEST_CHECK(list_get(l, i) == 995000 + i);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+
+void test_cursor_walk(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 3000; ++i)
+        list_add(l, i);
+
+    list_cursor c = list_cursor_at(l, 0);
+    for (i = 0; i < 3000; ++i)
+    {
+        TEST_CHECK(c.index == (lindex)i);
+        TEST_CHECK(list_cursor_get(&c) == i);
+        list_cursor_set(&c, i * 2);
+        TEST_CHECK(list_cursor_next(&c) == (i < 2999));
+    }
+
+    //Past the end.  
+    TEST_CHECK(list_cursor_next(&c) == 0);
+    TEST_CHECK(list_cursor_get(&c) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+
+    for (i = 2999; i >= 0; --i)
+    {
+        TEST_CHECK(list_cursor_prev(&c) == 1);
+        TEST_CHECK(list_cursor_get(&c) == i * 2);
+    }
+    TEST_CHECK(list_cursor_prev(&c) == 0);
+    TEST_CHECK(c.index == 0);
+
+    c = list_cursor_at(l, 3000);
+    TEST_CHECK(c.node == NULL);
+    c = list_cursor_at(l, 3001);
+    check_error_status(in_error);
+    TEST_CHECK(c.l == NULL);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+void test_cursor_edits(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 10000; ++i)
+        list_add(l, i);
+
+    //Double every even value and drop every odd one in a single pass.  
+    list_cursor c = list_cursor_at(l, 0);
+    while (c.node != NULL)
+    {
+        long value = list_cursor_get(&c);
+        if (value % 2)
+            TEST_CHECK(list_cursor_remove_here(&c) == value);
+        else
+        {
+            list_cursor_insert_before(&c, value);
+            list_cursor_next(&c);
+        }
+    }
+    TEST_CHECK(list_size(l) == 10000);
+    TEST_CHECK(c.index == 10000);
+    check_jump_table(l);
+
+    //Lookups bring the table back up to date.  
+    for (i = 0; i < 10000; ++i)
+        TEST_CHECK(list_get(l, i) == i - i % 2);
+    lindex stale_from = l->jt_stale_from;
+    TEST_CHECK(stale_from > _jt_entry_of(l, 9999));
+    check_jump_table(l);
+
+    //Appending through a cursor at the end invalidates nothing.  
+    c = list_cursor_at(l, 10000);
+    for (i = 0; i < 2000; ++i)
+        list_cursor_insert_before(&c, -1);
+    TEST_CHECK(l->jt_stale_from == stale_from);
+    TEST_CHECK(list_size(l) == 12000);
+    _list_repair_jump_table(l, l->jt_size);
+    TEST_CHECK(l->jt_stale_from == JT_ALL_VALID);
+    check_jump_table(l);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+void test_get_const(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 10000; ++i)
+        list_push_front(l, 9999 - i);
+
+    //Leave part of the jump_table out of date.  
+    list_cursor c = list_cursor_at(l, 4321);
+    list_cursor_remove_here(&c);
+    list_cursor_insert_before(&c, 4321);
+    list_get(l, 5000);
+    _node* current = l->current;
+    lindex stale_from = l->jt_stale_from;
+    TEST_CHECK(stale_from != JT_ALL_VALID);
+    for (i = 0; i < 10000; ++i)
+    {
+        long index = (i * 7919) % 10000;
+        TEST_CHECK(list_get_const(l, index) == index);
+    }
+    TEST_CHECK(list_get_const(l, 10000) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+
+    //Nothing about the list changed.  
+    TEST_CHECK(l->current == current);
+    TEST_CHECK(l->current_index == 5000);
+    TEST_CHECK(l->jt_stale_from == stale_from);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+void test_add_and_drain_pending(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    TEST_CHECK(list_drain_pending(l) == 0);
+
+    long i = 0;
+    for (; i < 1000; ++i)
+        list_add(l, i);
+    for (; i < 3000; ++i)
+        list_add_pending(l, i);
+    //Staged values are not in the list yet.  
+    TEST_CHECK(list_size(l) == 1000);
+    TEST_CHECK(list_drain_pending(l) == 2000);
+    TEST_CHECK(list_size(l) == 3000);
+    for (i = 0; i < 3000; ++i)
+        TEST_CHECK(list_get(l, i) == i);
+    check_jump_table(l);
+    TEST_CHECK(l->pending == NULL);
+
+    //Into an empty, pooled list.  
+    list* pooled = new_pooled_list(16);
+    for (i = 0; i < 100; ++i)
+        list_add_pending(pooled, i);
+    TEST_CHECK(list_drain_pending(pooled) == 100);
+    for (i = 0; i < 100; ++i)
+        TEST_CHECK(list_get(pooled, i) == i);
+    check_jump_table(pooled);
+
+    //Merging drains the second list first.  
+    list_add_pending(pooled, 100);
+    list_merge(l, pooled);
+    TEST_CHECK(list_size(l) == 3101);
+    TEST_CHECK(list_get(l, 3100) == 100);
+
+    //Undrained values are freed with the list.  
+    list_add_pending(l, -1);
+    list_add_pending(NULL, 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_drain_pending(NULL) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+void test_refs_set_and_emplace_back(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_pooled_list(64);
+    long i = 0;
+    for (; i < 5000; ++i)
+        *list_emplace_back(l) = i;
+    TEST_CHECK(list_size(l) == 5000);
+    check_jump_table(l);
+
+    //References stay valid while other values are looked up.  
+    long* ref = list_get_ref(l, 1234);
+    TEST_CHECK(*ref == 1234);
+    list_get(l, 4000);
+    *ref = -1;
+    TEST_CHECK(list_get(l, 1234) == -1);
+
+    list_set(l, 4999, -2);
+    TEST_CHECK(list_pop(l) == -2);
+    for (i = 0; i < 4999; ++i)
+        *list_get_ref(l, i) *= 2;
+    TEST_CHECK(list_get(l, 4998) == 9996);
+    TEST_CHECK(list_get_const(l, 1234) == -2);
+
+    long* slot = list_emplace_back(l);
+    TEST_CHECK(*slot == 0);
+    TEST_CHECK(list_get_ref(l, 4999) == slot);
+
+    TEST_CHECK(list_get_ref(l, 5000) == NULL);
+    check_error_status(in_error);
+    list_set(l, 5000, 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_size(l) == 5000);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+void test_try_get_and_unchecked(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 3000; ++i)
+        list_add_unchecked(l, i);
+    TEST_CHECK(list_size(l) == 3000);
+    check_jump_table(l);
+
+    for (i = 0; i < 3000; ++i)
+        list_set_unchecked(l, i, list_get_unchecked(l, i) * 3);
+
+    long value = 0;
+    TEST_CHECK(list_try_get(l, 2999, &value) == LIST_OK);
+    TEST_CHECK(value == 8997);
+    TEST_CHECK(l->current_index == 2999);
+
+    //Errors are only reported through the return code.  
+    value = 5;
+    TEST_CHECK(list_try_get(l, 3000, &value) == LIST_INDEX_OUT_OF_RANGE);
+    TEST_CHECK(list_try_get(NULL, 0, &value) == LIST_NULL_ARG);
+    TEST_CHECK(list_try_get(l, 0, NULL) == LIST_NULL_ARG);
+    TEST_CHECK(value == 5);
+    check_error_status(not_in_error);
+
+    for (i = 0; i < 3000; ++i)
+        TEST_CHECK(list_get_const(l, i) == i * 3);
+
+    free_list(l);
+}
+
+void test_cursor_battery(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long* expected = (long*)malloc(20000 * sizeof(long));
+    lindex n = 0;
+    list_cursor c = list_cursor_at(l, 0);
+
+    int i = 0;
+    for (; i < 30000; ++i)
+    {
+        long value = rand();
+        int op = rand() % 10;
+        if (op < 3)
+        {
+            list_cursor_insert_before(&c, value);
+            memmove(&expected[c.index], &expected[c.index-1],
+                    (n - c.index + 1) * sizeof(long));
+            expected[c.index-1] = value;
+            ++n;
+        }
+        else if (op < 4 && c.index < n)
+        {
+            TEST_CHECK(list_cursor_remove_here(&c) == expected[c.index]);
+            memmove(&expected[c.index], &expected[c.index+1],
+                    (n - c.index - 1) * sizeof(long));
+            --n;
+        }
+        else if (op < 6)
+        {
+            if (rand() % 2)
+                list_cursor_next(&c);
+            else
+                list_cursor_prev(&c);
+        }
+        else if (op < 8 && n > 0)
+        {
+            //Other operations invalidate the cursor, so it is recreated.  
+            lindex index = rand() % n;
+            TEST_CHECK(list_get(l, index) == expected[index]);
+            if (op == 7)
+            {
+                list_insert(l, index, value);
+                memmove(&expected[index+1], &expected[index],
+                        (n - index) * sizeof(long));
+                expected[index] = value;
+                ++n;
+            }
+            c = list_cursor_at(l, rand() % (n + 1));
+        }
+        else if (op == 8)
+        {
+            list_add(l, value);
+            expected[n++] = value;
+            c = list_cursor_at(l, c.index);
+        }
+        else if (n > 0)
+        {
+            TEST_CHECK(list_pop_front(l) == expected[0]);
+            memmove(expected, &expected[1], --n * sizeof(long));
+            c = list_cursor_at(l, 0);
+        }
+
+        if (c.index < n)
+            TEST_CHECK(list_cursor_get(&c) == expected[c.index]);
+        if (i % 3000 == 0)
+            check_jump_table(l);
+    }
+
+    TEST_CHECK(list_size(l) == n);
+    lindex j = 0;
+    for (; j < n; ++j)
+        TEST_CHECK(list_get(l, j) == expected[j]);
+    check_jump_table(l);
+
+    check_error_status(not_in_error);
+    free(expected);
+    free_list(l);
+}
+
+
 TEST_LIST = {
     {"Constant values", test_constants},
     {"New list has correct intial values", test_new_list_intial_values},
@@ -1420,5 +2604,31 @@ TEST_LIST = {
     {"Split out of range is error", test_split_out_of_range},
     {"Split and merge", test_split_and_merge},
     {"Split where", test_split_where},
+    {"Pooled list recycles nodes", test_pooled_list_recycles_nodes},
+    {"Trimming idle pool slabs", test_pool_trim},
+    {"Lists made from pooled lists share the pool", test_pooled_split_and_where_share_pool},
+    {"Merge across pools", test_merge_across_pools},
+    {"Move node across pools", test_move_node_across_pools},
+    {"Push and pop at the front", test_push_front_pop_front},
+    {"Battery of random deque operations", test_deque_battery},
+    {"Queue use reuses jump table entries", test_queue_reuses_jump_table},
+    {"Walking a list with a cursor", test_cursor_walk},
+    {"Editing a list with a cursor", test_cursor_edits},
+    {"Reading without changing the list", test_get_const},
+    {"Battery of random cursor operations", test_cursor_battery},
+    {"list_try_get and unchecked functions", test_try_get_and_unchecked},
+    {"References, list_set and list_emplace_back", test_refs_set_and_emplace_back},
+    {"Staging values and draining them into the list", test_add_and_drain_pending},
+    {"list sorting - stable and keeps the jump table", test_sort_is_stable},
+    {"Natural mergesort of runs", test_natural_merge_sort},
+    {"Adding and removing ranges", test_add_and_remove_range},
+    {"Ranges across pools", test_range_across_pools},
+    {"Copies and arrays", test_copies_and_arrays},
+    {"Merge into an empty list and large splits", test_merge_into_empty_and_large_split},
+    {"Large split where, retain and remove where", test_large_split_where_and_retain},
+    {"Searching a sorted list", test_sorted_search},
+    {"Inserting into a sorted list", test_insert_sorted},
+    {"Radix keys keep value order", test_radix_keys_keep_order},
+    {"list sorting - signed values", test_radix_sort_signed_values},
     {NULL, NULL}
 };
@@ -0,0 +1,226 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_typed_test.c
+// Verifies correct behavior of clist_typed.h.  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdbool.h>
+#include "../../acutest/include/acutest.h"
+
+#define LIST_DATA_TYPE long
+#define ERROR_RETURN_VALUE -1
+
+#include "../include/clist_typed.h"
+
+
+typedef struct point
+{
+    double x;
+    double y;
+} point;
+
+static inline int long_less(long a, long b)
+{
+    return a < b;
+}
+
+static inline int double_greater(double a, double b)
+{
+    return a > b;
+}
+
+//Points are ordered by x only, so the order of equal x shows stability.  
+static inline int point_x_less(point a, point b)
+{
+    return a.x < b.x;
+}
+
+CLIST_DEFINE(longs, long, long_less)
+CLIST_DEFINE(doubles, double, double_greater)
+CLIST_DEFINE(points, point, point_x_less)
+
+
+bool ERROR_STATUS = false;
+
+bool not_in_error = false;
+bool in_error = true;
+
+void check_error_status(bool should_be_error)
+{
+    bool current = ERROR_STATUS;
+    ERROR_STATUS = false;
+    TEST_CHECK(current == should_be_error);
+}
+
+int error_handler(const char* func, const char* arg, const char* msg)
+{
+    ERROR_STATUS = true;
+    return 0;
+}
+
+/*
+Checks the links and up to date jump_table entries of 'l'.  
+*/
+void check_longs(longs_list* l)
+{
+    longs_node* prev = NULL;
+    longs_node* current = l->head;
+    lindex index = 0;
+    for (; current != NULL; prev = current, current = current->next, ++index)
+    {
+        TEST_ASSERT(current->prev == prev);
+        if (index % JT_INCREMENT == 0 && index / JT_INCREMENT < l->jt_valid)
+            TEST_ASSERT(l->jump_table[index / JT_INCREMENT] == current);
+    }
+    TEST_CHECK(l->tail == prev);
+    TEST_CHECK(index == l->size);
+}
+
+
+void test_api_null_checks(void)
+{
+    list_error_handler(error_handler);
+    TEST_CHECK(longs_size(NULL) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
+    longs_add(NULL, 0);
+    check_error_status(in_error);
+    longs_insert(NULL, 0, 0);
+    check_error_status(in_error);
+    TEST_CHECK(longs_get(NULL, 0) == 0);
+    check_error_status(in_error);
+    longs_set(NULL, 0, 0);
+    check_error_status(in_error);
+    TEST_CHECK(longs_remove(NULL, 0) == 0);
+    check_error_status(in_error);
+    TEST_CHECK(longs_pop(NULL) == 0);
+    check_error_status(in_error);
+    longs_sort(NULL);
+    check_error_status(in_error);
+    longs_free(NULL);
+}
+
+
+void test_operations(void)
+{
+    list_error_handler(error_handler);
+    longs_list* l = longs_new();
+    TEST_ASSERT(l != NULL);
+
+    long i = 0;
+    for (; i < 10000; ++i)
+        longs_add(l, i);
+    TEST_CHECK(longs_size(l) == 10000);
+    for (i = 0; i < 10000; ++i)
+        TEST_CHECK(longs_get(l, (i * 7919) % 10000) == (i * 7919) % 10000);
+    check_longs(l);
+
+    longs_insert(l, 0, -1);
+    longs_insert(l, 5001, -2);
+    longs_insert(l, longs_size(l), -3);
+    TEST_CHECK(longs_get(l, 0) == -1);
+    TEST_CHECK(longs_get(l, 5001) == -2);
+    TEST_CHECK(longs_get(l, 5002) == 5000);
+    TEST_CHECK(longs_get(l, 9999) == 9997);
+    TEST_CHECK(longs_get(l, 10002) == -3);
+    check_longs(l);
+
+    TEST_CHECK(longs_remove(l, 5001) == -2);
+    TEST_CHECK(longs_remove(l, 0) == -1);
+    TEST_CHECK(longs_pop(l) == -3);
+    longs_set(l, 2000, -4);
+    for (i = 0; i < 10000; ++i)
+        TEST_CHECK(longs_get(l, i) == (i == 2000 ? -4 : i));
+    check_longs(l);
+
+    TEST_CHECK(longs_get(l, 10000) == 0);
+    check_error_status(in_error);
+    longs_insert(l, 10001, 0);
+    check_error_status(in_error);
+
+    while (longs_size(l) > 0)
+        longs_pop(l);
+    TEST_CHECK(l->head == NULL && l->tail == NULL);
+    TEST_CHECK(longs_pop(l) == 0);
+    check_error_status(in_error);
+    longs_add(l, 1);
+    TEST_CHECK(longs_get(l, 0) == 1);
+
+    check_error_status(not_in_error);
+    longs_free(l);
+}
+
+
+void test_sort(void)
+{
+    list_error_handler(error_handler);
+    longs_list* l = longs_new();
+    long i = 0;
+    for (; i < 5000; ++i)
+        longs_add(l, (i * 7919) % 5000);
+    longs_get(l, 3000);
+    longs_sort(l);
+    for (i = 0; i < 5000; ++i)
+        TEST_CHECK(longs_get(l, i) == i);
+    check_longs(l);
+
+    doubles_list* d = doubles_new();
+    for (i = 0; i < 100; ++i)
+        doubles_add(d, i / 4.0);
+    doubles_sort(d);
+    for (i = 0; i < 100; ++i)
+        TEST_CHECK(doubles_get(d, i) == (99 - i) / 4.0);
+
+    points_list* p = points_new();
+    for (i = 0; i < 1000; ++i)
+    {
+        point pt = {(double)(i % 10), (double)i};
+        points_add(p, pt);
+    }
+    points_sort(p);
+    for (i = 0; i < 1000; ++i)
+    {
+        point pt = points_get(p, i);
+        TEST_CHECK(pt.x == i / 100);
+        TEST_CHECK(pt.y == (i % 100) * 10 + i / 100);
+    }
+
+    check_error_status(not_in_error);
+    points_free(p);
+    doubles_free(d);
+    longs_free(l);
+}
+
+
+void test_coexists_with_list(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    points_list* p = points_new();
+    long i = 0;
+    for (; i < 100; ++i)
+    {
+        point pt = {(double)i, -(double)i};
+        list_add(l, i);
+        points_add(p, pt);
+    }
+    for (i = 0; i < 100; ++i)
+        TEST_CHECK(list_get(l, i) == (long)points_get(p, i).x);
+
+    TEST_CHECK(points_get(p, 100).x == 0);
+    check_error_status(in_error);
+
+    check_error_status(not_in_error);
+    points_free(p);
+    free_list(l);
+}
+
+
+TEST_LIST = {
+    {"API functions have null list checks", test_api_null_checks},
+    {"Typed list operations", test_operations},
+    {"Sorting typed lists", test_sort},
+    {"Typed lists next to a list", test_coexists_with_list},
+    {NULL, NULL}
+};
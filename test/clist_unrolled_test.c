@@ -0,0 +1,610 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// clist_unrolled_test.c
+// Verifies correct behavior of clist.h with LIST_STORAGE_UNROLLED.  
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdbool.h>
+#include "../../acutest/include/acutest.h"
+
+#define LIST_DATA_TYPE long
+#define ERROR_RETURN_VALUE -1
+#define LIST_STORAGE LIST_STORAGE_UNROLLED
+
+#include "../include/clist.h"
+
+
+bool ERROR_STATUS = false;
+
+bool not_in_error = false;
+bool in_error = true;
+
+void check_error_status(bool should_be_error)
+{
+    bool current = ERROR_STATUS;
+    ERROR_STATUS = false;
+    TEST_CHECK(current == should_be_error);
+}
+
+int error_handler(const char* func, const char* arg, const char* msg)
+{
+    ERROR_STATUS = true;
+    return 0;
+}
+
+/*
+Checks the chunk chain and jump_table of 'l' against each other and,
+if 'expected' is not NULL, the list's values against 'expected'.  
+*/
+void check_structure(list* l, const long* expected)
+{
+    lindex start = 0, entry = 0;
+    _chunk* prev = NULL;
+    _chunk* c = l->head;
+    for (; c != NULL; prev = c, c = c->next)
+    {
+        TEST_ASSERT(c->prev == prev);
+        TEST_ASSERT(c->count > 0 && c->count <= LIST_CHUNK_CAPACITY);
+        if (entry < l->jt_count && l->jump_table[entry].chunk == c)
+        {
+            TEST_ASSERT(l->jump_table[entry].start == start);
+            ++entry;
+        }
+
+        unsigned i;
+        for (i = 0; expected && i < c->count; ++i)
+            TEST_ASSERT(c->values[i] == expected[start + i]);
+        start += c->count;
+    }
+
+    TEST_CHECK(l->tail == prev);
+    TEST_CHECK(start == l->size);
+    //Every entry refers to a chunk of the list, in order.  
+    TEST_CHECK(entry == l->jt_count);
+    if (l->size > 0)
+        TEST_CHECK(l->jump_table[0].chunk == l->head);
+}
+
+
+int filter1to10(long x)
+{
+    return x > 0 && x <= 10;
+}
+
+int is_even(long x)
+{
+    return x % 2 == 0;
+}
+
+int is_negative(long x)
+{
+    return x < 0;
+}
+
+
+void test_new_list_intial_values(void)
+{
+    list* l = new_list();
+    TEST_ASSERT(l != NULL);
+    TEST_CHECK(list_size(l) == 0);
+    TEST_CHECK(l->head == NULL);
+    TEST_CHECK(l->tail == NULL);
+    TEST_CHECK(l->jt_size == INITIAL_JT_SIZE);
+    TEST_CHECK(l->jt_count == 0);
+    free_list(l);
+}
+
+
+void test_api_null_checks(void)
+{
+    list_error_handler(error_handler);
+
+    TEST_CHECK(list_size(NULL) == (lindex)-1);
+    check_error_status(in_error);
+    list_add(NULL, 1);
+    check_error_status(in_error);
+    TEST_CHECK(list_pop(NULL) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_get(NULL, 0) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_get_const(NULL, 0) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_get_ref(NULL, 0) == NULL);
+    check_error_status(in_error);
+    list_set(NULL, 0, 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_emplace_back(NULL) == NULL);
+    check_error_status(in_error);
+    list_insert(NULL, 0, 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_remove(NULL, 0) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+    sort_list(NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_lower_bound(NULL, 0) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_upper_bound(NULL, 0) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_contains_sorted(NULL, 0) == 0);
+    check_error_status(in_error);
+    TEST_CHECK(list_insert_sorted(NULL, 0) == INDEX_ERR_RETURN_VALUE);
+    check_error_status(in_error);
+    TEST_CHECK(list_where(NULL, NULL) == NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_split(NULL, 0) == NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_split_where(NULL, NULL) == NULL);
+    check_error_status(in_error);
+    list_retain(NULL, NULL);
+    check_error_status(in_error);
+    list_remove_where(NULL, NULL);
+    check_error_status(in_error);
+    list_add_range(NULL, NULL, 0, 0);
+    check_error_status(in_error);
+    list_remove_range(NULL, 0, 0);
+    check_error_status(in_error);
+    list_copy_range(NULL, NULL, 0, 0);
+    check_error_status(in_error);
+    TEST_CHECK(copy_list(NULL) == NULL);
+    check_error_status(in_error);
+    TEST_CHECK(list_as_array(NULL) == NULL);
+    check_error_status(in_error);
+}
+
+
+void test_add_get_pop(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+
+    long i = 0;
+    for (; i < 10000; ++i)
+        list_add(l, i);
+    TEST_CHECK(list_size(l) == 10000);
+    //Appends fill chunks completely.  
+    TEST_CHECK(l->head->count == LIST_CHUNK_CAPACITY);
+    for (i = 0; i < 10000; ++i)
+        TEST_CHECK(list_get(l, i) == i);
+    for (i = 9999; i >= 0; i -= 7)
+        TEST_CHECK(list_get(l, i) == i);
+    check_structure(l, NULL);
+
+    TEST_CHECK(list_get(l, 10000) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+
+    for (i = 9999; i >= 0; --i)
+        TEST_CHECK(list_pop(l) == i);
+    TEST_CHECK(list_size(l) == 0);
+    TEST_CHECK(l->head == NULL);
+    TEST_CHECK(l->jt_count == 0);
+    TEST_CHECK(list_pop(l) == ERROR_RETURN_VALUE);
+    check_error_status(in_error);
+
+    free_list(l);
+}
+
+
+void test_random_insert_remove(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long* expected = (long*)malloc(40000 * sizeof(long));
+    lindex n = 0;
+
+    int i = 0;
+    for (; i < 30000; ++i)
+    {
+        long value = rand();
+        lindex index = n ? rand() % n : 0;
+        if (n > 0 && rand() % 3 == 0)
+        {
+            TEST_CHECK(list_remove(l, index) == expected[index]);
+            memmove(&expected[index], &expected[index+1],
+                    (n - index - 1) * sizeof(long));
+            --n;
+        }
+        else
+        {
+            list_insert(l, index, value);
+            memmove(&expected[index+1], &expected[index],
+                    (n - index) * sizeof(long));
+            expected[index] = value;
+            ++n;
+        }
+
+        if (i % 1000 == 0)
+            check_structure(l, expected);
+    }
+
+    TEST_CHECK(list_size(l) == n);
+    check_structure(l, expected);
+    lindex j = 0;
+    for (; j < n; ++j)
+    {
+        TEST_CHECK(list_get(l, j) == expected[j]);
+        TEST_CHECK(list_get_const(l, n - 1 - j) == expected[n - 1 - j]);
+    }
+
+    //Update every value in place, then fill a new slot.  
+    for (j = 0; j < n; ++j)
+        *list_get_ref(l, j) += 1;
+    list_set(l, 0, -5);
+    long* slot = list_emplace_back(l);
+    TEST_ASSERT(slot != NULL);
+    TEST_CHECK(*slot == 0);
+    *slot = 7;
+    TEST_CHECK(list_get(l, n) == 7);
+    TEST_CHECK(list_get(l, 0) == -5);
+    for (j = 1; j < n; ++j)
+        TEST_CHECK(list_get_const(l, j) == expected[j] + 1);
+    TEST_CHECK(list_get_unchecked(l, n) == 7);
+    list_set_unchecked(l, n, 8);
+    list_add_unchecked(l, 9);
+    long value = 0;
+    TEST_CHECK(list_try_get(l, n, &value) == LIST_OK && value == 8);
+    TEST_CHECK(list_try_get(l, n + 1, &value) == LIST_OK && value == 9);
+    TEST_CHECK(list_try_get(l, n + 2, &value) == LIST_INDEX_OUT_OF_RANGE);
+    check_error_status(not_in_error);
+    TEST_CHECK(list_get_ref(l, n + 2) == NULL);
+    check_error_status(in_error);
+    list_set(l, n + 2, 0);
+    check_error_status(in_error);
+
+    check_error_status(not_in_error);
+    free(expected);
+    free_list(l);
+}
+
+
+void test_front_inserts_keep_table_balanced(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+
+    long i = 20000;
+    for (; i >= 0; --i)
+        list_insert(l, 0, i);
+    for (i = 0; i <= 20000; ++i)
+        TEST_CHECK(list_get(l, i) == i);
+    check_structure(l, NULL);
+
+    //No two entries are further than 2*JT_INCREMENT values apart.  
+    lindex e = 1;
+    for (; e < l->jt_count; ++e)
+        TEST_CHECK(l->jump_table[e].start - l->jump_table[e-1].start
+                   <= 2 * JT_INCREMENT + LIST_CHUNK_CAPACITY);
+
+    for (i = 0; i < 20000; ++i)
+        TEST_CHECK(list_remove(l, 0) == i);
+    TEST_CHECK(list_size(l) == 1);
+    TEST_CHECK(l->jt_count == 1);
+    check_structure(l, NULL);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+
+void test_sort(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 100000; ++i)
+        list_add(l, rand() % 1000);
+
+    sort_list(l);
+    check_structure(l, NULL);
+    long prev = list_get(l, 0);
+    for (i = 1; i < 100000; ++i)
+    {
+        long value = list_get(l, i);
+        TEST_CHECK(prev <= value);
+        prev = value;
+    }
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+
+void test_where_and_split_where(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 10001; ++i)
+        list_add(l, i);
+
+    list* small = list_where(l, filter1to10);
+    TEST_CHECK(list_size(small) == 10);
+    for (i = 0; i < 10; ++i)
+        TEST_CHECK(list_get(small, i) == i + 1);
+    free_list(small);
+
+    list* evens = list_split_where(l, is_even);
+    TEST_CHECK(list_size(evens) == 5001);
+    TEST_CHECK(list_size(l) == 5000);
+    check_structure(l, NULL);
+    check_structure(evens, NULL);
+    for (i = 0; i < 5000; ++i)
+    {
+        TEST_CHECK(list_get(evens, i) == 2 * i);
+        TEST_CHECK(list_get(l, i) == 2 * i + 1);
+    }
+
+    list* none = list_split_where(evens, is_even);
+    TEST_CHECK(list_size(evens) == 0);
+    TEST_CHECK(evens->head == NULL);
+    TEST_CHECK(list_size(none) == 5001);
+
+    list_remove_where(none, filter1to10);
+    TEST_CHECK(list_size(none) == 4996);
+    TEST_CHECK(list_get(none, 1) == 12);
+    list_retain(none, filter1to10);
+    TEST_CHECK(list_size(none) == 0);
+    list_retain(l, filter1to10);
+    TEST_CHECK(list_size(l) == 5);
+    check_structure(l, (const long[]){1, 3, 5, 7, 9});
+
+    check_error_status(not_in_error);
+    free_list(none);
+    free_list(evens);
+    free_list(l);
+}
+
+
+void test_split_and_merge(void)
+{
+    list_error_handler(error_handler);
+    list* l = new_list();
+    long i = 0;
+    for (; i < 10000; ++i)
+        list_add(l, i);
+
+    //Split in the middle of a chunk.  
+    list* second = list_split(l, 5005);
+    TEST_CHECK(list_size(l) == 5005);
+    TEST_CHECK(list_size(second) == 4995);
+    check_structure(l, NULL);
+    check_structure(second, NULL);
+    for (i = 0; i < 4995; ++i)
+        TEST_CHECK(list_get(second, i) == i + 5005);
+
+    list* third = list_split(second, 1);
+    TEST_CHECK(list_size(second) == 1);
+    TEST_CHECK(list_get(third, 0) == 5006);
+
+    list_merge(second, third);
+    list_merge(l, second);
+    TEST_CHECK(list_size(l) == 10000);
+    check_structure(l, NULL);
+    for (i = 0; i < 10000; ++i)
+        TEST_CHECK(list_get(l, i) == i);
+
+    list* empty = list_split(l, 0);
+    TEST_CHECK(list_size(empty) == 0);
+    TEST_CHECK(list_split(l, 10000) == NULL);
+    check_error_status(in_error);
+
+    list_merge(empty, l);
+    TEST_CHECK(list_size(empty) == 10000);
+    check_structure(empty, NULL);
+
+    free_list(empty);
+}
+
+
+void test_ranges_and_copies(void)
+{
+    list_error_handler(error_handler);
+    long expected[1000];
+    long i = 0;
+    for (; i < 1000; ++i)
+        expected[i] = i;
+    list* l = array_as_list(expected, 1000);
+    check_structure(l, expected);
+
+    list* copy = copy_list(l);
+    check_structure(copy, expected);
+    long* arr = list_as_array(copy);
+    for (i = 0; i < 1000; ++i)
+        TEST_CHECK(arr[i] == i);
+    free(arr);
+
+    //Move [100, 300) of 'l' to the end of 'moved'.  
+    list* moved = new_list();
+    list_add_range(l, moved, 100, 300);
+    check_structure(moved, expected + 100);
+    TEST_CHECK(list_size(l) == 800);
+    TEST_CHECK(list_get(l, 100) == 300);
+
+    list_copy_range(copy, moved, 0, 100);
+    TEST_CHECK(list_size(moved) == 300);
+    TEST_CHECK(list_get(moved, 200) == 0);
+    TEST_CHECK(list_size(copy) == 1000);
+
+    list_remove_range(copy, 10, 990);
+    TEST_CHECK(list_size(copy) == 20);
+    TEST_CHECK(list_get(copy, 10) == 990);
+    check_structure(copy, NULL);
+
+    list_add_range(l, moved, 0, 801);
+    check_error_status(in_error);
+    list_remove_range(l, 5, 4);
+    check_error_status(in_error);
+    list_copy_range(l, moved, 0, 0);
+    TEST_CHECK(list_size(moved) == 300);
+
+    check_error_status(not_in_error);
+    free_list(l);
+    free_list(copy);
+    free_list(moved);
+}
+
+
+void test_random_ranges(void)
+{
+    list_error_handler(error_handler);
+    long* expected = (long*)malloc(200000 * sizeof(long));
+    lindex n = 0;
+    for (; n < 20000; ++n)
+        expected[n] = (long)n;
+    list* l = array_as_list(expected, n);
+    check_structure(l, expected);
+
+    //Ranges of every length, at any offset within the chunks or jump_table
+    //gaps they start and end in.  
+    int i = 0;
+    for (; i < 300; ++i)
+    {
+        lindex start = rand() % (n + 1);
+        lindex end = start + rand() % (i % 3 ? 40 : n - start + 1);
+        if (end > n)
+            end = n;
+        if (n > 0)
+            list_get(l, rand() % n);
+
+        if (i % 3 == 0)
+        {
+            list_remove_range(l, start, end);
+            memmove(&expected[start], &expected[end], (n - end) * sizeof(long));
+            n -= end - start;
+        }
+        else if (i % 3 == 1)
+        {
+            //A list's own range is copied onto its end.  
+            list_copy_range(l, l, start, end);
+            memcpy(&expected[n], &expected[start], (end - start) * sizeof(long));
+            n += end - start;
+        }
+        else
+        {
+            list* moved = new_list();
+            list_add(moved, -1);
+            list_add_range(l, moved, start, end);
+            TEST_CHECK(list_size(moved) == end - start + 1);
+            check_structure(moved, NULL);
+            list_merge(l, moved);
+            long* range = (long*)malloc((end - start + 1) * sizeof(long));
+            memcpy(range, &expected[start], (end - start) * sizeof(long));
+            memmove(&expected[start], &expected[end], (n - end) * sizeof(long));
+            n -= end - start;
+            expected[n++] = -1;
+            memcpy(&expected[n], range, (end - start) * sizeof(long));
+            n += end - start;
+            free(range);
+        }
+        TEST_CHECK(list_size(l) == n);
+        check_structure(l, expected);
+    }
+
+    list* copy = copy_list(l);
+    check_structure(copy, expected);
+    list_remove_range(copy, 0, n);
+    TEST_CHECK(list_size(copy) == 0);
+    check_structure(copy, NULL);
+    list_add(copy, 1);
+    TEST_CHECK(list_get(copy, 0) == 1);
+
+    check_error_status(not_in_error);
+    free(expected);
+    free_list(copy);
+    free_list(l);
+}
+
+
+void test_retain_and_remove_where(void)
+{
+    list_error_handler(error_handler);
+    long* expected = (long*)malloc(20000 * sizeof(long));
+    lindex n = 0;
+    for (; n < 20000; ++n)
+        expected[n] = rand() % 100;
+    list* l = array_as_list(expected, n);
+    list_get(l, 15000);
+
+    //Values are kept in order and the list is indexed again.  
+    list_retain(l, filter1to10);
+    lindex i = 0, kept = 0;
+    for (; i < n; ++i)
+        if (filter1to10(expected[i]))
+            expected[kept++] = expected[i];
+    n = kept;
+    TEST_CHECK(list_size(l) == n);
+    check_structure(l, expected);
+
+    list_remove_where(l, is_even);
+    for (i = 0, kept = 0; i < n; ++i)
+        if (!is_even(expected[i]))
+            expected[kept++] = expected[i];
+    n = kept;
+    TEST_CHECK(list_size(l) == n);
+    check_structure(l, expected);
+    for (i = 0; i < n; ++i)
+        TEST_CHECK(list_get(l, i) == expected[i]);
+
+    //Nothing, then everything, is removed.  
+    list_remove_where(l, is_even);
+    TEST_CHECK(list_size(l) == n);
+    check_structure(l, expected);
+    list_retain(l, is_even);
+    TEST_CHECK(list_size(l) == 0);
+    check_structure(l, NULL);
+    list_add(l, 3);
+    TEST_CHECK(list_get(l, 0) == 3);
+
+    check_error_status(not_in_error);
+    free(expected);
+    free_list(l);
+}
+
+
+
+void test_retain_partial_chunks(void)
+{
+    list_error_handler(error_handler);
+    long expected[40];
+    long i = 0;
+    list* l = new_list();
+    for (; i < 40; ++i)
+        list_add(l, i);
+    for (i = 0; i < 39; ++i)
+        expected[i] = i < 5 ? i : i + 1;
+
+    //The first chunk is no longer full, so the kept values move forward.  
+    TEST_CHECK(list_remove(l, 5) == 5);
+    list_remove_where(l, is_negative);
+    TEST_CHECK(list_size(l) == 39);
+    check_structure(l, expected);
+    for (i = 0; i < 39; ++i)
+        TEST_CHECK(list_get(l, i) == expected[i]);
+
+    TEST_CHECK(list_remove(l, 20) == 21);
+    memmove(&expected[20], &expected[21], 18 * sizeof(long));
+    list_retain(l, filter1to10);
+    list_retain(l, filter1to10);
+    TEST_CHECK(list_size(l) == 9);
+    check_structure(l, expected + 1);
+
+    check_error_status(not_in_error);
+    free_list(l);
+}
+
+TEST_LIST = {
+    {"New list has correct intial values", test_new_list_intial_values},
+    {"API functions have null list checks", test_api_null_checks},
+    {"Add, get and pop", test_add_get_pop},
+    {"Random inserts and removes", test_random_insert_remove},
+    {"Front inserts keep the jump table balanced", test_front_inserts_keep_table_balanced},
+    {"Sorting", test_sort},
+    {"Where and split where", test_where_and_split_where},
+    {"Split and merge", test_split_and_merge},
+    {"Ranges and copies", test_ranges_and_copies},
+    {"Random range moves, copies and removes", test_random_ranges},
+    {"Retain and remove where", test_retain_and_remove_where},
+    {"Retain and remove where with partly filled chunks", test_retain_partial_chunks},
+    {NULL, NULL}
+};